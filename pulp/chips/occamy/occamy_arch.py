@@ -26,6 +26,7 @@ class OccamyArchProperties:
         self.hbm_size                = 0x80000000
         self.hbm_type                = 'simple'
         self.core_type                = 'accurate'
+        self.sequencer_depth          = 16
 
 
     def declare_target_properties(self, target):
@@ -55,6 +56,10 @@ class OccamyArchProperties:
                     name='core_type', value=self.core_type, allowed_values=['accurate', 'fast'], description='Type of the snitch model'
         )
 
+        self.sequencer_depth = target.declare_user_property(
+            name='soc/quadrant/cluster/sequencer_depth', value=self.sequencer_depth, cast=int, description='Number of entries of the FPU sequence buffers'
+        )
+
 
 
 class OccamyArch:
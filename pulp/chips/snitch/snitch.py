@@ -37,6 +37,7 @@ class SnitchArchProperties:
         self.hbm_type                = 'simple'
         self.noc_type                = 'simple'
         self.core_type                = 'accurate'
+        self.sequencer_depth          = 16
 
 
     def declare_target_properties(self, target):
@@ -66,6 +67,10 @@ class SnitchArchProperties:
             name='core_type', value=self.core_type, allowed_values=['accurate', 'fast'], description='Type of the snitch model'
         )
 
+        self.sequencer_depth = target.declare_user_property(
+            name='soc/cluster/sequencer_depth', value=self.sequencer_depth, cast=int, description='Number of entries of the FPU sequence buffers'
+        )
+
 
 class SnitchArch:
 
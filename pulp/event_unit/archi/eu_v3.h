@@ -89,6 +89,10 @@
 #define EU_CORE_TRIGG_SW_EVENT_WAIT_CLEAR      0x80
 #define EU_CORE_TRIGG_SW_EVENT_WAIT_CLEAR_SIZE 0x40
 
+// Window of 32 cores seen by the 32-bit core mask registers, for clusters with more than 32 cores.
+// Only accessible through the demux, the window is selected per core.
+#define EU_CORE_MASK_WINDOW                    0xC0
+
 #define EU_CORE_MASK_SEC_IRQ                   0x40
 
 // ROM area
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+#ifndef __PULP_EVENT_UNIT_EU_CORE_MASK_HPP__
+#define __PULP_EVENT_UNIT_EU_CORE_MASK_HPP__
+
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+
+// Set of cores, stored as 64-bit words so that any number of cores is supported.
+// The 32-bit registers see it through windows of 32 cores. As with the original 32-bit masks,
+// bits of cores which do not exist can be set, they are just never matched.
+class Eu_core_mask
+{
+public:
+  void init(int nb_core) { words.assign((nb_core + 63) / 64, 0); }
+  void clear() { std::fill(words.begin(), words.end(), 0); }
+  void set_all();
+  void set(int core) { words[core >> 6] |= 1ULL << (core & 63); }
+  void reset(int core) { words[core >> 6] &= ~(1ULL << (core & 63)); }
+  bool test(int core) const { return (words[core >> 6] >> (core & 63)) & 1; }
+  bool any() const;
+  int find_first() const;
+  bool operator==(const Eu_core_mask &other) const { return words == other.words; }
+  Eu_core_mask &operator|=(const Eu_core_mask &other);
+  uint32_t get_window(int window) const;
+  void set_window(int window, uint32_t value);
+  void or_window(int window, uint32_t value);
+
+  // Call f for each core of the set, in increasing order. The set can be modified by f.
+  template<typename F> void for_each(F f) const
+  {
+    for (unsigned int i=0; i<words.size(); i++)
+    {
+      uint64_t bits = words[i];
+      while (bits)
+      {
+        int bit = __builtin_ctzll(bits);
+        bits &= bits - 1;
+        f(i * 64 + bit);
+      }
+    }
+  }
+
+private:
+  std::vector<uint64_t> words;
+};
+
+
+inline void Eu_core_mask::set_all()
+{
+  std::fill(words.begin(), words.end(), ~0ULL);
+}
+
+inline bool Eu_core_mask::any() const
+{
+  for (uint64_t word: words)
+  {
+    if (word) return true;
+  }
+  return false;
+}
+
+inline int Eu_core_mask::find_first() const
+{
+  for (unsigned int i=0; i<words.size(); i++)
+  {
+    if (words[i]) return i * 64 + __builtin_ctzll(words[i]);
+  }
+  return -1;
+}
+
+inline Eu_core_mask &Eu_core_mask::operator|=(const Eu_core_mask &other)
+{
+  for (unsigned int i=0; i<words.size(); i++)
+  {
+    words[i] |= other.words[i];
+  }
+  return *this;
+}
+
+inline uint32_t Eu_core_mask::get_window(int window) const
+{
+  unsigned int index = window >> 1;
+  if (index >= words.size()) return 0;
+  return words[index] >> ((window & 1) * 32);
+}
+
+inline void Eu_core_mask::set_window(int window, uint32_t value)
+{
+  unsigned int index = window >> 1;
+  if (index >= words.size()) return;
+  int shift = (window & 1) * 32;
+  words[index] = (words[index] & ~(0xffffffffULL << shift)) | ((uint64_t)value << shift);
+}
+
+inline void Eu_core_mask::or_window(int window, uint32_t value)
+{
+  unsigned int index = window >> 1;
+  if (index >= words.size()) return;
+  words[index] |= (uint64_t)value << ((window & 1) * 32);
+}
+
+#endif
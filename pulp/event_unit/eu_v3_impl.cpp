@@ -24,7 +24,12 @@
 #include <vp/itf/wire.hpp>
 #include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
+#include <vector>
+#include <deque>
+#include <algorithm>
 #include "archi/eu_v3.h"
+#include "eu_core_mask.hpp"
 
 class Core_event_unit;
 class Event_unit;
@@ -75,13 +80,14 @@ private:
 
 class Mutex {
 public:
+  void build(int nb_core);
   void reset();
 
   //Plp3_ckg *top;
   bool locked;
-  uint32_t waiting_mask;
+  Eu_core_mask waiting_mask;
   uint32_t value;
-  vp::IoReq *waiting_reqs[32];
+  std::vector<vp::IoReq *> waiting_reqs;
   //void sleepCancel(int coreId);
   //function<void (int)> sleepCancelCallback;
 };
@@ -112,10 +118,10 @@ public:
   //Plp3_ckg *top;
   //DispatchUnit *dispatch;
   uint32_t value;
-  uint32_t status_mask;     // Cores that must get the value before it can be written again
-  uint32_t config_mask;     // Cores that will get a valid value
-  uint32_t waiting_mask;
-  vp::IoReq *waiting_reqs[32];
+  Eu_core_mask status_mask;     // Cores that must get the value before it can be written again
+  Eu_core_mask config_mask;     // Cores that will get a valid value
+  Eu_core_mask waiting_mask;
+  std::vector<vp::IoReq *> waiting_reqs;
 //
 //  //gv::ioSlave_ioReq stallRetryCallbackPtr;
 //  //function<void (int)> sleepCancelCallback;
@@ -129,6 +135,7 @@ class Dispatch_core
 {
 public:
   int tail;
+  int64_t sleep_start;    // Cycle at which the core went to sleep waiting for a value
 };
 
 
@@ -138,6 +145,7 @@ public:
 
   vp::IoReqStatus req(vp::IoReq *req, uint64_t offset, bool is_write, uint32_t *data, int core);
   void reset();
+  void dump_stats();
 
   vp::IoReqStatus enqueue_sleep(Dispatch *dispatch, vp::IoReq *req, int core_id, bool is_caller=true);
 
@@ -146,7 +154,7 @@ public:
   //Dispatch *dispatches;
   //unsigned int globalFifoId;
   //unsigned int fifoId[32];
-  unsigned int config;
+  Eu_core_mask config;
   //unsigned int teamConfig;
   //bool ioReq(gv::ioReq *req, uint32_t offset, bool isRead, uint32_t *data, int coreId);
   int dispatch_event;
@@ -156,15 +164,31 @@ private:
   Dispatch *dispatches;
   int size;
   int fifo_head;
+
+  void push(uint32_t value);
+  bool is_busy(Dispatch *dispatch);
+  void check_pending_pushes();
+
+  // When set, a push to an entry which has not been read by all the cores of its team stalls
+  // the master instead of overwriting it
+  bool stall_on_full;
+  std::deque<std::pair<vp::IoReq *, uint32_t>> pending_pushes;
+
+  int64_t nb_pushes;
+  int64_t nb_push_stalls;
+  int64_t nb_overwrites;
+  int64_t nb_reads;
+  int64_t nb_sleeps;
+  int64_t nb_sleep_cycles;
 };
 
 
 
 class Barrier {
 public:
-  uint32_t core_mask;
-  uint32_t status;
-  uint32_t target_mask;
+  Eu_core_mask core_mask;
+  Eu_core_mask status;
+  Eu_core_mask target_mask;
 };
 
 
@@ -174,15 +198,29 @@ public:
 
   vp::IoReqStatus req(vp::IoReq *req, uint64_t offset, bool is_write, uint32_t *data, int core);
   void reset();
+  void dump_stats();
 
 private:
   void check_barrier(int barrier_id);
+  void trigger_fast(Eu_core_mask &target_mask);
+  static void wakeup_handler(vp::Block *__this, vp::ClockEvent *event);
 
   Event_unit *top;
   vp::Trace     trace;
   Barrier *barriers;
   int nb_barriers;
   int barrier_event;
+
+  // Fast path, cores sleeping on a barrier are all waken-up by this single event
+  bool fast;
+  vp::ClockEvent *wakeup_event;
+  Eu_core_mask wakeup_mask;
+  int64_t wakeup_cycle;
+
+  int64_t nb_reached;
+  int64_t nb_core_wakeups;
+  int64_t nb_batched_wakeups;
+  int64_t nb_wakeup_events;
 };
 
 
@@ -208,6 +246,7 @@ public:
   Event_unit(vp::ComponentConf &config);
 
   void reset(bool active);
+  void stop();
 
   static vp::IoReqStatus req(vp::Block *__this, vp::IoReq *req);
   static vp::IoReqStatus demux_req(vp::Block *__this, vp::IoReq *req, int core);
@@ -227,10 +266,17 @@ protected:
 
   int nb_core;
 
+  vp::Trace     stats_trace;  // End-of-simulation counters, dumped by stop() when active
+
 
-  vp::IoReqStatus sw_events_req(vp::IoReq *req, uint64_t offset, bool is_write, uint32_t *data);
-  void trigger_event(int event, uint32_t core_mask);
+  vp::IoReqStatus sw_events_req(vp::IoReq *req, uint64_t offset, bool is_write, uint32_t *data, int core=-1);
+  void trigger_event(int event_mask, Eu_core_mask &core_mask);
+  void trigger_event_all(int event_mask);
   void send_event(int core, uint32_t mask);
+  int get_mask_window(int core);
+
+  // Temporary mask used to convert 32-bit register accesses
+  Eu_core_mask reg_mask;
   static void in_event_sync(vp::Block *__this, bool active, int id);
 
 };
@@ -253,8 +299,11 @@ public:
   vp::IoReqStatus wait_event(vp::IoReq *req, Event_unit_core_state_e wait_state=CORE_STATE_WAITING_EVENT);
   vp::IoReqStatus put_to_sleep(vp::IoReq *req, Event_unit_core_state_e wait_state=CORE_STATE_WAITING_EVENT);
   Event_unit_core_state_e get_state() { return state; }
+  bool get_active() { return is_active.get(); }
   void set_state(Event_unit_core_state_e state) { this->state = state; }
   void irq_ack_sync(int irq, int core);
+  bool prepare_barrier_wakeup(uint32_t event_mask);
+  void wakeup();
   static void wakeup_handler(vp::Block *__this, vp::ClockEvent *event);
   static void irq_wakeup_handler(vp::Block *__this, vp::ClockEvent *event);
 
@@ -267,6 +316,7 @@ public:
 
   int sync_irq;
   int pending_elw;
+  int mask_window;
 
 private:
   Event_unit *top;
@@ -297,10 +347,13 @@ Event_unit::Event_unit(vp::ComponentConf &config)
   nb_core = get_js_config()->get_child_int("nb_core");
 
   traces.new_trace("trace", &trace, vp::DEBUG);
+  traces.new_trace("stats", &stats_trace, vp::DEBUG);
 
   in.set_req_meth(&Event_unit::req);
   new_slave_port("input", &in);
 
+  reg_mask.init(nb_core);
+
   core_eu = (Core_event_unit *)new Core_event_unit[nb_core];
   mutex = new Mutex_unit(this);
   dispatch = new Dispatch_unit(this);
@@ -329,6 +382,15 @@ void Event_unit::reset(bool active)
   }
 }
 
+void Event_unit::stop()
+{
+  if (stats_trace.get_active())
+  {
+    barrier_unit->dump_stats();
+    dispatch->dump_stats();
+  }
+}
+
 vp::IoReqStatus Event_unit::req(vp::Block *__this, vp::IoReq *req)
 {
   Event_unit *_this = (Event_unit *)__this;
@@ -376,15 +438,39 @@ vp::IoReqStatus Event_unit::req(vp::Block *__this, vp::IoReq *req)
 
 
 
-vp::IoReqStatus Event_unit::sw_events_req(vp::IoReq *req, uint64_t offset, bool is_write, uint32_t *data)
+vp::IoReqStatus Event_unit::sw_events_req(vp::IoReq *req, uint64_t offset, bool is_write, uint32_t *data, int core)
 {
   if (offset >= EU_CORE_TRIGG_SW_EVENT && offset <  EU_CORE_TRIGG_SW_EVENT_SIZE)
   {
     if (!is_write) return vp::IO_REQ_INVALID;
 
     int event = (offset - EU_CORE_TRIGG_SW_EVENT) >> 2;
-    trace.msg("SW event trigger (event: %d, coreMask: 0x%x)\n", event, *data);
-    trigger_event(1<<event, *data);
+    int window = get_mask_window(core);
+    trace.msg("SW event trigger (event: %d, coreMask: 0x%x, window: %d)\n", event, *data, window);
+
+    // As for the original 32-bit register, an empty mask means all cores
+    if (*data == 0)
+    {
+      trigger_event_all(1<<event);
+    }
+    else
+    {
+      reg_mask.clear();
+      reg_mask.set_window(window, *data);
+      trigger_event(1<<event, reg_mask);
+    }
+  }
+  else if (offset == EU_CORE_MASK_WINDOW)
+  {
+    // The access is valid only through the demux
+    if (core == -1) return vp::IO_REQ_INVALID;
+
+    if (!is_write) *data = core_eu[core].mask_window;
+    else
+    {
+      trace.msg("Setting core mask window (core: %d, window: %d)\n", core, *data);
+      core_eu[core].mask_window = *data;
+    }
   }
   else if (offset >= EU_CORE_TRIGG_SW_EVENT_WAIT && offset <  EU_CORE_TRIGG_SW_EVENT_WAIT_SIZE)
   {
@@ -429,15 +515,27 @@ vp::IoReqStatus Event_unit::sw_events_req(vp::IoReq *req, uint64_t offset, bool
 }
 
 
-void Event_unit::trigger_event(int event_mask, uint32_t core_mask)
+void Event_unit::trigger_event(int event_mask, Eu_core_mask &core_mask)
 {
-  for (unsigned int i=0; i<nb_core; i++) {
-    if (core_mask == 0 || (core_mask & (1 << i))) {
-      send_event(i, event_mask);
-    }
+  core_mask.for_each([this, event_mask](int core)
+  {
+    if (core < this->nb_core) this->send_event(core, event_mask);
+  });
+}
+
+void Event_unit::trigger_event_all(int event_mask)
+{
+  for (int i=0; i<nb_core; i++)
+  {
+    send_event(i, event_mask);
   }
 }
 
+int Event_unit::get_mask_window(int core)
+{
+  return core == -1 ? 0 : core_eu[core].mask_window;
+}
+
 void Event_unit::send_event(int core, uint32_t mask)
 {
   trace.msg("Triggering event (core: %d, mask: 0x%x)\n", core, mask);
@@ -635,7 +733,7 @@ vp::IoReqStatus Event_unit::demux_req(vp::Block *__this, vp::IoReq *req, int cor
   }
   else if (offset >= EU_SW_EVENTS_DEMUX_OFFSET && offset < EU_SW_EVENTS_DEMUX_OFFSET + EU_SW_EVENTS_DEMUX_SIZE)
   {
-    return _this->sw_events_req(req, offset - EU_SW_EVENTS_DEMUX_OFFSET, is_write, (uint32_t *)data);
+    return _this->sw_events_req(req, offset - EU_SW_EVENTS_DEMUX_OFFSET, is_write, (uint32_t *)data, core);
   }
   else if (offset >= EU_BARRIER_DEMUX_OFFSET && offset < EU_BARRIER_DEMUX_OFFSET + EU_BARRIER_DEMUX_SIZE)
   {
@@ -657,7 +755,6 @@ void Event_unit::in_event_sync(vp::Block *__this, bool active, int id)
 }
 
 
-
 extern "C" vp::Component *gv_new(vp::ComponentConf &config)
 {
   return new Event_unit(config);
@@ -900,6 +997,7 @@ void Core_event_unit::reset()
   clear_evt_mask = 0;
   sync_irq = -1;
   pending_elw = false;
+  mask_window = 0;
   state = CORE_STATE_NONE;
   this->clock_itf.sync(1);
 }
@@ -907,11 +1005,34 @@ void Core_event_unit::reset()
 void Core_event_unit::wakeup_handler(vp::Block *__this, vp::ClockEvent *event)
 {
   Core_event_unit *_this = (Core_event_unit *)__this;
-  _this->top->trace.msg("Replying to core after wakeup (core: %d)\n", _this->core_id);
-  _this->is_active.set(1);
-  _this->clock_itf.sync(1);
-  _this->check_pending_req();
-  _this->check_state();
+  _this->wakeup();
+}
+
+void Core_event_unit::wakeup()
+{
+  top->trace.msg("Replying to core after wakeup (core: %d)\n", core_id);
+  is_active.set(1);
+  clock_itf.sync(1);
+  check_pending_req();
+  check_state();
+}
+
+// Set the event and prepare the wake-up of a core sleeping on a barrier, exactly as check_state
+// would do, except that the wake-up itself is left to the caller. Returns false if the core is
+// in any other situation, in which case the generic path must be used.
+bool Core_event_unit::prepare_barrier_wakeup(uint32_t event_mask)
+{
+  if (is_active.get() || pending_elw || state != CORE_STATE_WAITING_BARRIER ||
+    !(evt_mask & event_mask) || wakeup_event->is_enqueued())
+  {
+    return false;
+  }
+
+  set_status(status | event_mask);
+  top->trace.msg("Activating clock (core: %d)\n", core_id);
+  state = CORE_STATE_NONE;
+  check_wait_mask();
+  return true;
 }
 
 void Core_event_unit::irq_wakeup_handler(vp::Block *__this, vp::ClockEvent *event)
@@ -1004,6 +1125,10 @@ Mutex_unit::Mutex_unit(Event_unit *top)
   nb_mutexes = top->get_js_config()->get_child_int("**/properties/mutex/nb_mutexes");
   mutex_event = top->get_js_config()->get_child_int("**/properties/events/mutex");
   mutexes = new Mutex[nb_mutexes];
+  for (int i=0; i<nb_mutexes; i++)
+  {
+    mutexes[i].build(top->nb_core);
+  }
 }
 
 
@@ -1012,7 +1137,7 @@ vp::IoReqStatus Mutex_unit::enqueue_sleep(Mutex *mutex, vp::IoReq *req, int core
 
   // Enqueue the request so that the core can be unstalled when a value is pushed
   mutex->waiting_reqs[core_id] = req;
-  mutex->waiting_mask |= 1<<core_id;
+  mutex->waiting_mask.set(core_id);
 
   // Don't forget to remember to clear the event after wake-up by the dispatch event
   core_eu->clear_evt_mask = 1<<mutex_event;
@@ -1029,10 +1154,16 @@ void Mutex_unit::reset()
   }
 }
 
+void Mutex::build(int nb_core)
+{
+  waiting_mask.init(nb_core);
+  waiting_reqs.resize(nb_core);
+}
+
 void Mutex::reset()
 {
   locked = false;
-  waiting_mask = 0;
+  waiting_mask.clear();
 }
 
 
@@ -1078,33 +1209,25 @@ vp::IoReqStatus Mutex_unit::req(vp::IoReq *req, uint64_t offset, bool is_write,
     mutex->value = *(uint32_t *)req->get_data();
 
     // The core is unlocking the mutex, check if we have to wake-up someone
-    unsigned int waiting_mask = mutex->waiting_mask;
-    if (waiting_mask)
+    // We have to wake-up one core, take the first one
+    int i = mutex->waiting_mask.find_first();
+    if (i != -1)
     {
-      // We have to wake-up one core, take the first one
-      for (unsigned int i=0; i<32; i++)
-      {
-        if (waiting_mask & (1<<i))
-        {
-          top->trace.msg("Transfering mutex lock (mutex: %d, fromCore: %d, toCore: %d)\n", id, core, i);
-          // Clear the mask and wake-up the elected core. Don't unlock the mutex, as it is
-          // taken by the new core
-          top->trace.msg("Waking-up core waiting for dispatch value (coreId: %d)\n", i);
-          vp::IoReq *waiting_req = mutex->waiting_reqs[i];
+      top->trace.msg("Transfering mutex lock (mutex: %d, fromCore: %d, toCore: %d)\n", id, core, i);
+      // Clear the mask and wake-up the elected core. Don't unlock the mutex, as it is
+      // taken by the new core
+      top->trace.msg("Waking-up core waiting for dispatch value (coreId: %d)\n", i);
+      vp::IoReq *waiting_req = mutex->waiting_reqs[i];
 
-          mutex->waiting_mask &= ~(1<<i);
+      mutex->waiting_mask.reset(i);
 
-          // Store the mutex value into the pending request
-          // Don't reply now to the initiator, this will be done by the wakeup event
-          // to introduce some delays
-          *(uint32_t *)waiting_req->get_data() = mutex->value;
+      // Store the mutex value into the pending request
+      // Don't reply now to the initiator, this will be done by the wakeup event
+      // to introduce some delays
+      *(uint32_t *)waiting_req->get_data() = mutex->value;
 
-          // And trigger the event to the core
-          top->trigger_event(1<<mutex_event, 1<<i); 
-
-          break;
-        }
-      }
+      // And trigger the event to the core
+      top->send_event(i, 1<<mutex_event);
     } 
     else
     {
@@ -1129,13 +1252,17 @@ vp::IoReqStatus Dispatch_unit::enqueue_sleep(Dispatch *dispatch, vp::IoReq *req,
 
   // Enqueue the request so that the core can be unstalled when a value is pushed
   dispatch->waiting_reqs[core_id] = req;
-  dispatch->waiting_mask |= 1<<core_id;
+  dispatch->waiting_mask.set(core_id);
 
   // Don't forget to remember to clear the event after wake-up by the dispatch event
   core_eu->clear_evt_mask = 1<<dispatch_event;
 
   if (is_caller)
+  {
+    nb_sleeps++;
+    core[core_id].sleep_start = top->clock.get_cycles();
     return core_eu->wait_event(req);
+  }
   else
     return core_eu->put_to_sleep(req);
 }
@@ -1147,14 +1274,30 @@ Dispatch_unit::Dispatch_unit(Event_unit *top)
 {
   dispatch_event = top->get_js_config()->get_child_int("**/properties/events/dispatch");
   size = top->get_js_config()->get_child_int("**/properties/dispatch/size");
+  stall_on_full = top->get_js_config()->get_child_bool("dispatch_stall_on_full");
   core = new Dispatch_core[top->nb_core];
   dispatches = new Dispatch[size];
+  config.init(top->nb_core);
+  for (int i=0; i<size; i++)
+  {
+    dispatches[i].status_mask.init(top->nb_core);
+    dispatches[i].config_mask.init(top->nb_core);
+    dispatches[i].waiting_mask.init(top->nb_core);
+    dispatches[i].waiting_reqs.resize(top->nb_core);
+  }
 }
 
   void Dispatch_unit::reset()
   {
     fifo_head = 0;
-    config = 0;
+    config.clear();
+    pending_pushes.clear();
+    nb_pushes = 0;
+    nb_push_stalls = 0;
+    nb_overwrites = 0;
+    nb_reads = 0;
+    nb_sleeps = 0;
+    nb_sleep_cycles = 0;
     for (int i=0; i<top->nb_core; i++)
     {
       core[i].tail = 0;
@@ -1162,83 +1305,135 @@ Dispatch_unit::Dispatch_unit(Event_unit *top)
     for (int i=0; i<size; i++)
     {
       dispatches[i].value = 0;
-      dispatches[i].status_mask = 0;
-      dispatches[i].config_mask = 0;
-      dispatches[i].waiting_mask = 0;
+      dispatches[i].status_mask.clear();
+      dispatches[i].config_mask.clear();
+      dispatches[i].waiting_mask.clear();
     }
   }
 
-  vp::IoReqStatus Dispatch_unit::req(vp::IoReq *req, uint64_t offset, bool is_write, uint32_t *data, int core_id)
+  void Dispatch_unit::push(uint32_t value)
   {
-    if (offset == EU_DISPATCH_FIFO_ACCESS)
+    unsigned int id = fifo_head++;
+    if (fifo_head == size) fifo_head = 0;
+
+    Dispatch *dispatch = &dispatches[id];
+
+    // When pushing to the FIFO, the global config is pushed to the elected dispatcher
+    dispatch->config_mask = config;     // Cores that will get a valid value
+
+    top->trace.msg("Pushing dispatch value (dispatch: %d, value: 0x%x, coreMask: 0x%x)\n", id, value, dispatch->config_mask.get_window(0));
+
+    // Case where the master push a value
+    dispatch->value = value;
+    // Reinitialize the status mask to notify a new value is ready
+    dispatch->status_mask.set_all();
+    nb_pushes++;
+
+    // Then wake-up the waiting cores. The waiting mask is copied as the cores which are not
+    // in the team enqueue themselves to the next entry, which is this one with a 1-entry FIFO
+    int64_t cycles = top->clock.get_cycles();
+    Eu_core_mask mask = dispatch->waiting_mask;
+    mask.for_each([this, dispatch, cycles](int i)
     {
-      if (is_write)
+      // Only wake-up the core if he's actually involved in the team
+      if (dispatch->config_mask.test(i))
       {
-        unsigned int id = fifo_head++;
-        if (fifo_head == size) fifo_head = 0;
+        top->trace.msg("Waking-up core waiting for dispatch value (coreId: %d)\n", i);
+        vp::IoReq *waiting_req = dispatch->waiting_reqs[i];
 
-        Dispatch *dispatch = &dispatches[id];
+        // Clear the status bit as the waking core takes the data
+        dispatch->status_mask.reset(i);
+        dispatch->waiting_mask.reset(i);
+
+        // Store the dispatch value into the pending request
+        // Don't reply now to the initiator, this will be done by the wakeup event
+        // to introduce some delays
+        *(uint32_t *)waiting_req->get_data() = dispatch->value;
+
+        // Update the core fifo
+        core[i].tail++;
+        if (core[i].tail == size) core[i].tail = 0;
 
-        // When pushing to the FIFO, the global config is pushed to the elected dispatcher
-        dispatch->config_mask = config;     // Cores that will get a valid value
+        // And trigger the event to the core
+        nb_sleep_cycles += cycles - core[i].sleep_start;
+        top->send_event(i, 1<<dispatch_event);
+      }
+      // Otherwise keep him sleeping and increase its index so that he will bypass this entry when he wakes up
+      else
+      {
+        // Cancel current dispatch sleep
+        dispatch->status_mask.reset(i);
+        dispatch->waiting_mask.reset(i);
+        vp::IoReq *pending_req = dispatch->waiting_reqs[i];
+
+        // Bypass the current entry
+        core[i].tail++;
+        if (core[i].tail == size) core[i].tail = 0;
+
+        // And reenqueue to the next entry
+        int id = core[i].tail;
+        enqueue_sleep(&dispatches[id], pending_req, i, false);
+        top->trace.msg("Incrementing core counter to bypass entry (coreId: %d, newIndex: %d)\n", i, id);
+      }
+    });
+  }
 
-        top->trace.msg("Pushing dispatch value (dispatch: %d, value: 0x%x, coreMask: 0x%x)\n", id, *data, dispatch->config_mask);
+  // A dispatch entry is busy as long as a core of its team has not read it
+  bool Dispatch_unit::is_busy(Dispatch *dispatch)
+  {
+    bool busy = false;
+    dispatch->config_mask.for_each([this, dispatch, &busy](int i)
+    {
+      if (i < top->nb_core && dispatch->status_mask.test(i)) busy = true;
+    });
+    return busy;
+  }
+
+  void Dispatch_unit::check_pending_pushes()
+  {
+    while (!pending_pushes.empty() && !is_busy(&dispatches[fifo_head]))
+    {
+      vp::IoReq *req = pending_pushes.front().first;
+      uint32_t value = pending_pushes.front().second;
+      pending_pushes.pop_front();
+
+      top->trace.msg("Dispatch FIFO entry freed, resuming push\n");
+      push(value);
+      req->get_resp_port()->resp(req);
+    }
+  }
 
-        // Case where the master push a value
-        dispatch->value = *data;
-        // Reinitialize the status mask to notify a new value is ready
-        dispatch->status_mask = -1;
-        // Then wake-up the waiting cores
-        unsigned int mask = dispatch->waiting_mask & dispatch->status_mask;
-        for (int i=0; i<32 && mask; i++)
+  void Dispatch_unit::dump_stats()
+  {
+    top->stats_trace.msg(vp::Trace::LEVEL_INFO, "dispatch: pushes: %" PRId64 " (stalled: %" PRId64 ", overwrites: %" PRId64 "), reads: %" PRId64
+      ", sleeps: %" PRId64 " (%" PRId64 " cycles, %.1f per sleep)\n",
+      nb_pushes, nb_push_stalls, nb_overwrites, nb_reads, nb_sleeps, nb_sleep_cycles,
+      nb_sleeps ? (double)nb_sleep_cycles / nb_sleeps : 0.0);
+  }
+
+  vp::IoReqStatus Dispatch_unit::req(vp::IoReq *req, uint64_t offset, bool is_write, uint32_t *data, int core_id)
+  {
+    if (offset == EU_DISPATCH_FIFO_ACCESS)
+    {
+      if (is_write)
+      {
+        // The FIFO entry is still being consumed by a core of its team
+        if (!pending_pushes.empty() || is_busy(&dispatches[fifo_head]))
         {
-          if (mask & (1<<i))
+          if (stall_on_full)
           {
-            // Only wake-up the core if he's actually involved in the team
-            if (dispatch->config_mask & (1<<i))
-            {
-              top->trace.msg("Waking-up core waiting for dispatch value (coreId: %d)\n", i);
-              vp::IoReq *waiting_req = dispatch->waiting_reqs[i];
-
-              // Clear the status bit as the waking core takes the data
-              dispatch->status_mask &= ~(1<<i);
-              dispatch->waiting_mask &= ~(1<<i);
-
-              // Store the dispatch value into the pending request
-              // Don't reply now to the initiator, this will be done by the wakeup event
-              // to introduce some delays
-              *(uint32_t *)waiting_req->get_data() = dispatch->value;
-
-              // Update the core fifo
-              core[i].tail++;
-              if (core[i].tail == size) core[i].tail = 0;
-
-              // Clear the mask to stop iterating early
-              mask &= ~(1<<i);
-
-              // And trigger the event to the core
-              top->trigger_event(1<<dispatch_event, 1<<i); 
-            }
-            // Otherwise keep him sleeping and increase its index so that he will bypass this entry when he wakes up
-            else
-            {
-              // Cancel current dispatch sleep
-              dispatch->status_mask &= ~(1<<i);
-              dispatch->waiting_mask &= ~(1<<i);
-              vp::IoReq *pending_req = dispatch->waiting_reqs[i];
-
-              // Bypass the current entry
-              core[i].tail++;
-              if (core[i].tail == size) core[i].tail = 0;
-
-              // And reenqueue to the next entry
-              id = core[i].tail;
-              enqueue_sleep(&dispatches[id], pending_req, i, false);
-              top->trace.msg("Incrementing core counter to bypass entry (coreId: %d, newIndex: %d)\n", i, id);
-            }
+            top->trace.msg("Dispatch FIFO is full, stalling core (coreId: %d)\n", core_id);
+            nb_push_stalls++;
+            pending_pushes.push_back(std::make_pair(req, *data));
+            return vp::IO_REQ_PENDING;
           }
+
+          top->trace.msg("Dispatch FIFO is full, overwriting entry (dispatch: %d)\n", fifo_head);
+          nb_overwrites++;
         }
 
+        push(*data);
+
         return vp::IO_REQ_OK;        
       }
       else
@@ -1247,10 +1442,11 @@ Dispatch_unit::Dispatch_unit(Event_unit *top)
         Dispatch *dispatch = &dispatches[id];
 
         top->trace.msg("Trying to get dispatch value (dispatch: %d)\n", id);
+        nb_reads++;
 
         // In case we found ready elements where this core is not involved, bypass them all
-        while ((dispatch->status_mask & (1<<core_id)) && !(dispatch->config_mask & (1<<core_id))) {
-          dispatch->status_mask &= ~(1<<core_id);
+        while (dispatch->status_mask.test(core_id) && !dispatch->config_mask.test(core_id)) {
+          dispatch->status_mask.reset(core_id);
           core[core_id].tail++;
           if (core[core_id].tail == size) core[core_id].tail = 0;
           id = core[core_id].tail;
@@ -1259,24 +1455,27 @@ Dispatch_unit::Dispatch_unit(Event_unit *top)
         }
 
         // Case where a slave tries to get a value
-        if (dispatch->status_mask & (1<<core_id))
+        if (dispatch->status_mask.test(core_id))
         {
           // A value is ready. Get it and clear the status bit to not read it again the next time
           // In case the core is not involved in this dispatch, returns 0
-          if (dispatch->config_mask & (1<<core_id)) *data = dispatch->value;
+          if (dispatch->config_mask.test(core_id)) *data = dispatch->value;
           else *data = 0;
-          dispatch->status_mask &= ~(1<<core_id);
-          top->trace.msg("Getting ready dispatch value (dispatch: %d, value: %x, dispatchStatus: 0x%x)\n", id, dispatch->value, dispatch->status_mask);
+          dispatch->status_mask.reset(core_id);
+          top->trace.msg("Getting ready dispatch value (dispatch: %d, value: %x)\n", id, dispatch->value);
           core[core_id].tail++;
           if (core[core_id].tail == size) core[core_id].tail = 0;
         }
         else
         {
           // Nothing is ready, go to sleep
-          top->trace.msg("No ready dispatch value, going to sleep (dispatch: %d, value: %x, dispatchStatus: 0x%x)\n", id, dispatch->value, dispatch->status_mask);
+          top->trace.msg("No ready dispatch value, going to sleep (dispatch: %d, value: %x)\n", id, dispatch->value);
           return enqueue_sleep(dispatch, req, core_id);
         }
 
+        // The entries read by this core may have freed the one the master is waiting for
+        check_pending_pushes();
+
         return vp::IO_REQ_OK;       
       }
 
@@ -1284,7 +1483,7 @@ Dispatch_unit::Dispatch_unit(Event_unit *top)
     }
     else if (offset == EU_DISPATCH_TEAM_CONFIG)
     {
-      config = *data;
+      config.set_window(top->get_mask_window(core_id), *data);
       return vp::IO_REQ_OK;
     }
     else
@@ -1309,7 +1508,16 @@ Barrier_unit::Barrier_unit(Event_unit *top)
   top->traces.new_trace("barrier/trace", &trace, vp::DEBUG);
   nb_barriers = top->get_js_config()->get_child_int("**/properties/barriers/nb_barriers");
   barrier_event = top->get_js_config()->get_child_int("**/properties/events/barrier");
+  fast = top->get_js_config()->get_child_bool("barrier_fast");
   barriers = new Barrier[nb_barriers];
+  for (int i=0; i<nb_barriers; i++)
+  {
+    barriers[i].core_mask.init(top->nb_core);
+    barriers[i].status.init(top->nb_core);
+    barriers[i].target_mask.init(top->nb_core);
+  }
+  wakeup_mask.init(top->nb_core);
+  wakeup_event = top->event_new((vp::Block *)this, Barrier_unit::wakeup_handler);
 }
 
 void Barrier_unit::check_barrier(int barrier_id)
@@ -1318,11 +1526,92 @@ void Barrier_unit::check_barrier(int barrier_id)
 
   if (barrier->status == barrier->core_mask) 
   {
-    trace.msg("Barrier reached, triggering event (barrier: %d, coreMask: 0x%x, targetMask: 0x%x)\n", barrier_id, barrier->core_mask, barrier->target_mask);
-    barrier->status = 0;
+    trace.msg("Barrier reached, triggering event (barrier: %d, coreMask: 0x%x, targetMask: 0x%x)\n", barrier_id, barrier->core_mask.get_window(0), barrier->target_mask.get_window(0));
+    barrier->status.clear();
+    nb_reached++;
 
-    top->trigger_event(1<<barrier_event, barrier->target_mask);
+    if (fast)
+    {
+      trigger_fast(barrier->target_mask);
+    }
+    else
+    {
+      // Only accounted for comparison with the fast path, each sleeping core gets its own event
+      for (int i=0; i<top->nb_core; i++)
+      {
+        if (!barrier->target_mask.any() || barrier->target_mask.test(i))
+        {
+          nb_core_wakeups++;
+          if (!top->core_eu[i].get_active())
+            nb_wakeup_events++;
+        }
+      }
+
+      if (barrier->target_mask.any())
+        top->trigger_event(1<<barrier_event, barrier->target_mask);
+      else
+        top->trigger_event_all(1<<barrier_event);
+    }
+  }
+}
+
+// Barrier fast path. All the target cores are sleeping on the barrier except the last one to
+// arrive, so instead of scheduling one wake-up event per core, they are all waken-up by the
+// same event. The wake-up latency is the same for all cores, so this gives the same timing.
+// Cores in any other state go through the generic event path.
+void Barrier_unit::trigger_fast(Eu_core_mask &target_mask)
+{
+  uint32_t event_mask = 1<<barrier_event;
+  int64_t cycle = top->clock.get_cycles() + EU_WAKEUP_LATENCY;
+  bool can_batch = !wakeup_event->is_enqueued() || wakeup_cycle == cycle;
+  bool all = !target_mask.any();
+
+  for (int i=0; i<top->nb_core; i++)
+  {
+    if (all || target_mask.test(i))
+    {
+      nb_core_wakeups++;
+
+      if (can_batch && top->core_eu[i].prepare_barrier_wakeup(event_mask))
+      {
+        wakeup_mask.set(i);
+        nb_batched_wakeups++;
+      }
+      else
+      {
+        if (!top->core_eu[i].get_active())
+          nb_wakeup_events++;
+        top->send_event(i, event_mask);
+      }
+    }
   }
+
+  if (wakeup_mask.any() && !wakeup_event->is_enqueued())
+  {
+    wakeup_cycle = cycle;
+    nb_wakeup_events++;
+    top->event_enqueue(wakeup_event, EU_WAKEUP_LATENCY);
+  }
+}
+
+void Barrier_unit::wakeup_handler(vp::Block *__this, vp::ClockEvent *event)
+{
+  Barrier_unit *_this = (Barrier_unit *)__this;
+  Eu_core_mask mask = _this->wakeup_mask;
+
+  _this->trace.msg("Waking-up cores from barrier (mask: 0x%x)\n", mask.get_window(0));
+
+  _this->wakeup_mask.clear();
+
+  mask.for_each([_this](int core) { _this->top->core_eu[core].wakeup(); });
+}
+
+void Barrier_unit::dump_stats()
+{
+  top->stats_trace.msg(vp::Trace::LEVEL_INFO, "barriers: %" PRId64 ", core wake-ups: %" PRId64 " (batched: %" PRId64 "), wake-up events: %" PRId64
+    " (%.2f per barrier)\n",
+    nb_reached, nb_core_wakeups, nb_batched_wakeups, nb_wakeup_events,
+    nb_reached ? (double)nb_wakeup_events / nb_reached : 0.0);
 }
 
 
@@ -1332,32 +1621,34 @@ vp::IoReqStatus Barrier_unit::req(vp::IoReq *req, uint64_t offset, bool is_write
   offset = offset - EU_BARRIER_AREA_OFFSET_GET(barrier_id);
   if (barrier_id >= nb_barriers) return vp::IO_REQ_INVALID;
   Barrier *barrier = &barriers[barrier_id];
+  int window = top->get_mask_window(core);
 
+  // Core masks are accessed through the window of 32 cores selected by the calling core
   if (offset == EU_HW_BARR_TRIGGER_MASK)
   {
-    if (!is_write) *data = barrier->core_mask;
+    if (!is_write) *data = barrier->core_mask.get_window(window);
     else {
-      trace.msg("Setting barrier core mask (barrier: %d, mask: 0x%x)\n", barrier_id, *data);
-      barrier->core_mask = *data;
+      trace.msg("Setting barrier core mask (barrier: %d, mask: 0x%x, window: %d)\n", barrier_id, *data, window);
+      barrier->core_mask.set_window(window, *data);
       check_barrier(barrier_id);
     }
   }
 
   else if (offset == EU_HW_BARR_TARGET_MASK)
   {
-    if (!is_write) *data = barrier->target_mask;
+    if (!is_write) *data = barrier->target_mask.get_window(window);
     else {
-      trace.msg("Setting barrier target mask (barrier: %d, mask: 0x%x)\n", barrier_id, *data);
-      barrier->target_mask = *data;
+      trace.msg("Setting barrier target mask (barrier: %d, mask: 0x%x, window: %d)\n", barrier_id, *data, window);
+      barrier->target_mask.set_window(window, *data);
       check_barrier(barrier_id);
     }
   }
   else if (offset == EU_HW_BARR_STATUS)
   {
-    if (!is_write) *data = barrier->status;
+    if (!is_write) *data = barrier->status.get_window(window);
     else {
-      trace.msg("Setting barrier status (barrier: %d, status: 0x%x)\n", barrier_id, *data);
-      barrier->status = *data;
+      trace.msg("Setting barrier status (barrier: %d, status: 0x%x, window: %d)\n", barrier_id, *data, window);
+      barrier->status.set_window(window, *data);
       check_barrier(barrier_id);
     }
   }
@@ -1365,8 +1656,8 @@ vp::IoReqStatus Barrier_unit::req(vp::IoReq *req, uint64_t offset, bool is_write
   {
     if (!is_write) return vp::IO_REQ_INVALID;
     else {
-      barrier->status |= *data;
-      trace.msg("Barrier mask trigger (barrier: %d, mask: 0x%x, newStatus: 0x%x)\n", barrier_id, *data, barrier->status);
+      barrier->status.or_window(window, *data);
+      trace.msg("Barrier mask trigger (barrier: %d, mask: 0x%x, window: %d, newStatus: 0x%x)\n", barrier_id, *data, window, barrier->status.get_window(window));
     }
 
     check_barrier(barrier_id);
@@ -1375,9 +1666,8 @@ vp::IoReqStatus Barrier_unit::req(vp::IoReq *req, uint64_t offset, bool is_write
   {
     // The access is valid only through the demux
     if (core == -1) return vp::IO_REQ_INVALID;
-    barrier->status |= 1 << core
-    ;
-    trace.msg("Barrier trigger (barrier: %d, coreId: %d, newStatus: 0x%x)\n", barrier_id, core, barrier->status);
+    barrier->status.set(core);
+    trace.msg("Barrier trigger (barrier: %d, coreId: %d)\n", barrier_id, core);
 
     check_barrier(barrier_id);
   }
@@ -1391,12 +1681,12 @@ vp::IoReqStatus Barrier_unit::req(vp::IoReq *req, uint64_t offset, bool is_write
     {
       // The core was already waiting for the barrier which means it was interrupted
       // by an interrupt. Just resume the barrier by going to sleep
-      trace.msg("Resuming barrier trigger and wait (barrier: %d, coreId: %d, newStatus: 0x%x)\n", barrier_id, core, barrier->status);
+      trace.msg("Resuming barrier trigger and wait (barrier: %d, coreId: %d)\n", barrier_id, core);
     }
     else
     {
-      barrier->status |= 1 << core;
-      trace.msg("Barrier trigger and wait (barrier: %d, coreId: %d, newStatus: 0x%x)\n", barrier_id, core, barrier->status);
+      barrier->status.set(core);
+      trace.msg("Barrier trigger and wait (barrier: %d, coreId: %d)\n", barrier_id, core);
     }
 
     check_barrier(barrier_id);
@@ -1413,12 +1703,12 @@ vp::IoReqStatus Barrier_unit::req(vp::IoReq *req, uint64_t offset, bool is_write
     {
       // The core was already waiting for the barrier which means it was interrupted
       // by an interrupt. Just resume the barrier by going to sleep
-      trace.msg("Resuming barrier trigger and wait (barrier: %d, coreId: %d, mask: 0x%x, newStatus: 0x%x)\n", barrier_id, core, barrier->core_mask, barrier->status);
+      trace.msg("Resuming barrier trigger and wait (barrier: %d, coreId: %d)\n", barrier_id, core);
     }
     else
     {
-      barrier->status |= 1 << core;
-      trace.msg("Barrier trigger, wait and clear (barrier: %d, coreId: %d, newStatus: 0x%x)\n", barrier_id, core, barrier->status);
+      barrier->status.set(core);
+      trace.msg("Barrier trigger, wait and clear (barrier: %d, coreId: %d)\n", barrier_id, core);
     }
     core_eu->clear_evt_mask = core_eu->evt_mask;
 
@@ -1430,7 +1720,7 @@ vp::IoReqStatus Barrier_unit::req(vp::IoReq *req, uint64_t offset, bool is_write
   {
     if (is_write) return vp::IO_REQ_INVALID;
     uint32_t status = 0;
-    for (unsigned int i=1; i<nb_barriers; i++) status |= barriers[i].status;
+    for (unsigned int i=1; i<nb_barriers; i++) status |= barriers[i].status.get_window(window);
     *data = status;
   }
   else return vp::IO_REQ_INVALID;
@@ -1443,10 +1733,16 @@ void Barrier_unit::reset()
   for (int i=0; i<nb_barriers; i++)
   {
     Barrier *barrier = &barriers[i];
-    barrier->core_mask = 0;
-    barrier->status = 0;
-    barrier->target_mask = 0;
+    barrier->core_mask.clear();
+    barrier->status.clear();
+    barrier->target_mask.clear();
   }
+
+  wakeup_mask.clear();
+  nb_reached = 0;
+  nb_core_wakeups = 0;
+  nb_batched_wakeups = 0;
+  nb_wakeup_events = 0;
 }
 
 
@@ -1476,7 +1772,7 @@ void Soc_event_unit::check_state()
 {
   if (this->fifo_soc_event != -1 && this->nb_free_events != this->nb_fifo_events) {
     this->trace.msg("Generating FIFO event (id: %d)\n", this->fifo_soc_event);
-    this->top->trigger_event(1<<this->fifo_soc_event, -1);
+    this->top->trigger_event_all(1<<this->fifo_soc_event);
   }
 }
 
@@ -1513,7 +1809,7 @@ vp::IoReqStatus Soc_event_unit::ioReq(uint32_t offset, bool is_write, uint32_t *
     if (nb_free_events != nb_fifo_events)
     {
       this->trace.msg("Generating FIFO soc event (id: %d)\n", this->fifo_soc_event);
-      this->top->trigger_event(1<<this->fifo_soc_event, -1);
+      this->top->trigger_event_all(1<<this->fifo_soc_event);
     }
   }
 
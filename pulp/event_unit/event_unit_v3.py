@@ -14,14 +14,31 @@
 # limitations under the License.
 #
 
+import copy
 import gvsoc.systree as st
 
 class Event_unit(st.Component):
 
-    def __init__(self, parent, name, config):
+    def __init__(self, parent, name, config, nb_core=None, barrier_fast=True, dispatch_depth=None,
+            dispatch_stall_on_full=False):
 
         super(Event_unit, self).__init__(parent, name)
 
         self.set_component('pulp.event_unit.eu_v3_impl')
 
-        self.add_properties(config)
\ No newline at end of file
+        # The dispatch FIFO depth can be overridden without modifying the shared configuration
+        if dispatch_depth is not None:
+            config = copy.deepcopy(config)
+            config['properties']['dispatch']['size'] = dispatch_depth
+
+        self.add_properties(config)
+
+        # The number of cores can be overridden to build clusters with more cores than the
+        # default configuration, there is no limit on it
+        if nb_core is not None:
+            self.add_property('nb_core', nb_core)
+
+        self.add_properties({
+            'barrier_fast': barrier_fast,
+            'dispatch_stall_on_full': dispatch_stall_on_full
+        })
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Standalone check of the event unit core bitset, compared against a plain
+// vector<bool> for clusters of 8, 32 and 128 cores. Run with "make run".
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include "eu_core_mask.hpp"
+
+static int nb_errors = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("  FAILED: " __VA_ARGS__); printf("\n"); nb_errors++; } } while(0)
+
+// Mask of nb_core cores is stored in whole 64-bit words, the extra bits of the last word
+// are addressable, like with the original 32-bit registers
+static int mask_bits(int nb_core)
+{
+  return (nb_core + 63) / 64 * 64;
+}
+
+static void check_ref(const Eu_core_mask &mask, const std::vector<bool> &ref, const char *step)
+{
+  std::vector<int> visited;
+  mask.for_each([&visited](int core) { visited.push_back(core); });
+
+  std::vector<int> expected;
+  for (int i=0; i<(int)ref.size(); i++)
+  {
+    CHECK(mask.test(i) == ref[i], "%s: test(%d) is %d", step, i, mask.test(i));
+    if (ref[i]) expected.push_back(i);
+  }
+
+  CHECK(visited == expected, "%s: for_each visited %d cores instead of %d", step, (int)visited.size(), (int)expected.size());
+  CHECK(mask.any() == !expected.empty(), "%s: any() is %d", step, mask.any());
+  CHECK(mask.find_first() == (expected.empty() ? -1 : expected[0]), "%s: find_first() is %d", step, mask.find_first());
+
+  for (int window=0; window<mask_bits(ref.size())/32 + 1; window++)
+  {
+    uint32_t value = 0;
+    for (int i=0; i<32; i++)
+    {
+      int core = window*32 + i;
+      if (core < (int)ref.size() && ref[core]) value |= 1U << i;
+    }
+    CHECK(mask.get_window(window) == value, "%s: window %d is 0x%x instead of 0x%x", step, window, mask.get_window(window), value);
+  }
+}
+
+static void check(int nb_core)
+{
+  int nb_bits = mask_bits(nb_core);
+  int nb_windows = nb_bits / 32;
+  std::vector<bool> ref(nb_bits, false);
+  Eu_core_mask mask;
+
+  printf("Checking %d cores\n", nb_core);
+
+  mask.init(nb_core);
+  check_ref(mask, ref, "init");
+
+  // Single cores, including the ones which do not exist but are addressable
+  for (int core=0; core<nb_bits; core++)
+  {
+    mask.set(core);
+    ref[core] = true;
+    check_ref(mask, ref, "set");
+    mask.reset(core);
+    ref[core] = false;
+  }
+  check_ref(mask, ref, "reset");
+
+  mask.set_all();
+  ref.assign(nb_bits, true);
+  check_ref(mask, ref, "set_all");
+
+  mask.clear();
+  ref.assign(nb_bits, false);
+  check_ref(mask, ref, "clear");
+
+  // Register windows, the ones above the mask are read as 0 and ignored when written
+  for (int window=0; window<nb_windows + 1; window++)
+  {
+    uint32_t value = 0xa5a5a5a5 ^ (window * 0x01010101);
+    mask.set_window(window, value);
+    for (int i=0; i<32 && window < nb_windows; i++)
+    {
+      ref[window*32 + i] = (value >> i) & 1;
+    }
+  }
+  check_ref(mask, ref, "set_window");
+
+  for (int window=0; window<nb_windows + 1; window++)
+  {
+    mask.or_window(window, 1U << window);
+    if (window < nb_windows) ref[window*32 + window] = true;
+  }
+  check_ref(mask, ref, "or_window");
+
+  // Union and comparison
+  Eu_core_mask other;
+  other.init(nb_core);
+  other.set(nb_core - 1);
+  other.set(0);
+  mask |= other;
+  ref[nb_core - 1] = true;
+  ref[0] = true;
+  check_ref(mask, ref, "or");
+
+  Eu_core_mask copy = mask;
+  CHECK(copy == mask, "copy differs");
+  copy.reset(nb_core - 1);
+  CHECK(!(copy == mask), "modified copy is equal");
+
+  // Cores can remove themselves from the set while it is iterated, as done when waking up
+  // the cores waiting on a barrier or a dispatch entry
+  std::vector<int> expected;
+  for (int i=0; i<nb_bits; i++)
+  {
+    if (ref[i]) expected.push_back(i);
+  }
+  std::vector<int> visited;
+  mask.for_each([&mask, &visited](int core) { visited.push_back(core); mask.reset(core); });
+  ref.assign(nb_bits, false);
+  CHECK(visited == expected, "for_each with reset visited %d cores instead of %d", (int)visited.size(), (int)expected.size());
+  check_ref(mask, ref, "for_each with reset");
+
+  // Random sequence of operations
+  uint32_t seed = 0x12345678 + nb_core;
+  for (int i=0; i<10000; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    int core = (seed >> 8) % nb_bits;
+    switch ((seed >> 24) % 4)
+    {
+      case 0: mask.set(core); ref[core] = true; break;
+      case 1: mask.reset(core); ref[core] = false; break;
+      case 2:
+      {
+        int window = core / 32;
+        uint32_t value = seed ^ (seed << 7);
+        mask.set_window(window, value);
+        for (int j=0; j<32; j++) ref[window*32 + j] = (value >> j) & 1;
+        break;
+      }
+      case 3:
+      {
+        int window = core / 32;
+        uint32_t value = 1U << (seed & 31);
+        mask.or_window(window, value);
+        ref[window*32 + (seed & 31)] = true;
+        break;
+      }
+    }
+    if (i % 100 == 0) check_ref(mask, ref, "random");
+  }
+  check_ref(mask, ref, "random");
+}
+
+int main()
+{
+  check(8);
+  check(32);
+  check(128);
+
+  if (nb_errors)
+  {
+    printf("%d errors\n", nb_errors);
+    return 1;
+  }
+
+  printf("All checks passed\n");
+  return 0;
+}
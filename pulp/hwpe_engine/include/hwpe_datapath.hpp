@@ -0,0 +1,927 @@
+/*
+ * Copyright (C) 2020-2022  GreenWaves Technologies, ETH Zurich, University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Francesco Conti, University of Bologna & GreenWaves Technologies (f.conti@unibo.it)
+ *          Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ *          Arpan Suravi Prasad, ETH Zurich (prasadar@iis.ee.ethz.ch)
+ */
+
+#ifndef __HWPE_DATAPATH_HPP__
+#define __HWPE_DATAPATH_HPP__
+
+// Datapath stages of the HWPE engine shared by the accelerators, included at
+// the end of hwpe_engine.hpp. The stages work on the geometry of the
+// accelerator, depthwise layers processing TP_IN_S channels per tile.
+
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+/*
+ * DEBUG
+ */
+
+template<class Geometry>
+void HwpeEngine<Geometry>::debug_traces_update() {
+  this->x_buffer_traces = false;
+  this->x_buffer_traces_postload = false;
+  this->accum_traces_poststreamin = false;
+  this->accum_traces = false;
+  this->accum_traces_postmatrixvec =false;
+  this->accum_traces_normquant = false;
+  this->accum_traces_streamout = false;
+  this->psum_block_traces = false;
+  this->binconv_traces = false;
+  this->fsm_traces = false;
+  if(this->trace_level == L1_ACTIV_INOUT) {
+    this->x_buffer_traces_postload = true;
+    this->accum_traces_streamout = true;
+  }
+  if(this->trace_level == L2_DEBUG) {
+    this->x_buffer_traces_postload = true;
+    this->fsm_traces = true;
+    this->accum_traces_poststreamin = true;
+    this->accum_traces_streamout = true;
+    this->accum_traces_postmatrixvec = true;
+    this->accum_traces_normquant = true;
+  }
+  if(this->trace_level == L3_ALL) {
+    this->x_buffer_traces = true;
+    this->x_buffer_traces_postload = true;
+    this->fsm_traces = true;
+    this->accum_traces = true;
+    this->accum_traces_poststreamin = true;
+    this->accum_traces_streamout = true;
+    this->accum_traces_postmatrixvec = true;
+    this->accum_traces_normquant = true;
+  }
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::debug_accum() {
+  std::ostringstream stringStream;
+  stringStream << "accum[" << this->TP_OUT << "," << this->NR_COLUMN << "] = \n" << (this->trace_format?std::hex:std::dec) << std::setw(8) << xt::cast<int32_t>(this->accum) << std::dec << "\n";
+  std::string copyOfStr = stringStream.str();
+  this->trace.msg(vp::Trace::LEVEL_DEBUG, copyOfStr.c_str());
+}
+
+/*
+ * CLEAR
+ */
+
+template<class Geometry>
+void HwpeEngine<Geometry>::clear_all() {
+  this->k_out_major = 0;
+  this->i_major = 0;
+  this->j_major = 0;
+  this->k_in_major_iter = 0;
+  this->k_in_major = 0;
+  this->h_size_in  = 0;
+  this->w_size_in  = 0;
+  this->h_size_out = 0;
+  this->w_size_out = 0;
+  this->h_size_in_hw = 0;
+  this->w_size_in_hw = 0;
+  this->h_size_in_X_w_size_in = 0;
+  this->h_size_out_X_w_size_out = 0;
+  this->k_out_lim_dw = 0;
+  this->dw_lim = 0;
+  this->dw_iter = 0;
+
+  // STREAMIN state
+  this->streamin_ij_out = 0;
+
+  // LOAD state
+  this->load_fbuf_lim = 0;
+  this->load_i_fbuf_lim = 0;
+  this->load_j_fbuf_lim = 0;
+  this->load_k_in_lim = 0;
+  this->load_padding = {0, 0}; // std::vector<uint32_t>
+  this->load_i_fbuf = 0;
+  this->load_j_fbuf = 0;
+  this->load_padding_mask_cache.assign(16*(this->F_BUFFER_SIZE+1)*(this->F_BUFFER_SIZE+1), -1);
+  this->prefetch_load_cycles = 0;
+  this->prefetch_load_end = 0;
+  this->prefetch_load_done = false;
+  this->prefetch_mv_end.clear();
+
+  // MATRIXVEC state
+  this->mv_k_out_iter = 0;
+  this->mv_qw_iter = 0; // was simply qw
+
+  // STREAMOUT state
+  this->streamout_i_out_iter = 0;
+  this->streamout_i_out_lim = 0;
+  this->streamout_j_out_iter = 0;
+  this->streamout_j_out_lim = 0;
+  this->streamout_k_out_iter = 0;
+  this->streamout_k_out_lim = 0;
+
+  this->clear_accum();
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::clear_accum() {
+  xt::view(this->accum,       xt::all()) = 0;
+  xt::view(this->psum_column, xt::all()) = 0;
+  xt::view(this->psum_block,  xt::all()) = 0;
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::clear_x_buffer() {
+  xt::view(this->x_buffer, xt::all()) = 0;
+  xt::view(this->x_array,  xt::all()) = 0;
+}
+
+/*
+ * STREAMIN
+ */
+
+template<class Geometry>
+void HwpeEngine<Geometry>::constant_setup() {
+  this->h_size_in  = this->i_major<this->subtile_nb_ho ? (this->fs == 3 ? this->F_BUFFER_SIZE : this->H_SIZE) : this->subtile_rem_hi;
+  this->w_size_in  = this->j_major<this->subtile_nb_wo ? (this->fs == 3 ? this->F_BUFFER_SIZE : this->W_SIZE) : this->subtile_rem_wi;
+  this->h_size_out = this->i_major<this->subtile_nb_ho ? this-> H_SIZE : this->subtile_rem_ho;
+  this->w_size_out = this->j_major<this->subtile_nb_wo ? this-> W_SIZE : this->subtile_rem_wo;
+
+  this->h_size_in_hw = (this->i_major<this->subtile_nb_ho-1 || this->subtile_rem_hi==0) ? (this->fs == 3 ? this->F_BUFFER_SIZE : this->H_SIZE) : this->subtile_rem_hi;
+  this->w_size_in_hw = (this->j_major<this->subtile_nb_wo-1 || this->subtile_rem_wi==0) ? (this->fs == 3 ? this->F_BUFFER_SIZE : this->W_SIZE) : this->subtile_rem_wi;
+
+  // compute these products also with pure multiplexing
+  this->h_size_in_X_w_size_in = (this->i_major<this->subtile_nb_ho  && this->j_major<this->subtile_nb_wo)  ? (this->fs == 3 ? this->F_BUFFER_SIZE*this->F_BUFFER_SIZE : this->H_SIZE*this->W_SIZE) :
+                                (this->i_major<this->subtile_nb_ho  && this->j_major>=this->subtile_nb_wo) ? (this->fs == 3 ? this->F_BUFFER_SIZE*this->subtile_rem_wi     : this->H_SIZE*this->subtile_rem_wi)   :
+                                (this->i_major>=this->subtile_nb_ho && this->j_major<this->subtile_nb_wo)  ? (this->fs == 3 ? this->subtile_rem_hi*this->F_BUFFER_SIZE     : this->subtile_rem_hi*this->W_SIZE)   :
+                                                                                                (this->fs == 3 ? this->subtile_rem_hi*this->subtile_rem_wi         : this->subtile_rem_hi*this->subtile_rem_wi);
+  this->h_size_out_X_w_size_out = (this->i_major<this->subtile_nb_ho  && this->j_major<this->subtile_nb_wo)  ? this->H_SIZE*this->W_SIZE :
+                                  (this->i_major<this->subtile_nb_ho  && this->j_major>=this->subtile_nb_wo) ? this->H_SIZE*this->subtile_rem_wo  :
+                                  (this->i_major>=this->subtile_nb_ho && this->j_major<this->subtile_nb_wo)  ? this->subtile_rem_ho*this->W_SIZE  :
+                                                                                                               this->subtile_rem_ho*this->subtile_rem_wo;
+
+  this->k_in_major = this->depthwise ? this->k_out_major : this->k_in_major_iter;
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::streamin_setup() {
+
+  auto tp = this->depthwise ? this->TP_IN_S : this->TP_OUT;
+
+  auto outfeat_hom_iter = this->H_SIZE * this->outfeat_d2_stride;
+  auto outfeat_wom_iter = this->W_SIZE * this->outfeat_d1_stride;
+
+  auto base_addr_streamin = this->outfeat_ptr + this->i_major*outfeat_hom_iter + this->j_major*outfeat_wom_iter + this->k_out_major*tp*this->quantization_bits/8;
+
+  auto k_out_lim = this->depthwise ? 1 :
+                   (this->k_out_major == this->subtile_nb_ko-1 && this->subtile_rem_ko != this->TP_OUT && this->subtile_rem_ko != 0) ? this->subtile_rem_ko : this->TP_OUT;
+
+  auto h_size_out_X_w_size_out_with_strb = (k_out_lim <= 8)  ? this->NR_COLUMN   :
+                                           (k_out_lim <= 16) ? 2*this->NR_COLUMN :
+                                           (k_out_lim <= 24) ? 3*this->NR_COLUMN : 4*this->NR_COLUMN;
+
+  this->col_enable = xt::zeros<int32_t>({this->H_SIZE, this->W_SIZE});
+  for(auto i=0; i<this->h_size_out; i++) {
+    for(auto j=0; j<this->w_size_out; j++) {
+      xt::view(this->col_enable, i, j) = 1;
+    }
+  }
+
+  this->vld_streamin = VectorLoad(
+    this,
+    base_addr_streamin, // base_addr
+    h_size_out_X_w_size_out_with_strb*(k_out_lim/8 > 0 ? k_out_lim/8 + (k_out_lim%8 == 0 ? 0 : 1) : 1), // word_length
+    this->outfeat_d0_stride, // word_stride
+    k_out_lim/8 > 0 ? k_out_lim/8 + (k_out_lim%8 == 0 ? 0 : 1) : 1, //w_size_out, // line_length
+    this->outfeat_d1_stride, // line_stride
+    this->H_SIZE, // block_length
+    this->outfeat_d2_stride, // block_stride
+    false
+  );
+
+  this->streamin_k_out_lim = this->TP_OUT/8; ///
+  if(this->k_out_major == this->subtile_nb_ko-1 && this->subtile_rem_ko != this->TP_OUT && this->subtile_rem_ko != 0) { // last k_in tile, only if it requires padding
+    this->streamin_k_out_lim = this->subtile_rem_ko/8 + (this->subtile_rem_ko%8 == 0 ? 0 : 1);
+  }
+  this->streamin_k_out_iter = 0;
+  this->streamin_i_out_iter = 0;
+  this->streamin_j_out_iter = 0;
+
+}
+
+// iterated h_size_out_X_w_size_out times
+template<class Geometry>
+int HwpeEngine<Geometry>::streamin_cycle() {
+  int64_t cycles = 0;
+
+  xt::xarray<uint8_t> xx = xt::zeros<uint8_t>({32});
+  auto k_out_last = (this->streamin_k_out_iter+1)*8;
+  if(this->k_out_major == this->subtile_nb_ko-1 && this->subtile_rem_ko != this->TP_OUT && this->subtile_rem_ko != 0) { // last k_in tile, only if it requires padding
+    k_out_last = k_out_last < this->subtile_rem_ko ? k_out_last : this->subtile_rem_ko;
+  }
+  if(this->col_enable(this->streamin_i_out_iter, this->streamin_j_out_iter)) {
+    xx = this->vld_streamin.ex((k_out_last-this->streamin_k_out_iter*8)*4, cycles);
+  }
+  for (auto i=this->streamin_k_out_iter*8; i<k_out_last; i++) {
+    xt::view(this->accum, i, this->streamin_i_out_iter*this->W_SIZE+this->streamin_j_out_iter) =
+      (xt::cast<int32_t>(xt::view(xx, (i-this->streamin_k_out_iter*8)*4+0)) << 0 ) |
+      (xt::cast<int32_t>(xt::view(xx, (i-this->streamin_k_out_iter*8)*4+1)) << 8 ) |
+      (xt::cast<int32_t>(xt::view(xx, (i-this->streamin_k_out_iter*8)*4+2)) << 16) |
+      (xt::cast<int32_t>(xt::view(xx, (i-this->streamin_k_out_iter*8)*4+3)) << 24);
+  }
+  return (int) cycles;
+}
+
+template<class Geometry>
+bool HwpeEngine<Geometry>::streamin_exit_idx() {
+  auto h_size_out = this->mode_linear ? 1 : this->h_size_out;
+  auto w_size_out = this->mode_linear ? 1 : this->w_size_out;
+  if(this->streamin_i_out_iter == h_size_out-1 && this->streamin_j_out_iter == w_size_out-1 && this->streamin_k_out_iter == this->streamin_k_out_lim-1) {
+    return true;
+  }
+  else {
+    return false;
+  }
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::streamin_update_idx() {
+  if(this->streamin_k_out_iter < this->streamin_k_out_lim-1) {
+    this->streamin_k_out_iter++;
+  }
+  else if(this->streamin_j_out_iter < this->W_SIZE-1) {
+    this->streamin_k_out_iter = 0;
+    this->streamin_j_out_iter++;
+  }
+  else {
+    this->streamin_k_out_iter = 0;
+    this->streamin_j_out_iter = 0;
+    this->streamin_i_out_iter++;
+  }
+}
+
+/*
+ * LOAD
+ */
+
+// Returns the mask of the x_buffer pixels which must be overwritten with the
+// padding value, bit i*F_BUFFER_SIZE+j being set for pixel (i,j).
+//
+// Implicit padding (on the right/bottom) and explicit padding (all dimensions) define
+// sixteen regions:
+// +-------+-------+-------+-------+
+// | TL    | T     | TR    | TRR   |
+// +-------+-------+-------+-------+
+// | L     | body  | R     | RR    |
+// +-------+-------+-------+-------+
+// | BL    | B     | BR    | BRR   |
+// +-------+-------+-------+-------+
+// | BBL   | BB    | BBR   | BBRR  |
+// +-------+-------+-------+-------+
+//
+// The mask only depends on which edges of the tile are on the border of the
+// image and on the tile size, so it is computed once per job for each case.
+template<class Geometry>
+uint64_t HwpeEngine<Geometry>::load_padding_mask() {
+  static_assert(Geometry::F_BUFFER_SIZE*Geometry::F_BUFFER_SIZE <= 64, "feature buffer too large for the padding mask");
+
+  bool top    = this->padding_top    > 0 && this->i_major==0;
+  bool right  = this->padding_right  > 0 && this->j_major==this->subtile_nb_wo-1;
+  bool bottom = this->padding_bottom > 0 && this->i_major==this->subtile_nb_ho-1;
+  bool left   = this->padding_left   > 0 && this->j_major==0;
+
+  int key = -1;
+  if(this->h_size_in_hw <= this->F_BUFFER_SIZE && this->w_size_in_hw <= this->F_BUFFER_SIZE) {
+    key = (((top << 3) | (right << 2) | (bottom << 1) | left) * (this->F_BUFFER_SIZE+1) + this->h_size_in_hw) * (this->F_BUFFER_SIZE+1) + this->w_size_in_hw;
+    if(this->load_padding_mask_cache[key] >= 0) {
+      return this->load_padding_mask_cache[key];
+    }
+  }
+
+  auto right_lim  = (this->F_BUFFER_SIZE-this->padding_right  > this->w_size_in_hw) ? this->w_size_in_hw : this->F_BUFFER_SIZE-this->padding_right;
+  auto bottom_lim = (this->F_BUFFER_SIZE-this->padding_bottom > this->h_size_in_hw) ? this->h_size_in_hw : this->F_BUFFER_SIZE-this->padding_bottom;
+
+  uint64_t mask = 0;
+  for(auto i=0; i<this->F_BUFFER_SIZE; i++) {
+    bool row_top    = i < this->padding_top;
+    bool row_body   = i >= this->padding_top && i < bottom_lim;
+    bool row_bottom = i >= bottom_lim && i < this->h_size_in_hw;
+    for(auto j=0; j<this->F_BUFFER_SIZE; j++) {
+      bool col_left  = j < this->padding_left;
+      bool col_body  = j >= this->padding_left && j < right_lim;
+      bool col_right = j >= right_lim && j < this->w_size_in_hw;
+      if((row_top    && col_left  && (left || top))     || // top-left
+         (row_top    && col_body  && top)               || // top
+         (row_top    && col_right && (right || top))    || // top-right
+         (row_body   && col_right && right)             || // right
+         (row_bottom && col_right && (right || bottom)) || // bottom-right
+         (row_bottom && col_body  && bottom)            || // bottom
+         (row_bottom && col_left  && (left || bottom))  || // bottom-left
+         (row_body   && col_left  && left)) {              // left
+        mask |= (uint64_t)1 << (i*this->F_BUFFER_SIZE + j);
+      }
+    }
+  }
+
+  // the mask of a full 8x8 buffer does not fit in the positive range of the cache
+  if(key >= 0 && mask < ((uint64_t)1 << 63)) {
+    this->load_padding_mask_cache[key] = mask;
+  }
+  return mask;
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::load_do_padding() { // not linear
+
+  uint64_t mask = this->load_padding_mask();
+  if(mask == 0) {
+    return;
+  }
+
+  // padding pattern over the input channels (in 16-bit mode, LSBs and MSBs are interleaved)
+  uint8_t pattern[this->TP_IN];
+  int pattern_len = this->mode16 ? this->load_k_in_lim + (this->load_k_in_lim & 1) : this->load_k_in_lim;
+  if(pattern_len > this->TP_IN) {
+    pattern_len = this->TP_IN;
+  }
+  for(auto k=0; k<pattern_len; k++) {
+    pattern[k] = (this->mode16 && (k & 1)) ? this->padding_value >> 8 : this->padding_value & 0xff;
+  }
+
+  uint8_t *x_buffer = (uint8_t *)this->x_buffer.data();
+  for(auto p=0; p<this->F_BUFFER_SIZE*this->F_BUFFER_SIZE; p++) {
+    if(mask & ((uint64_t)1 << p)) {
+      memcpy(x_buffer + p*this->TP_IN, pattern, pattern_len);
+    }
+  }
+}
+
+// With prefetching enabled, the streamer loads the next feature tile while
+// MATRIXVEC is still working on the previous ones, using up to prefetch_depth
+// additional feature buffers. The load latency is then accounted here instead of
+// stalling the FSM, and MATRIXVEC only stalls if its tile is not loaded yet.
+// Only feature tiles are prefetched: weights are streamed by MATRIXVEC itself
+// and consumed as they arrive, so their latency is still paid in every
+// MATRIXVEC cycle, and the port contention between the two streams is not
+// modeled.
+
+// Called when a new output tile starts, as the streamer was busy with streamin
+// and streamout until now.
+template<class Geometry>
+void HwpeEngine<Geometry>::load_prefetch_sync() {
+  if(this->prefetch_depth > 0) {
+    int64_t now = this->clock.get_cycles();
+    if(now > this->prefetch_load_end) {
+      this->prefetch_load_end = now;
+    }
+  }
+}
+
+template<class Geometry>
+int HwpeEngine<Geometry>::load_prefetch_account(int latency) {
+  this->prefetch_load_cycles += latency;
+  this->prefetch_load_done = true;
+  return 0;
+}
+
+// Returns the number of cycles MATRIXVEC must wait for the tile to be loaded
+template<class Geometry>
+int HwpeEngine<Geometry>::load_prefetch_stall() {
+  if(this->prefetch_depth == 0 || !this->prefetch_load_done) {
+    return 0;
+  }
+
+  // the load can only start once the streamer is free and MATRIXVEC has released
+  // the feature buffer which was loaded prefetch_depth+1 tiles ago
+  int64_t load_start = this->prefetch_load_end;
+  if((int)this->prefetch_mv_end.size() > this->prefetch_depth && this->prefetch_mv_end.front() > load_start) {
+    load_start = this->prefetch_mv_end.front();
+  }
+  this->prefetch_load_end = load_start + this->prefetch_load_cycles;
+  this->prefetch_load_cycles = 0;
+  this->prefetch_load_done = false;
+
+  int64_t now = this->clock.get_cycles();
+  return this->prefetch_load_end > now ? this->prefetch_load_end - now : 0;
+}
+
+// Called when MATRIXVEC is done with the current feature buffer
+template<class Geometry>
+void HwpeEngine<Geometry>::load_prefetch_release(int64_t mv_end) {
+  if(this->prefetch_depth == 0) {
+    return;
+  }
+  this->prefetch_mv_end.push_back(mv_end);
+  if((int)this->prefetch_mv_end.size() > this->prefetch_depth + 1) {
+    this->prefetch_mv_end.pop_front();
+  }
+}
+
+/*
+ * MATRIXVEC
+ */
+
+// Unpacks size rows of TP_IN weight bits, one byte per bit
+static inline void __WeightUnpackFast(const uint8_t *w, int size, int TP_IN, uint8_t *wu)
+{
+  for(int i=0; i<size*TP_IN/8; i++) {
+    for(int b=0; b<8; b++) {
+      wu[i*8+b] = (w[i] >> b) & 0x1;
+    }
+  }
+}
+
+// Sum of the activations of the enabled MACs whose weight bit is set. Dense
+// layers enable the first nb_lanes MACs, depthwise layers a single one.
+template<typename T>
+static inline int64_t __BinConvBlockFast(const uint8_t *w, const T *x, const int *lanes, int nb_lanes, bool dense)
+{
+  int64_t sum = 0;
+  if(nb_lanes == 1) {
+    if(w[lanes[0]]) {
+      sum = x[lanes[0]];
+    }
+  }
+  else if(dense) {
+    for(int k=0; k<nb_lanes; k++) {
+      if(w[k]) {
+        sum += x[k];
+      }
+    }
+  }
+  else {
+    for(int i=0; i<nb_lanes; i++) {
+      if(w[lanes[i]]) {
+        sum += x[lanes[i]];
+      }
+    }
+  }
+  return sum;
+}
+
+// Same as the generic BinConv array of the accelerators without weight
+// inversion, 16-bit and linear modes, but working on raw buffers and only
+// visiting the enabled rows and MACs. weight holds nb_rows rows of TP_IN
+// unpacked bits.
+template<class Geometry>
+void HwpeEngine<Geometry>::__BinConvArrayFast(
+  const uint8_t             *weight,
+  int                        nb_rows,
+  int                        scale,
+  int                        idx,
+  const xt::xarray<int32_t>& row_enable,
+  const xt::xarray<int32_t>& mac_enable,
+  bool                       weight_shift,
+  bool                       use_row_as_scale
+) {
+  int lanes[this->TP_IN];
+  int nb_lanes = 0;
+  bool dense = true;
+  for(auto k=0; k<this->TP_IN; k++) {
+    if(mac_enable(k)) {
+      dense = dense && nb_lanes == k;
+      lanes[nb_lanes++] = k;
+    }
+  }
+
+  int rows[this->COLUMN_SIZE];
+  int nb_enabled_rows = 0;
+  for(auto r=0; r<this->COLUMN_SIZE && r<nb_rows; r++) {
+    if(row_enable(r)) {
+      rows[nb_enabled_rows++] = r;
+    }
+  }
+
+  // counted as in the generic kernels, which already did it when checking
+  if(!this->matrixvec_check) {
+    this->perf_mac(this->NR_COLUMN * this->nb_row_enable * this->nb_mac_enable, this->NR_COLUMN * this->COLUMN_SIZE * this->TP_IN);
+  }
+
+  const uint8_t *x_array = (const uint8_t *)this->x_array.data();
+  int64_t *psum_block = this->psum_block.data();
+  int64_t *psum_column = this->psum_column.data();
+  int64_t *accum = this->accum.data();
+
+  for(auto c=0; c<this->NR_COLUMN; c++) { // spatial loop - over columns
+    psum_column[c] = 0;
+    if(nb_lanes > 0) {
+      for(auto i=0; i<nb_enabled_rows; i++) { // spatial loop - over enabled blocks in a column
+        auto r = rows[i];
+        auto scale_loc = use_row_as_scale ? 1 << r : scale;
+        const uint8_t *activ = x_array + (c*this->COLUMN_SIZE + r)*this->TP_IN;
+        int64_t sum = this->signed_activation ? __BinConvBlockFast(weight + r*this->TP_IN, (const int8_t *)activ, lanes, nb_lanes, dense)
+                                              : __BinConvBlockFast(weight + r*this->TP_IN, activ, lanes, nb_lanes, dense);
+        psum_block[c*this->COLUMN_SIZE + r] = sum * scale_loc;
+        psum_column[c] += sum * scale_loc;
+      }
+    }
+    else {
+      for(auto i=0; i<nb_enabled_rows; i++) {
+        psum_block[c*this->COLUMN_SIZE + rows[i]] = 0;
+      }
+    }
+
+    if(weight_shift) {
+      for(auto k=0; k<this->TP_OUT; k++) {
+        accum[k*this->NR_COLUMN + c] += psum_column[c];
+      }
+    }
+    else {
+      accum[idx*this->NR_COLUMN + c] += psum_column[c];
+    }
+  }
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::__matrixvec_check(const xt::xarray<int64_t>& accum_ref, const char *stage) {
+  if(accum_ref != this->accum) {
+    std::ostringstream stringStream;
+    stringStream << "generic=" << accum_ref << "\nfast=" << this->accum << "\n";
+    std::string copyOfStr = stringStream.str();
+    this->trace.msg(vp::Trace::LEVEL_ERROR, copyOfStr.c_str());
+    this->trace.fatal("Fast %s kernel differs from the generic one (fs=%d, depthwise=%d, dw_iter=%d, k_out=%d, qw_iter=%d)\n",
+      stage, this->fs, this->depthwise, this->dw_iter, this->mv_k_out_iter, this->mv_qw_iter);
+  }
+}
+
+/*
+ * NORMQUANT
+ */
+
+template<class Geometry>
+void HwpeEngine<Geometry>::normquant_shift_setup() {
+  // set up streamer to address input activations (byte-based)
+  auto tp = this->depthwise ? this->TP_IN_S : this->TP_OUT;
+  auto base_addr_nqs = this->scale_shift_ptr + this->k_out_major*tp;
+
+  this->vld_nqs = VectorLoad(
+    this,
+    base_addr_nqs, // base_addr
+    1, // word_length
+    tp, // word_stride
+    1, // line_length
+    0, // line_stride
+    1, // block_length
+    0, // block_stride
+    false
+  );
+}
+
+template<class Geometry>
+int HwpeEngine<Geometry>::normquant_shift_cycle() {
+  int64_t cycles = 0;
+  xt::view(this->nqs, xt::all()) = this->vld_nqs.ex(this->TP_OUT, cycles);
+  return (int) cycles;
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::normquant_mult_setup() {
+  // set up streamer to address input activations (byte-based)
+  auto tp = this->depthwise ? this->TP_IN_S : this->TP_OUT;
+  auto base_addr_nq = this->scale_ptr + this->k_out_major*tp*(this->normalization_bits/8);
+
+  this->vld_nq = VectorLoad(
+    this,
+    base_addr_nq, // base_addr
+    tp/(this->normalization_bits/8), // word_length
+    4, // word_stride
+    this->normalization_bits, // line_length
+    0, // line_stride
+    1, // block_length
+    0, // block_stride
+    false
+  );
+
+  this->nq_lim = this->normalization_bits;
+  if(this->k_out_major == this->subtile_nb_ko-1 && this->subtile_rem_ko != this->TP_OUT && this->subtile_rem_ko != 0) { // last k_in tile, only if it requires padding
+    this->nq_lim = this->normalization_bits == 32 ? this->subtile_rem_ko :
+                   this->normalization_bits == 16 ? this->subtile_rem_ko / 2 + (this->subtile_rem_ko % 2 ? 1 : 0) :
+                                                    this->subtile_rem_ko / 4 + (this->subtile_rem_ko % 4 ? 1 : 0) ;
+  }
+  this->nq_iter = 0;
+}
+
+template<class Geometry>
+int HwpeEngine<Geometry>::normquant_mult_cycle() {
+  int64_t cycles = 0;
+  xt::xarray<uint8_t> nq = this->vld_nq.ex(4, cycles);
+  // FIXME casting --> 1) load NQS; 2) load NQ and compute MULT; 3) load NQB and compute shift+bias
+  if(this->normalization_bits == 8) {
+    auto nmult = 4;
+    for(auto i=0; i<nmult; i++) {
+      for(auto col=0; col<this->NR_COLUMN; col++) {
+        xt::view(this->accum, this->nq_iter*nmult+i, col) = xt::view(this->accum, this->nq_iter*nmult+i, col) * xt::view(nq, i);
+      }
+    }
+  }
+  else if(this->normalization_bits == 16) {
+    auto nmult = 2;
+    xt::xarray<uint16_t> nq16 = xt::zeros<uint16_t>({2});
+    xt::view(nq16, 0) = xt::view(nq, 0) + (xt::view(nq, 1) << 8);
+    xt::view(nq16, 1) = xt::view(nq, 2) + (xt::view(nq, 3) << 8);
+    for(auto i=0; i<2; i++) {
+      for(auto col=0; col<this->NR_COLUMN; col++) {
+        xt::view(this->accum, this->nq_iter*nmult+i, col) = xt::view(this->accum, this->nq_iter*nmult+i, col) * xt::view(nq16, i);
+      }
+    }
+  }
+  else if(this->normalization_bits == 32) {
+    xt::xarray<uint32_t> nq32 = xt::zeros<uint32_t>({1});
+    xt::view(nq32, 0) = xt::view(nq, 0) + (xt::view(nq, 1) << 8) + (xt::view(nq, 2) << 16) + (xt::view(nq, 3) << 24);
+    for(auto col=0; col<this->NR_COLUMN; col++) {
+      xt::view(this->accum, this->nq_iter, col) = xt::view(this->accum, this->nq_iter, col) * xt::view(nq32, 0);
+    }
+  }
+  return (int) cycles;
+}
+
+template<class Geometry>
+bool HwpeEngine<Geometry>::normquant_mult_exit_idx() {
+  if(this->nq_iter == this->nq_lim-1) {
+    return true;
+  }
+  else {
+    return false;
+  }
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::normquant_mult_update_idx() {
+  this->nq_iter++;
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::normquant_bias_setup() {
+  // set up streamer to address input activations (byte-based)
+  auto tp = this->depthwise ? this->TP_IN_S : this->TP_OUT;
+  auto base_addr_nqb = this->scale_bias_ptr + this->k_out_major*tp*4;
+
+  // one 32-byte word per group of 8 channels
+  this->vld_nqb = VectorLoad(
+    this,
+    base_addr_nqb, // base_addr
+    (tp+7)/8, // word_length
+    32, // word_stride
+    (tp+7)/8, // line_length
+    0, // line_stride
+    1, // block_length
+    0, // block_stride
+    false
+  );
+
+  this->nqb_lim = this->normalization_bits;
+  if(this->k_out_major == this->subtile_nb_ko-1 && this->subtile_rem_ko != this->TP_OUT && this->subtile_rem_ko != 0) { // last k_in tile, only if it requires padding
+    this->nqb_lim = this->subtile_rem_ko;
+  }
+  this->nqb_iter = 0;
+}
+
+template<class Geometry>
+int HwpeEngine<Geometry>::normquant_bias_cycle() {
+  int64_t cycles = 0;
+  xt::xarray<int32_t> nqb32 = xt::zeros<int32_t>({8});
+  if(this->norm_option_bias) {
+    xt::xarray<uint8_t> nqb = this->vld_nqb.ex(32, cycles);
+    for(auto i=0; i<8; i++) {
+      xt::view(nqb32, i) = xt::cast<int32_t>(xt::view(nqb, i*4) + (xt::view(nqb, i*4+1) << 8) + (xt::view(nqb, i*4+2) << 16) + (xt::view(nqb, i*4+3) << 24));
+    }
+    for(auto col=0; col<this->NR_COLUMN; col++) {
+      xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col) = (xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col) + nqb32);
+    }
+    if(this->norm_option_shift) {
+      for(auto col=0; col<this->NR_COLUMN; col++) {
+        xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col) = xt::cast<int32_t>(xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col)) >> xt::view(this->nqs, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8));
+      }
+    }
+    else {
+      for(auto col=0; col<this->NR_COLUMN; col++) {
+        xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col) = xt::cast<int32_t>(xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col)) >> this->quantization_right_shift;
+      }
+    }
+  }
+  else {
+    if(this->norm_option_shift) {
+      for(auto col=0; col<this->NR_COLUMN; col++) {
+        xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col) = (xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col)) >> xt::view(this->nqs, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8));
+      }
+    }
+    else {
+      for(auto col=0; col<this->NR_COLUMN; col++) {
+        xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col) = (xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col)) >> this->quantization_right_shift;
+      }
+    }
+  }
+  return (int) cycles;
+}
+
+template<class Geometry>
+bool HwpeEngine<Geometry>::normquant_bias_exit_idx() {
+  if(this->nqb_iter == 3) {
+    return true;
+  }
+  else {
+    return false;
+  }
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::normquant_bias_update_idx() {
+  this->nqb_iter++;
+}
+
+/*
+ * STREAMOUT
+ */
+
+template<class Geometry>
+void HwpeEngine<Geometry>::streamout_setup() {
+
+  auto tp = this->depthwise ? this->TP_IN_S : this->TP_OUT;
+
+  auto outfeat_hom_iter = this->H_SIZE * this->outfeat_d2_stride;
+  auto outfeat_wom_iter = this->W_SIZE * this->outfeat_d1_stride;
+
+  auto base_addr_y = this->outfeat_ptr + this->i_major*outfeat_hom_iter + this->j_major*outfeat_wom_iter + this->k_out_major*tp*this->quantization_bits/8;
+
+  auto streamout_k_out_lim = !this->depthwise ? this->mv_k_out_lim : (this->k_out_major == this->subtile_nb_ko-1 && this->subtile_rem_ko != this->TP_IN_S && this->subtile_rem_ko != 0) ? this->subtile_rem_ko : this->TP_IN;
+
+  auto h_size_out_X_w_size_out_with_strb = (this->quantization_bits == 8) || (streamout_k_out_lim <= 8)  ? this->NR_COLUMN   :
+                                                                             (streamout_k_out_lim <= 16) ? 2*this->NR_COLUMN :
+                                                                             (streamout_k_out_lim <= 24) ? 3*this->NR_COLUMN : 4*this->NR_COLUMN;
+
+  this->col_enable = xt::zeros<int32_t>({this->H_SIZE, this->W_SIZE});
+  for(auto i=0; i<this->h_size_out; i++) {
+    for(auto j=0; j<this->w_size_out; j++) {
+      xt::view(this->col_enable, i, j) = 1;
+    }
+  }
+  if(this->strided2x2) {
+    xt::view(this->col_enable, 0, 1) = 0;
+    xt::view(this->col_enable, 1, xt::all()) = 0;
+    xt::view(this->col_enable, 2, 1) = 0;
+  }
+
+  this->vst_y = VectorStore(
+    this,
+    base_addr_y, // base_addr
+    h_size_out_X_w_size_out_with_strb*(this->quantization_bits == 32 ? (streamout_k_out_lim/8 > 0 ? streamout_k_out_lim/8 + (streamout_k_out_lim%8 == 0 ? 0 : 1) : 1) : 1), // word_length
+    this->outfeat_d0_stride, // word_stride
+    this->quantization_bits == 32 ? (streamout_k_out_lim/8 > 0 ? streamout_k_out_lim/8 + (streamout_k_out_lim%8 == 0 ? 0 : 1) : 1) : 1, //w_size_out, // line_length
+    this->outfeat_d1_stride, // line_stride
+    this->H_SIZE, // block_length
+    this->outfeat_d2_stride, // block_stride
+    false
+  );
+
+  this->streamout_k_out_lim = this->quantization_bits == 32 ? (this->depthwise ? this->TP_IN/8 : tp/8) : 1;
+  if(this->k_out_major == this->subtile_nb_ko-1 && this->subtile_rem_ko != tp && this->subtile_rem_ko != 0) { // last k_in tile, only if it requires padding
+    this->streamout_k_out_lim = this->quantization_bits == 32 ? this->subtile_rem_ko/8 + (this->subtile_rem_ko%8 == 0 ? 0 : 1) : 1;
+  }
+  this->streamout_k_out_iter = 0;
+  this->streamout_i_out_iter = 0;
+  this->streamout_j_out_iter = 0;
+
+  // relu is here because of easier modeling
+  if(this->quantization_bits == 8 && (this->output_quant || Geometry::CLIP_UNQUANTIZED_OUTPUT)) {
+    if(this->use_relu) {
+      xt::view(this->accum, xt::all()) = xt::clip(this->accum, 0, this->signed_activation ? 127 : 255);
+    }
+    else {
+      xt::view(this->accum, xt::all()) = xt::clip(this->accum, -128, 127);
+    }
+  }
+  else if(this->use_relu && this->output_quant) {
+    xt::view(this->accum, xt::all()) = xt::clip(this->accum, 0, 0xffffffff);
+  }
+  if(this->accum_traces) {
+    this->debug_accum();
+  }
+
+  if(this->trace_level == L3_ALL) {
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "   k_out=%d\n", this->k_out);
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "   w_out=%d\n", this->w_out);
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "   h_size_out=%d\n", this->h_size_out);
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "   w_size_out=%d\n", this->w_size_out);
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "   i_major=%d\n", this->i_major);
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "   j_major=%d\n", this->j_major);
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "   k_out_major=%d\n", this->k_out_major);
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "   tp=%d\n", tp);
+  }
+}
+
+template<class Geometry>
+int HwpeEngine<Geometry>::streamout_cycle() {
+  int64_t cycles = 0;
+  auto tp = this->depthwise ? this->TP_IN_S : this->TP_OUT;
+  xt::xarray<uint8_t> xx = xt::zeros<uint8_t>({32});
+  if(this->quantization_bits == 32) {
+    // groups of 8 channels, the last one of a depthwise tile can be partial
+    auto k_out_last = std::min((this->streamout_k_out_iter+1)*8, tp);
+    if(this->k_out_major == this->subtile_nb_ko-1 && this->subtile_rem_ko != tp && this->subtile_rem_ko != 0) { // last k_in tile, only if it requires padding
+      k_out_last = k_out_last < this->subtile_rem_ko ? k_out_last : this->subtile_rem_ko;
+    }
+    for (auto i=this->streamout_k_out_iter*8; i<k_out_last; i++) {
+      for(auto j=0; j<4; j++) {
+        xt::view(xx, (i-this->streamout_k_out_iter*8)*4+j) = (xt::view(this->accum, i, this->streamout_i_out_iter*this->W_SIZE+this->streamout_j_out_iter) >> (j*8)) & 0xff;
+      }
+    }
+    this->vst_y.ex(xx, (k_out_last-this->streamout_k_out_iter*8)*4, cycles, this->col_enable (this->streamout_i_out_iter, this->streamout_j_out_iter));
+  }
+  else if(this->quantization_bits == 8) {
+    auto k_out_last = tp;
+    if(this->k_out_major == this->subtile_nb_ko-1 && this->subtile_rem_ko != tp && this->subtile_rem_ko != 0) { // last k_in tile, only if it requires padding
+      k_out_last = this->subtile_rem_ko;
+    }
+    for (auto i=0; i<k_out_last; i++) {
+      xt::view(xx, i) = xt::view(this->accum, i, this->streamout_i_out_iter*this->W_SIZE+this->streamout_j_out_iter);
+    }
+    this->vst_y.ex(xx, k_out_last, cycles, this->col_enable (this->streamout_i_out_iter, this->streamout_j_out_iter));
+  }
+  return (int) cycles;
+}
+
+template<class Geometry>
+bool HwpeEngine<Geometry>::streamout_exit_idx() {
+  auto h_size_out = this->mode_linear ? 1 : this->h_size_out;
+  auto w_size_out = this->mode_linear ? 1 : this->w_size_out;
+  if(this->streamout_i_out_iter == h_size_out-1 && this->streamout_j_out_iter == w_size_out-1 && this->streamout_k_out_iter == this->streamout_k_out_lim-1) {
+    return true;
+  }
+  else {
+    return false;
+  }
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::streamout_update_idx() {
+  if(this->streamout_k_out_iter < this->streamout_k_out_lim-1) {
+    this->streamout_k_out_iter++;
+  }
+  else if(this->streamout_j_out_iter < this->W_SIZE-1) {
+    this->streamout_k_out_iter = 0;
+    this->streamout_j_out_iter++;
+  }
+  else {
+    this->streamout_k_out_iter = 0;
+    this->streamout_j_out_iter = 0;
+    this->streamout_i_out_iter++;
+  }
+}
+
+template<class Geometry>
+bool HwpeEngine<Geometry>::streamout_to_end_idx() {
+  if((this->k_out_major == this->subtile_nb_ko-1) && (this->i_major == this->subtile_nb_ho-1) && (this->j_major == this->subtile_nb_wo-1)) {
+    return true;
+  }
+  else {
+    return false;
+  }
+}
+
+/*
+ * INDEX
+ */
+
+template<class Geometry>
+void HwpeEngine<Geometry>::k_in_major_update_idx() {
+  this->k_in_major_iter++;
+  if(this->trace_level == L3_ALL) {
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "  k_out_major=%d\n", this->k_out_major);
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "  i_major=%d\n", this->i_major);
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "  j_major=%d\n", this->j_major);
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "  k_in_major_iter=%d\n", this->k_in_major);
+  }
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::high_update_idx() {
+  if(this->j_major == this->subtile_nb_wo-1 && this->i_major == this->subtile_nb_ho-1) {
+    this->k_out_major++;
+    this->i_major = 0;
+    this->j_major = 0;
+    this->k_in_major_iter = 0;
+  }
+  else if(this->j_major == this->subtile_nb_wo-1) {
+    this->i_major++;
+    this->j_major = 0;
+    this->k_in_major_iter = 0;
+  }
+  else {
+    this->j_major++;
+    this->k_in_major_iter = 0;
+  }
+}
+
+#endif /* __HWPE_DATAPATH_HPP__ */
@@ -0,0 +1,1001 @@
+/*
+ * Copyright (C) 2020-2022  GreenWaves Technologies, ETH Zurich, University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Francesco Conti, University of Bologna & GreenWaves Technologies (f.conti@unibo.it)
+ *          Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+#ifndef __HWPE_ENGINE_HPP__
+#define __HWPE_ENGINE_HPP__
+
+#include <vp/vp.hpp>
+#include <vp/itf/io.hpp>
+#include <vector>
+#include <array>
+#include <deque>
+#include <algorithm>
+#include <stdio.h>
+#include <inttypes.h>
+#include "xtensor/xarray.hpp"
+#include "xtensor/xio.hpp"
+#include "xtensor/xview.hpp"
+#include "xtensor/xadapt.hpp"
+#include "xtensor/xpad.hpp"
+
+/*
+ * Common engine shared by the NE16 and Neureka accelerator models.
+ *
+ * The engine is templated on a geometry traits struct which must provide the
+ * following compile-time constants:
+ *
+ *   TP_IN, TP_IN_LINEAR, TP_OUT, QA_IN, QA_OUT   input/output channel parallelism and precision
+ *   TP_IN_S                                      channel parallelism of depthwise and 3x3 layers
+ *   H_SIZE, W_SIZE                               spatial size of the output tile (NR_COLUMN = H_SIZE*W_SIZE)
+ *   COLUMN_SIZE, BLOCK_SIZE                      BinConv column and block sizes
+ *   F_BUFFER_SIZE, FILTER_SIZE                   feature buffer and filter sizes
+ *   SHIFT_CYCLES, QUANT_PER_CYCLE                datapath timing
+ *   OVERHEAD_LD_1X1, OVERHEAD_LD_3X3, OVERHEAD_MV
+ *   NB_REG                                       number of job registers per context
+ *   L1_MASK                                      address mask applied on the master port
+ *   CLIP_UNQUANTIZED_OUTPUT                      8-bit outputs are clipped even without output quantization
+ *
+ * and the FeatType type of the feature buffers (signed or unsigned activations).
+ *
+ * The engine implements the HWPE slave port, the register file contexts and the
+ * job queue, and the datapath stages which are common to the accelerators:
+ * streamers (hwpe_stream.hpp), and clear, streamin, normquant, streamout, index
+ * update, feature padding, load prefetch and fast BinConv kernels
+ * (hwpe_datapath.hpp). The accelerator model derives from it and provides the
+ * register decoding, the load and matrix-vector stages, and the FSM event
+ * handlers which sequence the stages.
+ *
+ * Jobs can be offloaded in two ways:
+ *   - register mode: the core acquires one of the nb_contexts register contexts,
+ *     programs it and commits it. An event is raised at the end of each job.
+ *   - command-list mode: the core writes the address of an array of job
+ *     descriptors to CMDLIST_PTR and the number of descriptors to CMDLIST_LEN.
+ *     Each descriptor has the same layout as the job registers (NB_REG words).
+ *     The engine fetches them through its master port and executes them back to
+ *     back, and raises a single event at the end of the list.
+ *
+ * The standard HWPE control registers occupy offsets 0x00 to 0x1c. Writing
+ * SOFT_CLEAR aborts the running job and clears the job queue and the register
+ * contexts. The command list and performance counter registers are extensions
+ * of the model, placed at 0x200 and above so that they do not alias them.
+ *
+ * A block of performance counters is kept for each job ID (see HwpePerfCounter).
+ * The core selects a counter by writing (job_id << 8) | index to PERF_SEL and
+ * reads it from PERF_DATA, bit 7 of the index selecting the upper 32 bits. When
+ * the "stats" trace is active, the counters summed over all the jobs and the
+ * ones of the last job run with each ID are dumped at the end of the simulation.
+ */
+
+enum HwpeState {
+    IDLE,
+    START,
+    START_STREAMIN,
+    STREAMIN_LOAD,
+    LOAD_MATRIXVEC,
+    STREAMIN,
+    LOAD,
+    MATRIXVEC,
+    NORMQUANT_SHIFT,
+    NORMQUANT_MULT,
+    NORMQUANT_BIAS,
+    STREAMOUT,
+    END
+};
+
+// Streamers, the accesses done by the datapath are attributed to them from the
+// FSM state which does them
+enum HwpeStreamer {
+    STREAMER_STREAMIN,
+    STREAMER_FEAT,
+    STREAMER_WEIGHT,
+    STREAMER_NORMQUANT,
+    STREAMER_STREAMOUT,
+    NB_STREAMERS
+};
+
+// Index of the performance counters of a job
+enum HwpePerfCounter {
+    PERF_STATE_CYCLES   = 0,   // + HwpeState, cycles spent in each FSM state
+    PERF_STREAMER_BYTES = 16,  // + HwpeStreamer, bytes transferred by each streamer
+    PERF_STALL_CYCLES   = 24,  // cycles spent waiting for memory latency
+    PERF_MAC_ACTIVE     = 25,  // BinConv lanes enabled
+    PERF_MAC_PEAK       = 26,  // BinConv lanes available over the same cycles
+    PERF_JOB_CYCLES     = 27,  // total job duration
+    PERF_NB             = 28
+};
+
+enum HwpeTraceLevel {
+    L0_CONFIG,
+    L1_ACTIV_INOUT,
+    L2_DEBUG,
+    L3_ALL
+};
+
+#include <hwpe_stream.hpp>
+
+template<class Geometry>
+class HwpeEngine : public vp::Component
+{
+public:
+    // HARDWARE parameters, fixed at compile time by the geometry
+    static constexpr int TP_IN           = Geometry::TP_IN;
+    static constexpr int TP_IN_S         = Geometry::TP_IN_S;
+    static constexpr int TP_IN_LINEAR    = Geometry::TP_IN_LINEAR;
+    static constexpr int TP_OUT          = Geometry::TP_OUT;
+    static constexpr int QA_IN           = Geometry::QA_IN;
+    static constexpr int QA_OUT          = Geometry::QA_OUT;
+    static constexpr int H_SIZE          = Geometry::H_SIZE;
+    static constexpr int W_SIZE          = Geometry::W_SIZE;
+    static constexpr int NR_COLUMN       = Geometry::H_SIZE * Geometry::W_SIZE;
+    static constexpr int COLUMN_SIZE     = Geometry::COLUMN_SIZE;
+    static constexpr int BLOCK_SIZE      = Geometry::BLOCK_SIZE;
+    static constexpr int F_BUFFER_SIZE   = Geometry::F_BUFFER_SIZE;
+    static constexpr int FILTER_SIZE     = Geometry::FILTER_SIZE;
+    static constexpr int SHIFT_CYCLES    = Geometry::SHIFT_CYCLES;
+    static constexpr int OVERHEAD_LD_1X1 = Geometry::OVERHEAD_LD_1X1;
+    static constexpr int OVERHEAD_LD_3X3 = Geometry::OVERHEAD_LD_3X3;
+    static constexpr int OVERHEAD_MV     = Geometry::OVERHEAD_MV;
+    static constexpr int QUANT_PER_CYCLE = Geometry::QUANT_PER_CYCLE;
+
+    // REGISTER MAP
+    static constexpr int NB_REG                   = Geometry::NB_REG;
+    static constexpr int SPECIAL_TRACE_REG        = NB_REG;
+    static constexpr int SPECIAL_FORMAT_TRACE_REG = NB_REG + 1;
+
+    // HWPE CTRL registers (offsets from the base of the slave port)
+    static constexpr int CTRL_TRIGGER     = 0x00;
+    static constexpr int CTRL_ACQUIRE     = 0x04;
+    static constexpr int CTRL_FINISHED    = 0x08;
+    static constexpr int CTRL_STATUS      = 0x0c;
+    static constexpr int CTRL_RUNNING_JOB = 0x10;
+    static constexpr int CTRL_SOFT_CLEAR  = 0x14;
+    static constexpr int CTRL_SWSYNC      = 0x18;
+    static constexpr int CTRL_JOB_REGS    = 0x20;
+
+    // Model extension registers, decoded before the HWPE CTRL ones
+    static constexpr int CTRL_CMDLIST_PTR = 0x200;
+    static constexpr int CTRL_CMDLIST_LEN = 0x204;
+    static constexpr int CTRL_PERF_SEL    = 0x208;
+    static constexpr int CTRL_PERF_DATA   = 0x20c;
+
+    typedef typename Geometry::FeatType FeatType;
+    typedef HwpeVectorLoad<Geometry, uint8_t> VectorLoad;
+    typedef HwpeVectorStore<Geometry, uint8_t> VectorStore;
+
+    HwpeEngine(vp::ComponentConf &config);
+
+    void reset(bool active);
+    void stop();
+
+    // were private before, but did not work with stream.hpp
+    vp::IoReq io_req;
+    vp::Trace trace;
+    vp::Trace stats_trace;      // end-of-simulation counters, dumped by stop() when active
+    vp::IoMaster out;
+    vp::IoMaster wmem_out;  // weight memory, only registered by the accelerators which have one
+    vp::reg_32 state;
+    vp::reg_8 activity;
+    HwpeTraceLevel trace_level;
+    int trace_format;
+
+    // PERFORMANCE COUNTERS, updated by the accelerator and its streamers for the running job
+    void perf_state(int state, int64_t cycles);
+    void perf_access(int bytes, int64_t latency);
+    void perf_mac(int64_t active, int64_t peak);
+
+protected:
+    static vp::IoReqStatus hwpe_slave(vp::Block *__this, vp::IoReq *req);
+
+    // REGISTER FILE member functions
+    int  regfile_rd(int);
+    void regfile_wr(int, int);
+    void commit();
+    int  acquire();
+    bool status();
+    void soft_clear();
+
+    // JOB control, called by the FSM handlers of the accelerator
+    void job_start();
+    int  job_end();
+    bool job_available();
+    int *job_regs();
+
+    // COMMAND LIST member functions
+    void    cmdlist_start(uint32_t nb_jobs);
+    int64_t cmdlist_fetch();
+
+    // PERFORMANCE COUNTERS
+    uint32_t perf_read();
+    void     perf_dump();
+    void     perf_dump_counters(const char *name, std::array<int64_t, PERF_NB> &counters);
+
+    // REGISTER FILE and HWPE CTRL
+    int  nb_contexts;
+    std::vector<int> cxt;  // nb_contexts contexts of NB_REG registers each
+    int  cxt_cfg_ptr;
+    int  cxt_use_ptr;
+    int  job_pending;
+    int  job_state;
+    unsigned char job_id;
+    std::vector<int> cxt_job_id;
+    char running_job_id;
+    int  job_running;
+
+    // COMMAND LIST state
+    uint32_t cmdlist_ptr;
+    int  cmdlist_remaining;     // jobs of the list not yet completed
+    int  cmdlist_fetched;       // descriptors of the list already fetched
+    bool cmdlist_desc_valid;    // cmdlist_desc holds a fetched descriptor not yet started
+    std::vector<int> cmdlist_desc;
+    int  cmdlist_job_id;
+    bool job_cmdlist;           // running job comes from the command list
+
+    // PERFORMANCE COUNTERS
+    std::vector<std::array<int64_t, PERF_NB>> perf_jobs;  // indexed by job ID
+    std::array<int64_t, PERF_NB> perf_total;  // summed over all the ended jobs, for the final dump
+    int64_t  perf_nb_jobs;
+    uint32_t perf_sel;
+    int64_t  perf_job_start;
+
+    // DEBUG settings, updated from the trace level at each FSM step
+    bool fsm_traces;
+    bool accum_traces;
+    bool accum_traces_poststreamin;
+    bool accum_traces_postmatrixvec;
+    bool accum_traces_normquant;
+    bool accum_traces_streamout;
+    bool psum_block_traces;
+    bool x_buffer_traces;
+    bool x_buffer_traces_postload;
+    bool binconv_traces;
+    void debug_traces_update();
+    void debug_accum();
+
+    // REGISTER FILE configuration parameters, decoded by the accelerator
+    int weights_ptr;
+    int infeat_ptr;
+    int outfeat_ptr;
+    int scale_ptr;
+    int scale_shift_ptr;
+    int scale_bias_ptr;
+    int infeat_d0_stride;
+    int infeat_d1_stride;
+    int infeat_d2_stride;
+    int weights_d0_stride;
+    int weights_d1_stride;
+    int weights_d2_stride;
+    int outfeat_d0_stride;
+    int outfeat_d1_stride;
+    int outfeat_d2_stride;
+    int subtile_nb_ko;
+    int subtile_rem_ko;
+    int subtile_nb_ki;
+    int subtile_rem_ki;
+    int subtile_nb_ho;
+    int subtile_rem_ho;
+    int subtile_nb_wo;
+    int subtile_rem_wo;
+    int subtile_rem_hi;
+    int subtile_rem_wi;
+    int padding_top;
+    int padding_right;
+    int padding_bottom;
+    int padding_left;
+    int padding_value;
+    int Wmin;
+    bool norm_option_shift;
+    bool norm_option_bias;
+    int fs;
+    int output_quant;
+    int normalization_bits;
+    int quantization_bits;
+    int quantization_right_shift;
+    bool use_relu;
+    bool streamin;
+    int filter_mask_top;
+    int filter_mask_right;
+    int filter_mask_bottom;
+    int filter_mask_left;
+    bool mode16;
+    bool mode_linear;
+    bool strided2x2;
+    int qw;
+    bool depthwise;
+    bool signed_activation;
+
+    // CONVENIENCE configuration
+    int h_out;
+    int w_out;
+    int k_out;
+    int k_in;
+    int h_out_int;
+    int w_out_int;
+    int h_in_int;
+    int w_in_int;
+    int h_in;
+    int w_in;
+
+    // STATEFUL BUFFERS
+    xt::xarray<int64_t> psum_block;  // partial sums at the output of a BinConv Block  (no actual storage)
+    xt::xarray<int64_t> psum_column; // partial sums at the output of a BinConv Column (no actual storage)
+    xt::xarray<int64_t> accum;       // accumulators (*actual storage*)
+    xt::xarray<int64_t> accum_save;
+    xt::xarray<FeatType> x_buffer;    // feature buffer (*actual storage*)
+    xt::xarray<FeatType> x_buffer_linear; // feature buffer (*actual storage* -- representation for linear case)
+    xt::xarray<FeatType> x_array;     // reordered feature array (no actual storage)
+    xt::xarray<uint8_t> weight;      // input weight stream
+
+    // CLEAR
+    void clear_all();
+    void clear_accum();
+    void clear_x_buffer();
+
+    // STREAMIN
+    void constant_setup();
+    void streamin_setup();
+    int  streamin_cycle();
+    bool streamin_exit_idx();
+    void streamin_update_idx();
+
+    // LOAD, the streamer and buffer walk is done by the accelerator
+    void     load_do_padding();
+    uint64_t load_padding_mask();
+    void load_prefetch_sync();
+    int  load_prefetch_account(int latency);
+    int  load_prefetch_stall();
+    void load_prefetch_release(int64_t mv_end);
+
+    // MATRIXVEC, fast kernels on raw buffers
+    void __BinConvArrayFast(const uint8_t *, int, int, int, const xt::xarray<int32_t>&, const xt::xarray<int32_t>&, bool=false, bool=false);
+    void __matrixvec_check(const xt::xarray<int64_t>&, const char *);
+
+    // NORMQUANT
+    void normquant_shift_setup();
+    int  normquant_shift_cycle();
+    void normquant_mult_setup();
+    int  normquant_mult_cycle();
+    bool normquant_mult_exit_idx();
+    void normquant_mult_update_idx();
+    void normquant_bias_setup();
+    int  normquant_bias_cycle();
+    bool normquant_bias_exit_idx();
+    void normquant_bias_update_idx();
+
+    // STREAMOUT
+    void streamout_setup();
+    int  streamout_cycle();
+    bool streamout_exit_idx();
+    void streamout_update_idx();
+    bool streamout_to_end_idx();
+
+    // INDEX
+    void k_in_major_update_idx();
+    void high_update_idx();
+
+    // INDEX state
+    int k_out_major;
+    int i_major;
+    int j_major;
+    int k_in_major_iter;
+    int k_in_major;
+    int h_size_in;
+    int w_size_in;
+    int h_size_out;
+    int w_size_out;
+    int h_size_in_hw;
+    int w_size_in_hw;
+    int h_size_in_X_w_size_in;
+    int h_size_out_X_w_size_out;
+    int k_out_lim_dw;
+    int dw_lim;
+    int dw_iter;
+
+    // STREAMIN state
+    int streamin_ij_out;
+    VectorLoad vld_streamin;
+    int streamin_i_out_iter;
+    int streamin_i_out_lim;
+    int streamin_j_out_iter;
+    int streamin_j_out_lim;
+    int streamin_k_out_iter;
+    int streamin_k_out_lim;
+
+    // LOAD state
+    int load_fbuf_lim;
+    int load_i_fbuf_lim;
+    int load_j_fbuf_lim;
+    int load_k_in_lim;
+    std::vector<uint32_t> load_padding;
+    int load_i_fbuf;
+    int load_j_fbuf;
+    VectorLoad vld_x;
+    xt::xarray<int32_t> row_enable;
+    int nb_row_enable;                 // rows set in row_enable, counted when it is built
+    std::vector<int64_t> load_padding_mask_cache; // per-job cache of padding masks, indexed by tile edges and size
+
+    // LOAD prefetch state (double-buffered streamer model)
+    int prefetch_depth;                // number of feature tiles which can be loaded ahead of MATRIXVEC, 0 to disable
+    int64_t prefetch_load_cycles;      // cycles spent by the streamer on the tile being loaded
+    int64_t prefetch_load_end;         // cycle at which the streamer finished the last load
+    bool prefetch_load_done;           // a tile was loaded since the last MATRIXVEC setup
+    std::deque<int64_t> prefetch_mv_end; // cycles at which MATRIXVEC released the last feature buffers
+
+    // MATRIXVEC state
+    int mv_k_out_iter;
+    int mv_k_out_lim;
+    int mv_qw_iter; // was simply qw
+    int mv_qw_lim; // was simply qw
+    xt::xarray<int32_t> mac_enable;
+    int nb_mac_enable;                 // lanes set in mac_enable, counted when it is built
+    bool matrixvec_fast;   // use the raw-buffer BinConv kernels instead of the generic xtensor path
+    bool matrixvec_check;  // also run the generic path and check that both give the same accumulators
+
+    // NORMQUANT state
+    VectorLoad vld_nqs;
+    VectorLoad vld_nq;
+    VectorLoad vld_nqb;
+    xt::xarray<uint8_t> nqs;
+    int nq_iter;
+    int nq_lim;
+    int nqb_iter;
+    int nqb_lim;
+
+    // STREAMOUT state
+    int streamout_i_out_iter;
+    int streamout_i_out_lim;
+    int streamout_j_out_iter;
+    int streamout_j_out_lim;
+    int streamout_k_out_iter;
+    int streamout_k_out_lim;
+    VectorStore vst_y;
+    xt::xarray<int32_t> col_enable;
+
+    vp::IoSlave in;
+    vp::WireMaster<bool> irq;
+
+    // Created by the accelerator model, which owns the FSM handlers
+    vp::ClockEvent *fsm_start_event;
+    vp::ClockEvent *fsm_event;
+    vp::ClockEvent *fsm_end_event;
+};
+
+
+template<class Geometry>
+HwpeEngine<Geometry>::HwpeEngine(vp::ComponentConf &config)
+    : vp::Component(config)
+{
+    this->traces.new_trace("trace", &this->trace, vp::DEBUG);
+    this->traces.new_trace("stats", &this->stats_trace, vp::DEBUG);
+
+    this->new_master_port("out", &this->out);
+
+    this->new_master_port("irq", &this->irq);
+
+    this->in.set_req_meth(&HwpeEngine<Geometry>::hwpe_slave);
+    this->new_slave_port("input", &this->in);
+
+    this->nb_contexts = this->get_js_config()->get_int("nb_contexts");
+    this->cxt.resize(this->nb_contexts * NB_REG);
+    this->cxt_job_id.resize(this->nb_contexts);
+    this->cmdlist_desc.resize(NB_REG);
+
+    this->perf_jobs.resize(256);
+
+    this->prefetch_depth = this->get_js_config()->get_child_int("prefetch_depth");
+    this->matrixvec_fast = this->get_js_config()->get_child_bool("matrixvec_fast");
+    this->matrixvec_check = this->get_js_config()->get_child_bool("matrixvec_check");
+    this->signed_activation = false;
+
+    this->trace_level = L0_CONFIG;
+    this->trace_format = 1;
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::reset(bool active)
+{
+    this->cxt_cfg_ptr     = 0;
+    this->cxt_use_ptr     = 0;
+    this->job_pending     = 0;
+    this->job_state       = 0;
+    this->job_id          = 0;
+    std::fill(this->cxt_job_id.begin(), this->cxt_job_id.end(), -1);
+    this->running_job_id  = 0;
+    this->job_running     = 0;
+    this->cmdlist_ptr     = 0;
+    this->cmdlist_remaining  = 0;
+    this->cmdlist_fetched    = 0;
+    this->cmdlist_desc_valid = false;
+    this->job_cmdlist     = false;
+    this->perf_sel        = 0;
+    this->perf_job_start  = 0;
+    for (auto &counters: this->perf_jobs) {
+        counters.fill(0);
+    }
+    this->perf_total.fill(0);
+    this->perf_nb_jobs    = 0;
+
+    // All registers should be initialized here, so that cluster reset is properly working
+    // This will be called first with active=1 and then with active=0
+    this->psum_block      = xt::zeros<int64_t>({this->NR_COLUMN, this->COLUMN_SIZE});
+    this->psum_column     = xt::zeros<int64_t>({this->NR_COLUMN});
+    this->accum           = xt::zeros<int64_t>({this->TP_OUT, this->NR_COLUMN});
+    this->x_buffer        = xt::zeros<FeatType>({this->F_BUFFER_SIZE, this->F_BUFFER_SIZE, this->TP_IN});
+    this->x_buffer_linear = xt::zeros<FeatType>({32, this->TP_IN});
+    this->x_array         = xt::zeros<FeatType>({this->NR_COLUMN, this->COLUMN_SIZE, this->TP_IN});
+    this->weight          = xt::zeros<uint8_t>({this->FILTER_SIZE*this->FILTER_SIZE, this->TP_IN/8});
+    this->nqs             = xt::zeros<uint8_t>({this->TP_OUT});
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::stop()
+{
+    if (this->stats_trace.get_active()) {
+        this->perf_dump();
+    }
+}
+
+// The `hwpe_slave` member function models an access to the HWPE SLAVE interface
+template<class Geometry>
+vp::IoReqStatus HwpeEngine<Geometry>::hwpe_slave(vp::Block *__this, vp::IoReq *req)
+{
+    HwpeEngine<Geometry> *_this = (HwpeEngine<Geometry> *)__this;
+
+    if (_this->trace_level == L1_ACTIV_INOUT || _this->trace_level == L2_DEBUG || _this->trace_level == L3_ALL) {
+      _this->trace.msg(vp::Trace::LEVEL_DEBUG, "Received request (addr: 0x%x, size: 0x%x, is_write: %d, data: %p\n", req->get_addr(), req->get_size(), req->get_is_write(), req->get_data());
+    }
+    uint8_t *data = req->get_data(); // size depends on data get_size
+
+    // Dispatch the register file access to the correct function
+    if(req->get_is_write()) {
+        if(((req->get_addr() & 0xfff) - 0x20) >> 2 == SPECIAL_TRACE_REG) {
+            if(*data == 0) {
+                _this->trace_level = L0_CONFIG;
+                _this->trace.msg("Setting tracing level to L0_CONFIG\n");
+            }
+            else if(*data == 1) {
+                _this->trace_level = L1_ACTIV_INOUT;
+                _this->trace.msg("Setting tracing level to L1_ACTIV_INOUT\n");
+            }
+            else if(*data == 2) {
+                _this->trace_level = L2_DEBUG;
+                _this->trace.msg("Setting tracing level to L2_DEBUG\n");
+            }
+            else {
+                _this->trace_level = L3_ALL;
+                _this->trace.msg("Setting tracing level to L3_ALL\n");
+            }
+            return vp::IO_REQ_OK;
+        }
+        else if(((req->get_addr() & 0xfff) - 0x20) >> 2 == SPECIAL_FORMAT_TRACE_REG) {
+            _this->trace_format = *data;
+            _this->trace.msg("Setting tracing format to %s\n", *data?"Hex":"Dec");
+            return vp::IO_REQ_OK;
+        }
+        else if((req->get_addr() & 0xfff) == CTRL_CMDLIST_PTR) {
+            _this->cmdlist_ptr = *(uint32_t *) data;
+        }
+        else if((req->get_addr() & 0xfff) == CTRL_CMDLIST_LEN) {
+            _this->cmdlist_start(*(uint32_t *) data);
+        }
+        else if((req->get_addr() & 0xfff) == CTRL_PERF_SEL) {
+            _this->perf_sel = *(uint32_t *) data;
+        }
+        else if((req->get_addr() & 0x17f) == CTRL_TRIGGER) {
+            _this->commit();
+            if (!_this->job_running && !_this->fsm_start_event->is_enqueued() && *(uint32_t *) data == 0) {
+                _this->event_enqueue(_this->fsm_start_event, 1);
+            }
+        }
+        else if((req->get_addr() & 0x17f) == CTRL_SOFT_CLEAR) {
+            _this->soft_clear();
+        }
+        else if((req->get_addr() & 0x17f) < CTRL_JOB_REGS) {
+            // Event enable, software sync and the remaining control registers are not modeled
+        }
+        else {
+            if (_this->trace_level == L1_ACTIV_INOUT || _this->trace_level == L2_DEBUG || _this->trace_level == L3_ALL) {
+                _this->trace.msg(vp::Trace::LEVEL_DEBUG, "offset: %d data: %08x\n", ((req->get_addr() & 0x17f) - 0x20) >> 2, *(uint32_t *) data);
+            }
+            _this->regfile_wr(((req->get_addr() & 0x17f) - 0x20)>> 2, *(uint32_t *) data);
+        }
+    }
+    else {
+        if((req->get_addr() & 0xfff) == CTRL_CMDLIST_PTR) {
+            *(uint32_t *) data = _this->cmdlist_ptr;
+        }
+        else if((req->get_addr() & 0xfff) == CTRL_CMDLIST_LEN) {
+            // Returns the number of jobs of the command list which are not yet completed
+            *(uint32_t *) data = _this->cmdlist_remaining;
+        }
+        else if((req->get_addr() & 0xfff) == CTRL_PERF_SEL) {
+            *(uint32_t *) data = _this->perf_sel;
+        }
+        else if((req->get_addr() & 0xfff) == CTRL_PERF_DATA) {
+            *(uint32_t *) data = _this->perf_read();
+        }
+        else if((req->get_addr() & 0x17f) == CTRL_ACQUIRE) {
+            *(uint32_t *) data = _this->acquire();
+            if (_this->trace_level == L1_ACTIV_INOUT || _this->trace_level == L2_DEBUG || _this->trace_level == L3_ALL) {
+                _this->trace.msg("Returning %x\n", *(uint32_t *) data);
+            }
+        }
+        else if((req->get_addr() & 0x17f) == CTRL_STATUS) {
+            // One byte per context, only the first 4 contexts are visible
+            uint32_t status = 0;
+            for (int i=0; i<_this->nb_contexts && i<4; i++) {
+                status |= (_this->cxt_job_id[i]>=0 ? 1 : 0) << (i*8);
+            }
+            *(uint32_t *) data = status;
+            if (_this->trace_level == L1_ACTIV_INOUT || _this->trace_level == L2_DEBUG || _this->trace_level == L3_ALL) {
+                _this->trace.msg("Returning %x\n", *(uint32_t *) data);
+            }
+        }
+        else if((req->get_addr() & 0x17f) == CTRL_RUNNING_JOB) {
+            // Returns the active running job or the last jobid that was run
+            *(uint32_t *) data = _this->running_job_id;
+            if (_this->trace_level == L1_ACTIV_INOUT || _this->trace_level == L2_DEBUG || _this->trace_level == L3_ALL) {
+                _this->trace.msg("Returning %x\n", *(uint32_t *) data);
+            }
+        }
+        else if((req->get_addr() & 0x17f) < CTRL_JOB_REGS) {
+            *(uint32_t *) data = 0;
+        }
+        else {
+            *(uint32_t *) data = _this->regfile_rd(((req->get_addr() & 0x17f) - 0x20) >> 2);
+            if (_this->trace_level == L1_ACTIV_INOUT || _this->trace_level == L2_DEBUG || _this->trace_level == L3_ALL) {
+                _this->trace.msg("Returning %x\n", *(uint32_t *) data);
+            }
+        }
+    }
+
+    return vp::IO_REQ_OK;
+}
+
+// Registers below NB_REG are mapped to the context being configured, the
+// following ones give direct access to each context, one after the other.
+template<class Geometry>
+int HwpeEngine<Geometry>::regfile_rd(int addr) {
+  if(addr == SPECIAL_TRACE_REG) {
+    if(this->trace_level == L0_CONFIG) {
+      return 0;
+    }
+    else if(this->trace_level == L1_ACTIV_INOUT) {
+      return 1;
+    }
+    else if(this->trace_level == L2_DEBUG) {
+      return 2;
+    }
+    else {
+      return 3;
+    }
+  }
+  else if(addr < NB_REG) {
+    return this->cxt[this->cxt_cfg_ptr*NB_REG + addr];
+  }
+  else if (addr < (this->nb_contexts+1)*NB_REG) {
+    return this->cxt[addr - NB_REG];
+  }
+  else {
+    return 0;
+  }
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::regfile_wr(int addr, int value) {
+  if(addr == SPECIAL_TRACE_REG) {
+    if(value == 0) {
+      this->trace_level = L0_CONFIG;
+    }
+    else if(value == 1) {
+      this->trace_level = L1_ACTIV_INOUT;
+    }
+    else if(value == 2) {
+      this->trace_level = L2_DEBUG;
+    }
+    else {
+      this->trace_level = L3_ALL;
+    }
+  }
+  else if (addr == SPECIAL_FORMAT_TRACE_REG) {
+    this->trace_format = value;
+  }
+  else if(addr < NB_REG) {
+    this->cxt[this->cxt_cfg_ptr*NB_REG + addr] = value;
+  }
+  else if (addr < (this->nb_contexts+1)*NB_REG) {
+    this->cxt[addr - NB_REG] = value;
+  }
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::commit() {
+  this->trace.msg(vp::Trace::LEVEL_DEBUG, "JOB COMMITTED: job_state=%d job_pending=%d job_running=%d\n", this->job_state, this->job_pending, this->job_running);
+  this->job_pending++;
+  this->job_state = 0;
+  this->cxt_cfg_ptr = (this->cxt_cfg_ptr + 1) % this->nb_contexts;
+}
+
+template<class Geometry>
+int HwpeEngine<Geometry>::acquire() {
+  this->trace.msg(vp::Trace::LEVEL_DEBUG, "JOB ACQUIRED: job_state=%d job_pending=%d job_running=%d\n", this->job_state, this->job_pending, this->job_running);
+  if(this->job_state == 0 & this->job_pending < this->nb_contexts) {
+    int job_id = (int) this->job_id++;
+    this->cxt_job_id[this->cxt_cfg_ptr] = job_id;
+    this->job_state = -2;
+    return job_id;
+  }
+  else if(this->job_pending == this->nb_contexts) {
+    return -1;
+  }
+  else {
+    return this->job_state;
+  }
+}
+
+// Aborts the running job and drops all the queued ones. The performance
+// counters are kept so that they can still be read after the clear.
+template<class Geometry>
+void HwpeEngine<Geometry>::soft_clear() {
+  this->trace.msg(vp::Trace::LEVEL_INFO, "Soft clear\n");
+  if (this->fsm_start_event->is_enqueued()) {
+    this->event_cancel(this->fsm_start_event);
+  }
+  if (this->fsm_event->is_enqueued()) {
+    this->event_cancel(this->fsm_event);
+  }
+  if (this->fsm_end_event->is_enqueued()) {
+    this->event_cancel(this->fsm_end_event);
+  }
+  this->cxt_cfg_ptr        = 0;
+  this->cxt_use_ptr        = 0;
+  this->job_pending        = 0;
+  this->job_state          = 0;
+  this->job_running        = 0;
+  this->cmdlist_remaining  = 0;
+  this->cmdlist_fetched    = 0;
+  this->cmdlist_desc_valid = false;
+  this->job_cmdlist        = false;
+  std::fill(this->cxt.begin(), this->cxt.end(), 0);
+  std::fill(this->cxt_job_id.begin(), this->cxt_job_id.end(), -1);
+  this->activity.set(0);
+  this->state.set(IDLE);
+}
+
+template<class Geometry>
+bool HwpeEngine<Geometry>::status() {
+  this->trace.msg(vp::Trace::LEVEL_DEBUG, "job_state=%d job_pending=%d\n", this->job_state, this->job_pending);
+  if(this->job_state == 0 & this->job_pending == 0 & this->cmdlist_remaining == 0)
+    return false;
+  else
+    return true;
+}
+
+// Jobs programmed through the register contexts have priority over the
+// command list, as they have been committed before the list was started or
+// while it was executing.
+template<class Geometry>
+void HwpeEngine<Geometry>::job_start() {
+  this->job_cmdlist = this->job_pending == 0;
+  if (this->job_cmdlist) {
+    this->cmdlist_desc_valid = false;
+    this->running_job_id = this->cmdlist_job_id;
+  }
+  else {
+    this->running_job_id = this->cxt_job_id[this->cxt_use_ptr];
+  }
+  this->job_running = 1;
+  this->perf_jobs[(unsigned char)this->running_job_id].fill(0);
+  this->perf_job_start = this->clock.get_cycles();
+}
+
+// Releases the running job, notifies the core and schedules the next job if
+// any. Returns the ID of the job which has just ended.
+template<class Geometry>
+int HwpeEngine<Geometry>::job_end() {
+  int job_id;
+  int64_t latency = 1;
+  this->job_running = 0;
+  auto &counters = this->perf_jobs[(unsigned char)this->running_job_id];
+  counters[PERF_JOB_CYCLES] = this->clock.get_cycles() - this->perf_job_start;
+  if (this->stats_trace.get_active()) {
+    for (int i=0; i<PERF_NB; i++) {
+      this->perf_total[i] += counters[i];
+    }
+    this->perf_nb_jobs++;
+  }
+  if (this->job_cmdlist) {
+    job_id = this->cmdlist_job_id;
+    this->cmdlist_remaining--;
+    if (this->cmdlist_remaining == 0) {
+      this->irq.sync(true);
+    }
+    else {
+      latency += this->cmdlist_fetch();
+    }
+  }
+  else {
+    job_id = this->cxt_job_id[this->cxt_use_ptr];
+    this->cxt_job_id[this->cxt_use_ptr] = -1;
+    this->cxt_use_ptr = (this->cxt_use_ptr + 1) % this->nb_contexts;
+    this->job_pending--;
+    this->irq.sync(true);
+  }
+  this->trace.msg(vp::Trace::LEVEL_INFO, "Ending job (id=%d).\n", job_id);
+  if (!this->fsm_start_event->is_enqueued() && this->job_available()) {
+      this->event_enqueue(this->fsm_start_event, latency);
+      this->trace.msg(vp::Trace::LEVEL_INFO, "Starting a new job from the queue.\n");
+  }
+  return job_id;
+}
+
+template<class Geometry>
+bool HwpeEngine<Geometry>::job_available() {
+  return this->job_pending > 0 || this->cmdlist_desc_valid;
+}
+
+// Registers of the running job, to be decoded by the accelerator
+template<class Geometry>
+int *HwpeEngine<Geometry>::job_regs() {
+  if (this->job_cmdlist) {
+    return this->cmdlist_desc.data();
+  }
+  return &this->cxt[this->cxt_use_ptr*NB_REG];
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::cmdlist_start(uint32_t nb_jobs) {
+  if (this->cmdlist_remaining != 0) {
+    this->trace.force_warning("Command list started while another one is still running, ignoring (remaining: %d)\n", this->cmdlist_remaining);
+    return;
+  }
+  if (nb_jobs == 0) {
+    return;
+  }
+
+  this->trace.msg(vp::Trace::LEVEL_INFO, "Starting command list (addr: 0x%x, nb_jobs: %d)\n", this->cmdlist_ptr, nb_jobs);
+
+  this->cmdlist_remaining = nb_jobs;
+  this->cmdlist_fetched = 0;
+  int64_t latency = this->cmdlist_fetch();
+  if (!this->job_running && !this->fsm_start_event->is_enqueued()) {
+    this->event_enqueue(this->fsm_start_event, 1 + latency);
+  }
+}
+
+// Fetches the next descriptor of the command list through the master port.
+// Returns the number of cycles taken by the fetch, assuming one word per cycle.
+template<class Geometry>
+int64_t HwpeEngine<Geometry>::cmdlist_fetch() {
+  uint32_t addr = this->cmdlist_ptr + this->cmdlist_fetched * NB_REG * 4;
+  int64_t max_latency = 0;
+
+  for (int i=0; i<NB_REG; i++) {
+    this->io_req.init();
+    this->io_req.set_addr((addr + i*4) & Geometry::L1_MASK);
+    this->io_req.set_size(4);
+    this->io_req.set_data((uint8_t *)&this->cmdlist_desc[i]);
+    this->io_req.set_is_write(false);
+    int err = this->out.req(&this->io_req);
+    if (err == vp::IO_REQ_OK) {
+      int64_t latency = this->io_req.get_latency();
+      if (latency > max_latency) {
+        max_latency = latency;
+      }
+    }
+    else {
+      this->trace.fatal("Unsupported asynchronous reply\n");
+    }
+  }
+
+  this->cmdlist_fetched++;
+  this->cmdlist_job_id = this->job_id++;
+  this->cmdlist_desc_valid = true;
+
+  this->trace.msg(vp::Trace::LEVEL_DEBUG, "Fetched job descriptor (addr: 0x%x, job_id: %d)\n", addr, this->cmdlist_job_id);
+
+  return max_latency + NB_REG;
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::perf_state(int state, int64_t cycles) {
+  this->perf_jobs[(unsigned char)this->running_job_id][PERF_STATE_CYCLES + state] += cycles;
+}
+
+// Called by the streamers for each access. The latency is the one reported by
+// the memory on top of the nominal cycle, and is accounted as stall.
+template<class Geometry>
+void HwpeEngine<Geometry>::perf_access(int bytes, int64_t latency) {
+  int streamer;
+  switch (this->state.get()) {
+    case STREAMIN:        streamer = STREAMER_STREAMIN; break;
+    case LOAD:            streamer = STREAMER_FEAT; break;
+    case NORMQUANT_SHIFT:
+    case NORMQUANT_MULT:
+    case NORMQUANT_BIAS:  streamer = STREAMER_NORMQUANT; break;
+    case STREAMOUT:       streamer = STREAMER_STREAMOUT; break;
+    default:              streamer = STREAMER_WEIGHT; break;
+  }
+  auto &counters = this->perf_jobs[(unsigned char)this->running_job_id];
+  counters[PERF_STREAMER_BYTES + streamer] += bytes;
+  counters[PERF_STALL_CYCLES] += latency;
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::perf_mac(int64_t active, int64_t peak) {
+  auto &counters = this->perf_jobs[(unsigned char)this->running_job_id];
+  counters[PERF_MAC_ACTIVE] += active;
+  counters[PERF_MAC_PEAK] += peak;
+}
+
+template<class Geometry>
+uint32_t HwpeEngine<Geometry>::perf_read() {
+  int job_id = (this->perf_sel >> 8) & 0xff;
+  int index = this->perf_sel & 0x7f;
+  if (index >= PERF_NB) {
+    return 0;
+  }
+  int64_t value = this->perf_jobs[job_id][index];
+  return (this->perf_sel & 0x80) ? (uint32_t)(value >> 32) : (uint32_t)value;
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::perf_dump_counters(const char *name, std::array<int64_t, PERF_NB> &counters) {
+  static const char *state_names[] = {
+    "IDLE", "START", "START_STREAMIN", "STREAMIN_LOAD", "LOAD_MATRIXVEC", "STREAMIN", "LOAD",
+    "MATRIXVEC", "NORMQUANT_SHIFT", "NORMQUANT_MULT", "NORMQUANT_BIAS", "STREAMOUT", "END"
+  };
+  static const char *streamer_names[] = {
+    "streamin", "feat", "weight", "normquant", "streamout"
+  };
+
+  this->stats_trace.msg(vp::Trace::LEVEL_INFO, "%s: %" PRId64 " cycles, %" PRId64 " stall cycles, MAC utilization %.2f%% (%" PRId64 "/%" PRId64 ")\n",
+    name, counters[PERF_JOB_CYCLES], counters[PERF_STALL_CYCLES],
+    counters[PERF_MAC_PEAK] ? 100.0 * counters[PERF_MAC_ACTIVE] / counters[PERF_MAC_PEAK] : 0.0,
+    counters[PERF_MAC_ACTIVE], counters[PERF_MAC_PEAK]);
+  for (int i=START; i<=END; i++) {
+    if (counters[PERF_STATE_CYCLES + i]) {
+      this->stats_trace.msg(vp::Trace::LEVEL_INFO, "    %-16s %" PRId64 " cycles\n", state_names[i], counters[PERF_STATE_CYCLES + i]);
+    }
+  }
+  for (int i=0; i<NB_STREAMERS; i++) {
+    if (counters[PERF_STREAMER_BYTES + i]) {
+      this->stats_trace.msg(vp::Trace::LEVEL_INFO, "    %-16s %" PRId64 " bytes\n", streamer_names[i], counters[PERF_STREAMER_BYTES + i]);
+    }
+  }
+}
+
+template<class Geometry>
+void HwpeEngine<Geometry>::perf_dump() {
+  char name[32];
+  snprintf(name, sizeof(name), "%" PRId64 " jobs", this->perf_nb_jobs);
+  this->perf_dump_counters(name, this->perf_total);
+
+  for (int job_id=0; job_id<(int)this->perf_jobs.size(); job_id++) {
+    if (this->perf_jobs[job_id][PERF_JOB_CYCLES]) {
+      snprintf(name, sizeof(name), "job %d", job_id);
+      this->perf_dump_counters(name, this->perf_jobs[job_id]);
+    }
+  }
+}
+
+#include <hwpe_datapath.hpp>
+
+#endif /* __HWPE_ENGINE_HPP__ */
@@ -0,0 +1,432 @@
+/*
+ * Copyright (C) 2020-2022  GreenWaves Technologies, ETH Zurich, University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Francesco Conti, University of Bologna & GreenWaves Technologies (f.conti@unibo.it)
+ *          Arpan Suravi Prasad, ETH Zurich (prasadar@iis.ee.ethz.ch)
+ */
+
+#ifndef __HWPE_STREAM_HPP__
+#define __HWPE_STREAM_HPP__
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "xtensor/xarray.hpp"
+#include "xtensor/xio.hpp"
+#include "xtensor/xview.hpp"
+
+/*
+ * Streamers of the HWPE engine. They walk a 3D address pattern and move data
+ * between the datapath and the memory through the master port of the engine,
+ * whose addresses are masked with Geometry::L1_MASK as the accelerators can
+ * only access the L1 memory. Weight loads can instead go to the dedicated
+ * weight memory port (wmem_out) of the accelerators which have one, in which
+ * case the address is not masked.
+ */
+
+#define STREAM_MAX_WIDTH_BYTES 40
+
+template<class Geometry>
+class HwpeEngine;
+
+template<class Geometry>
+class HwpeStreamAccess {
+  public:
+    HwpeStreamAccess(
+      HwpeEngine<Geometry> *engine,
+      int base_addr,
+      int d0_length,
+      int d0_stride,
+      int d1_length,
+      int d1_stride,
+      int d2_length,
+      int d2_stride,
+      bool debug = false
+    );
+    void reset_iteration();
+    int iterate();
+    void print_config();
+    int get_base_addr();
+    int get_d0_length();
+    int get_d0_stride();
+    int get_d1_length();
+    int get_d1_stride();
+    int get_d2_length();
+    int get_d2_stride();
+
+  protected:
+    HwpeEngine<Geometry> *engine;
+    int base_addr;
+    int d0_length;
+    int d0_stride;
+    int d1_length;
+    int d1_stride;
+    int d2_length;
+    int d2_stride;
+    bool debug;
+    // internal
+    int current_addr;
+    int ba;
+    int la;
+    int wa;
+    int bc;
+    int wc;
+    int lc;
+    int oc;
+};
+
+template<class Geometry, class T>
+class HwpeVectorLoad : public HwpeStreamAccess<Geometry> {
+  public:
+    HwpeVectorLoad(
+      HwpeEngine<Geometry> *engine,
+      int base_addr,
+      int d0_length,
+      int d0_stride,
+      int d1_length,
+      int d1_stride,
+      int d2_length,
+      int d2_stride,
+      bool debug
+    );
+    HwpeVectorLoad();
+    xt::xarray<T> ex(int width, int64_t& cycles);
+    xt::xarray<T> ex(int width, bool w_demux, int64_t& cycles);
+};
+
+template<class Geometry, class T>
+class HwpeVectorStore : public HwpeStreamAccess<Geometry> {
+  public:
+    HwpeVectorStore(
+      HwpeEngine<Geometry> *engine,
+      int base_addr,
+      int d0_length,
+      int d0_stride,
+      int d1_length,
+      int d1_stride,
+      int d2_length,
+      int d2_stride,
+      bool debug
+    );
+    HwpeVectorStore();
+    xt::xarray<T> ex(xt::xarray<T> data, int width, int64_t& cycles, int32_t enable);
+};
+
+
+template<class Geometry>
+HwpeStreamAccess<Geometry>::HwpeStreamAccess(
+  HwpeEngine<Geometry> *engine,
+  int base_addr,
+  int d0_length,
+  int d0_stride,
+  int d1_length,
+  int d1_stride,
+  int d2_length,
+  int d2_stride,
+  bool debug
+) : engine ( engine ),
+    base_addr     ( base_addr    ),
+    d0_length   ( d0_length  ),
+    d0_stride   ( d0_stride  ),
+    d1_length   ( d1_length  ),
+    d1_stride   ( d1_stride  ),
+    d2_length  ( d2_length ),
+    d2_stride  ( d2_stride ),
+    debug         ( debug        ),
+    current_addr  ( 0            )
+{
+  this->reset_iteration();
+  if(this->debug) {
+    this->print_config();
+  }
+}
+
+template<class Geometry>
+int HwpeStreamAccess<Geometry>::get_base_addr() {
+  return this->base_addr;
+}
+template<class Geometry>
+int HwpeStreamAccess<Geometry>::get_d0_length() {
+  return this->d0_length;
+}
+template<class Geometry>
+int HwpeStreamAccess<Geometry>::get_d0_stride() {
+  return this->d0_stride;
+}
+template<class Geometry>
+int HwpeStreamAccess<Geometry>::get_d1_length() {
+  return this->d1_length;
+}
+template<class Geometry>
+int HwpeStreamAccess<Geometry>::get_d1_stride() {
+  return this->d1_stride;
+}
+template<class Geometry>
+int HwpeStreamAccess<Geometry>::get_d2_length() {
+  return this->d2_length;
+}
+template<class Geometry>
+int HwpeStreamAccess<Geometry>::get_d2_stride() {
+  return this->d2_stride;
+}
+
+template<class Geometry>
+void HwpeStreamAccess<Geometry>::print_config() {
+  std::cout << "[STREAMER] base_addr="  << std::hex << this->base_addr << std::dec << std::endl;
+  std::cout << "[STREAMER] tot_length=" << this->d0_length << std::endl;
+  std::cout << "[STREAMER] d0_stride="  << this->d0_stride << std::endl;
+  std::cout << "[STREAMER] d0_length="  << this->d1_length << std::endl;
+  std::cout << "[STREAMER] d1_stride="  << this->d1_stride << std::endl;
+  std::cout << "[STREAMER] d1_length="  << this->d2_length << std::endl;
+  std::cout << "[STREAMER] d2_stride="  << this->d2_stride << std::endl;
+}
+
+template<class Geometry>
+void HwpeStreamAccess<Geometry>::reset_iteration() {
+  this->wa = 0;
+  this->la = 0;
+  this->ba = 0;
+  this->wc = 1;
+  this->lc = 1;
+  this->bc = 1;
+  this->oc = 0;
+}
+
+template<class Geometry>
+int HwpeStreamAccess<Geometry>::iterate() {
+  if (this->d1_length < 0) {
+    this->current_addr = this->base_addr + this->wa;
+  }
+  else if(this->d2_length < 0) {
+    this->current_addr = this->base_addr + this->la + this->wa;
+  }
+  else {
+    this->current_addr = this->base_addr + this->ba + this->la + this->wa;
+  }
+  this->oc++;
+  if(this->debug) {
+    std::cout << "[STREAMER] wa=" << this->wa << " la=" << this->la << " ba=" << this->ba << " oc=" << this->oc << std::endl;
+    std::cout << "[STREAMER] wc=" << this->wc << " lc=" << this->lc << " bc=" << this->bc << " oc=" << this->oc << std::endl;
+  }
+  if((this->wc < this->d1_length) || (this->d1_length < 0)) {
+    this->wa += this->d0_stride;
+    this->wc += 1;
+  }
+  else if ((this->lc < this->d2_length) || (this->d2_length < 0)) {
+    this->wa = 0;
+    this->la += this->d1_stride;
+    this->wc = 1;
+    this->lc += 1;
+  }
+  else {
+    this->wa = 0;
+    this->la = 0;
+    this->ba += this->d2_stride;
+    this->wc = 1;
+    this->lc = 1;
+    this->bc += 1;
+  }
+  return this->current_addr;
+}
+
+template<class Geometry, class T>
+HwpeVectorLoad<Geometry, T>::HwpeVectorLoad(
+  HwpeEngine<Geometry> *engine,
+  int base_addr,
+  int d0_length,
+  int d0_stride,
+  int d1_length,
+  int d1_stride,
+  int d2_length,
+  int d2_stride,
+  bool debug
+) : HwpeStreamAccess<Geometry>(engine, base_addr, d0_length, d0_stride, d1_length, d1_stride, d2_length, d2_stride, debug) {
+}
+
+template<class Geometry, class T>
+HwpeVectorLoad<Geometry, T>::HwpeVectorLoad() : HwpeStreamAccess<Geometry>((HwpeEngine<Geometry> *) NULL, 0, 0, 0, 0, 0, 0, 0, false) {
+}
+
+template<class Geometry, class T>
+xt::xarray<T> HwpeVectorLoad<Geometry, T>::ex(int width, int64_t& cycles) {
+  return this->ex(width, false, cycles);
+}
+
+template<class Geometry, class T>
+xt::xarray<T> HwpeVectorLoad<Geometry, T>::ex(int width, bool w_demux, int64_t& cycles) {
+  auto addr = this->iterate();
+  uint8_t load_data[STREAM_MAX_WIDTH_BYTES];
+  auto width_padded = width + 4;
+  auto addr_padded = addr & ~0x3;
+  auto width_words = width_padded*sizeof(T)/4;
+  auto width_rem   = width_padded*sizeof(T)%4;
+  vp::IoMaster *port = w_demux ? &this->engine->wmem_out : &this->engine->out;
+  uint32_t mask = w_demux ? 0xffffffff : Geometry::L1_MASK;
+  int64_t max_latency = 0;
+  for(auto i=0; i<width_words; i++) {
+    this->engine->io_req.init();
+    this->engine->io_req.set_addr(addr_padded+i*4 & mask);
+    this->engine->io_req.set_size(4);
+    this->engine->io_req.set_data(load_data+i*4);
+    this->engine->io_req.set_is_write(false);
+    int err = port->req(&this->engine->io_req);
+    if (err == vp::IO_REQ_OK) {
+      int64_t latency = this->engine->io_req.get_latency();
+      if (latency > max_latency) {
+        max_latency = latency;
+      }
+    }
+    else {
+      this->engine->trace.fatal("Unsupported asynchronous reply\n");
+    }
+  }
+  if(width_rem) {
+    this->engine->io_req.init();
+    this->engine->io_req.set_addr(addr_padded+width_words*4 & mask);
+    this->engine->io_req.set_size(width_rem);
+    this->engine->io_req.set_data(load_data+width_words*4);
+    this->engine->io_req.set_is_write(false);
+    int err = port->req(&this->engine->io_req);
+    if (err == vp::IO_REQ_OK) {
+      // int64_t latency = this->engine->io_req.get_latency();
+      // if (latency > max_latency) {
+      //   max_latency = latency;
+      // }
+    }
+    else {
+      this->engine->trace.fatal("Unsupported asynchronous reply\n");
+    }
+  }
+  std::ostringstream stringStream;
+
+  if (this->engine->trace_level == L3_ALL) {
+    this->engine->trace.msg(vp::Trace::LEVEL_DEBUG, "Issuing read request (addr=0x%08x, size=%dB, latency=%d)\n", addr & mask, width*sizeof(T), cycles+1);
+  }
+  xt::xarray<T> x = xt::zeros<T>({width});
+  for(auto i=0; i<width; i++) {
+    xt::view(x, i) = *(T *)(load_data + (addr & 0x3) + i*sizeof(T));
+  }
+  if (this->engine->trace_level == L3_ALL) {
+    xt::print_options::set_line_width(1000);
+    stringStream << "Read data: " << (this->engine->trace_format?std::hex:std::dec) << x << std::dec << "\n";
+    std::string s = stringStream.str();
+    this->engine->trace.msg(vp::Trace::LEVEL_DEBUG, s.c_str());
+  }
+  this->engine->perf_access(width*sizeof(T), max_latency);
+  cycles += max_latency + 1;
+  return x;
+}
+
+template<class Geometry, class T>
+HwpeVectorStore<Geometry, T>::HwpeVectorStore(
+  HwpeEngine<Geometry> *engine,
+  int base_addr,
+  int d0_length,
+  int d0_stride,
+  int d1_length,
+  int d1_stride,
+  int d2_length,
+  int d2_stride,
+  bool debug
+) : HwpeStreamAccess<Geometry>(engine, base_addr, d0_length, d0_stride, d1_length, d1_stride, d2_length, d2_stride, debug) {
+}
+
+template<class Geometry, class T>
+HwpeVectorStore<Geometry, T>::HwpeVectorStore() : HwpeStreamAccess<Geometry>((HwpeEngine<Geometry> *) NULL, 0, 0, 0, 0, 0, 0, 0, false) {
+}
+
+// The aligned part of the vector is written with word accesses, and the
+// misaligned head and tail with byte accesses.
+template<class Geometry, class T>
+xt::xarray<T> HwpeVectorStore<Geometry, T>::ex(xt::xarray<T> data, int width, int64_t& cycles, int32_t enable) {
+  auto addr = this->iterate();
+  uint8_t store_data[STREAM_MAX_WIDTH_BYTES];
+  for(auto i=0; i<STREAM_MAX_WIDTH_BYTES; i++) {
+    store_data[i] = 0;
+  }
+  for(auto i=0; i<width; i++) {
+    *(T *)(store_data + i*sizeof(T)) = data(i);
+  }
+  auto width_bytes = width*sizeof(T);
+
+  auto addr_start = addr;
+  auto addr_end   = addr + width_bytes;
+
+  auto addr_start_aligned = 4*((addr_start+(addr_start%4 ? 4:0))/4);
+  auto addr_end_aligned   = 4*(addr_end/4);
+
+  auto misaligned_start_byte = (width_bytes < 4) ? width_bytes : addr_start_aligned - addr_start;
+  auto misaligned_end_byte   = (width_bytes < 4) ? 0 : addr_end - addr_end_aligned;
+
+  auto width_words = (addr_end_aligned > addr_start_aligned) ? (addr_end_aligned - addr_start_aligned)/4 : 0;
+
+  int64_t max_latency = 0;
+  if(enable) {
+    for(auto i=0; i<width_words+misaligned_start_byte+misaligned_end_byte; i++) {
+      this->engine->io_req.init();
+      if(i<misaligned_start_byte) {
+        this->engine->io_req.set_addr((addr_start+i) & Geometry::L1_MASK);
+        this->engine->io_req.set_size(1);
+        this->engine->io_req.set_data(store_data+i);
+      }
+      else if(i>=misaligned_start_byte+width_words) {
+        auto offset = misaligned_start_byte + 4*width_words + (i-misaligned_start_byte-width_words);
+        this->engine->io_req.set_addr((addr_start+offset) & Geometry::L1_MASK);
+        this->engine->io_req.set_size(1);
+        this->engine->io_req.set_data(store_data+offset);
+      }
+      else {
+        this->engine->io_req.set_addr((addr_start_aligned+4*(i-misaligned_start_byte)) & Geometry::L1_MASK);
+        this->engine->io_req.set_size(4);
+        this->engine->io_req.set_data(store_data+misaligned_start_byte+4*(i-misaligned_start_byte));
+      }
+      this->engine->io_req.set_is_write(true);
+      int err = this->engine->out.req(&this->engine->io_req);
+      if (err == vp::IO_REQ_OK) {
+        if((i>=misaligned_start_byte) && (i<width_words+misaligned_start_byte)) {  // apparently, for non-aligned bytes we get garbage latency
+          int64_t latency = this->engine->io_req.get_latency();
+          if (latency > max_latency) {
+            max_latency = latency;
+          }
+        }
+      }
+      else {
+        this->engine->trace.fatal("Unsupported asynchronous reply\n");
+      }
+    }
+  }
+  std::ostringstream stringStream;
+  if (this->engine->trace_level == L3_ALL) {
+    this->engine->trace.msg(vp::Trace::LEVEL_DEBUG, "Issuing write request (addr=0x%08x, size=%dB, latency=%d)\n", addr & Geometry::L1_MASK, width*sizeof(T), cycles+max_latency+1);
+    xt::print_options::set_line_width(1000);
+    if(enable) {
+      stringStream << "Write data: " << (this->engine->trace_format?std::hex:std::dec) << data << std::dec << "\n";
+    }
+    else {
+      stringStream << "Write disabled" << "\n";
+    }
+    std::string s = stringStream.str();
+    this->engine->trace.msg(vp::Trace::LEVEL_DEBUG, s.c_str());
+  }
+  if(enable) {
+    this->engine->perf_access(width*sizeof(T), max_latency);
+  }
+  cycles += max_latency + 1;
+  return data;
+}
+
+#endif /* __HWPE_STREAM_HPP__ */
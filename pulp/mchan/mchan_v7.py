@@ -19,7 +19,8 @@ import gvsoc.systree as st
 class Mchan(st.Component):
 
     def __init__(self, parent, name, nb_channels=0, core_queue_depth=2, global_queue_depth=8, is_64=False, max_nb_ext_read_req=8,
-            max_nb_ext_write_req=8, max_burst_length=256, nb_loc_ports=4, tcdm_addr_width=20, power_models_file=None):
+            max_nb_ext_write_req=8, max_burst_length=256, nb_loc_ports=4, tcdm_addr_width=20, loc_port_width=4,
+            loc_bulk=False, fast_mode=False, power_models_file=None):
         super(Mchan, self).__init__(parent, name)
 
         self.vcd_group(skip=True)
@@ -36,6 +37,9 @@ class Mchan(st.Component):
             'max_burst_length': max_burst_length,
             'nb_loc_ports': nb_loc_ports,
             'tcdm_addr_width': tcdm_addr_width,
+            'loc_port_width': loc_port_width,
+            'loc_bulk': loc_bulk,
+            'fast_mode': fast_mode,
         })
 
         if power_models_file is not None:
@@ -24,6 +24,7 @@
 #include "vp/itf/wire.hpp"
 #include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
 #include <vector>
 
 using namespace std;
@@ -76,6 +77,9 @@ public:
 
   int id;
 
+  int64_t end_cycle;    // In fast mode, cycle at which the command is terminated
+  int64_t enqueue_cycle;  // Cycle at which the command was pushed by the core, for statistics
+
   Mchan_channel *channel;  // The channel port from which the command arrived
 
   void set_next(Mchan_cmd *next) { this->next = next; }
@@ -95,19 +99,23 @@ template<class T>
 class Mchan_queue
 {
 public:
-  Mchan_queue(int size) : size(size) {}
-  void init() { first=NULL; last=NULL; nb_cmd=0; }
+  Mchan_queue(int size=0) : size(size) {}
+  void set_size(int size) { this->size = size; }
+  void init() { first=NULL; last=NULL; nb_cmd=0; max_nb_cmd=0; }
   T *pop();
   T *pop(bool loc2ext);
   void push(T *cmd);
   bool is_full() { return nb_cmd >= size; }
   bool is_empty() { return nb_cmd == 0; }
   T *get_first() { return first; }
+  int get_nb_cmd() { return nb_cmd; }
+  int get_max_nb_cmd() { return max_nb_cmd; }
 
 private:
   T *first;    // First command of the queue, commands are popped from here
   T *last;     // Last command of the queue, commands are pushed here
   int        nb_cmd;
+  int        max_nb_cmd;  // High-water mark since last reset
   int        size;
 };
 
@@ -125,6 +133,7 @@ protected:
 
   Mchan_cmd *pop_cmd(bool read_queue);
   void trigger_event(Mchan_cmd *cmd);
+  void check_pending_req();
 
   int current_counter;
 
@@ -143,11 +152,15 @@ private:
   vp::IoReq *pending_req;
   int pending_cmd;
   Mchan_cmd *current_cmd;
-  Mchan_queue<Mchan_cmd> *pending_cmds;
+  Mchan_queue<Mchan_cmd> pending_cmds;
 
   vp::WireMaster<bool> event_itf;
   vp::WireMaster<bool> irq_itf;
 
+  // Statistics on the commands pushed through this channel
+  int64_t nb_done_cmd;
+  int64_t cmd_latency_total;
+  int64_t cmd_latency_max;
 };
 
 class mchan : public vp::Component
@@ -160,6 +173,7 @@ public:
   mchan(vp::ComponentConf &config);
 
   void reset(bool active);
+  void stop();
 
 protected:
   static vp::IoReqStatus req(vp::Block *__this, vp::IoReq *req, int id);
@@ -185,6 +199,7 @@ private:
   void push_req_to_loc(vp::IoReq *req);
   void send_req();
   void send_loc_read_req();
+  int64_t loc_port_access(int port, uint32_t addr, uint8_t *data, int size, bool is_write);
   static void ext_grant(vp::Block *__this, vp::IoReq *req);
   static void ext_response(vp::Block *__this, vp::IoReq *req);
   static void loc_grant(vp::Block *__this, vp::IoReq *req);
@@ -193,6 +208,10 @@ private:
   void account_transfered_bytes(Mchan_cmd *cmd, int bytes);
   void send_req_to_ext(Mchan_cmd *cmd, vp::IoReq *req);
   void handle_ext_write_req_end(Mchan_cmd *cmd, vp::IoReq *req);
+  void fast_transfer(Mchan_cmd *cmd);
+  void global_queues_update();
+  void ext_req_update();
+  static void fast_end_handler(vp::Block *_this, vp::ClockEvent *event);
 
   vp::Trace     trace;
 
@@ -205,6 +224,9 @@ private:
   int max_burst_length;
   int nb_loc_ports;
   int tcdm_addr_width;
+  int loc_port_width;
+  bool loc_bulk;
+  bool fast_mode;
 
   int nb_pending_ext_read_req;
   int nb_pending_ext_write_req;
@@ -217,9 +239,9 @@ private:
   vp::ClockEvent *check_ext_write_event;
   vp::ClockEvent *check_loc_transfer_event;
   int sched_core_queue;
-  Mchan_queue<Mchan_cmd> *pending_read_cmds;
-  Mchan_queue<Mchan_cmd> *pending_write_cmds;
-  Mchan_queue<vp::IoReq> *pending_write_reqs;
+  Mchan_queue<Mchan_cmd> pending_read_cmds;
+  Mchan_queue<Mchan_cmd> pending_write_cmds;
+  Mchan_queue<vp::IoReq> pending_write_reqs;
   Mchan_cmd *current_ext_read_cmd;
   Mchan_cmd *current_ext_write_cmd;
   Mchan_cmd *current_loc_cmd;
@@ -228,7 +250,35 @@ private:
   vp::IoReq *loc_req;
   vp::IoReq *pending_loc_read_req;
 
+  // Command pool, allocated once with enough commands for all queues and in-flight transfers
+  vector<Mchan_cmd> cmd_pool;
   Mchan_cmd *first_command = NULL;
+  int nb_used_cmd;
+  int max_nb_used_cmd;
+
+  // Bandwidth and queue statistics. Occupancies are integrated over cycles to get the average.
+  int64_t transfered_bytes[2];
+  int global_queue_occupancy[2];
+  int64_t global_queue_occupancy_total[2];
+  int64_t global_queue_update_cycle;
+  bool ext_req_full[2];
+  int64_t ext_req_full_start[2];
+  int64_t ext_req_full_cycles[2];
+  int64_t stats_start_cycle;
+
+  vp::Trace     stats_trace;  // End-of-simulation counters, dumped by stop() when active
+  vp::Trace     bytes_events[2];
+  vp::Trace     cmd_latency_event;
+  vp::Trace     global_queue_events[2];
+  vp::Trace     ext_req_full_events[2];
+
+  // Fast mode state. Commands whose data has already been moved are kept here, sorted
+  // by termination cycle, until their latency has elapsed.
+  vp::ClockEvent *fast_end_event;
+  Mchan_cmd *first_fast_cmd;
+  int64_t fast_ready_cycle[2];
+  vp::IoReq fast_req;
+  vector<uint8_t> fast_buffer;
 
   vp::IoMaster ext_itf;
   vp::IoMaster *loc_itf;
@@ -246,7 +296,10 @@ void Mchan_channel::reset()
   pending_req = NULL;
   pending_cmd = 0;
   current_cmd = NULL;
-  pending_cmds->init();
+  pending_cmds.init();
+  nb_done_cmd = 0;
+  cmd_latency_total = 0;
+  cmd_latency_max = 0;
 }
 
 /* Check if a raw command is ready and unpack it to make it easier to parse */
@@ -357,11 +410,13 @@ void Mchan_queue<T>::push(T *cmd)
   cmd->set_next(NULL);
   last = cmd;
   nb_cmd++;
+  if (nb_cmd > max_nb_cmd)
+    max_nb_cmd = nb_cmd;
 }
 
 Mchan_cmd *Mchan_channel::pop_cmd(bool read_queue)
 {
-  Mchan_cmd *cmd = pending_cmds->pop(!read_queue);
+  Mchan_cmd *cmd = pending_cmds.pop(!read_queue);
   if (cmd == NULL) return NULL;
   pending_cmd--;
 
@@ -370,15 +425,21 @@ Mchan_cmd *Mchan_channel::pop_cmd(bool read_queue)
   else
     top->nb_core_read_cmd--;
 
-  if (pending_req)
+  check_pending_req();
+
+  return cmd;
+}
+
+/* Unstall the core waiting on this channel if its request can now be accepted */
+void Mchan_channel::check_pending_req()
+{
+  if (pending_req && pending_cmd < top->core_queue_depth)
   {
     vp::IoReq *req = pending_req;
     pending_req = NULL;
     handle_req(req, (uint32_t *)req->get_data());
     req->get_resp_port()->resp(req);
   }
-
-  return cmd;
 }
 
 /* This checks if a command is ready after the queue has been written and if it is the case, enqueue it
@@ -393,11 +454,20 @@ bool Mchan_channel::check_command(Mchan_cmd *cmd)
 
   top->trace.msg("Incrementing counter (id: %d, bytes: %d, remaining bytes: %d)\n", current_counter, cmd->size, top->pending_bytes[current_counter]);
 
-  // Enqueue the command to the core queue
   uint8_t one = 1;
   this->top->cmd_events[cmd->counter_id].event(&one);
+  cmd->enqueue_cycle = top->clock.get_cycles();
+
+  // In fast mode, the command does not go through the queues, it is directly executed. It keeps
+  // its core queue slot until it terminates so that the number of commands in flight stays bounded.
+  if (top->fast_mode)
+  {
+    top->fast_transfer(cmd);
+    return true;
+  }
 
-  pending_cmds->push(cmd);
+  // Enqueue the command to the core queue
+  pending_cmds.push(cmd);
 
   if (cmd->loc2ext)
     top->nb_core_write_cmd++;
@@ -479,7 +549,7 @@ Mchan_channel::Mchan_channel(int id, mchan *top)
 {
   in.set_req_meth_muxed(&mchan::req, id);
   top->new_slave_port("in_" + std::to_string(id), &in);
-  pending_cmds = new Mchan_queue<Mchan_cmd>(top->core_queue_depth);
+  pending_cmds.set_size(top->core_queue_depth);
 
   top->new_master_port("event_itf_" + std::to_string(id), &event_itf);
   top->new_master_port("irq_itf_" + std::to_string(id), &irq_itf);
@@ -569,15 +639,32 @@ mchan::mchan(vp::ComponentConf &config)
   max_burst_length = get_js_config()->get_child_int("max_burst_length");
   nb_loc_ports = get_js_config()->get_child_int("nb_loc_ports");
   tcdm_addr_width = get_js_config()->get_child_int("tcdm_addr_width");
+  loc_port_width = get_js_config()->get_child_int("loc_port_width");
+  loc_bulk = get_js_config()->get_child_bool("loc_bulk");
+  fast_mode = get_js_config()->get_child_bool("fast_mode");
 
   check_queue_event = event_new(mchan::check_queue_handler);
   check_ext_read_event = event_new(mchan::check_ext_read_handler);
   check_ext_write_event = event_new(mchan::check_ext_write_handler);
   check_loc_transfer_event = event_new(mchan::check_loc_transfer_handler);
+  fast_end_event = event_new(mchan::fast_end_handler);
+
+  fast_buffer.resize(max_burst_length);
+
+  pending_read_cmds.set_size(global_queue_depth);
+  pending_write_cmds.set_size(global_queue_depth);
+  pending_write_reqs.set_size(global_queue_depth);
 
-  pending_read_cmds = new Mchan_queue<Mchan_cmd>(global_queue_depth);
-  pending_write_cmds = new Mchan_queue<Mchan_cmd>(global_queue_depth);
-  pending_write_reqs = new Mchan_queue<vp::IoReq>(global_queue_depth);
+  // Commands can be assembled or waiting in each core queue, waiting in the read and write global
+  // queues, being split into bursts, or waiting for their outstanding bursts, which are bounded
+  // by the external request pools.
+  int nb_cmd = nb_channels * (core_queue_depth + 1) + 2 * global_queue_depth + 2 +
+    max_nb_ext_read_req + max_nb_ext_write_req;
+  cmd_pool.reserve(nb_cmd);
+  for (int i=0; i<nb_cmd; i++)
+  {
+    cmd_pool.emplace_back(this);
+  }
 
   loc_req = new vp::IoReq[nb_loc_ports];
   loc_itf = new vp::IoMaster[nb_loc_ports];
@@ -621,6 +708,12 @@ mchan::mchan(vp::ComponentConf &config)
   }
 
   traces.new_trace("trace", &this->trace, vp::DEBUG);
+  traces.new_trace("stats", &this->stats_trace, vp::DEBUG);
+
+  if (loc_port_width < 4 || (loc_port_width & (loc_port_width - 1)))
+  {
+    this->trace.fatal("Invalid local port width, must be a power of 2 greater or equal to 4 (width: %d)\n", loc_port_width);
+  }
 
   for (int i=0; i<nb_channels; i++)
   {
@@ -632,6 +725,14 @@ mchan::mchan(vp::ComponentConf &config)
     traces.new_trace_event("channel_" + std::to_string(i), &this->cmd_events[i], 8);
   }
 
+  traces.new_trace_event("ext2loc_bytes", &this->bytes_events[0], 32);
+  traces.new_trace_event("loc2ext_bytes", &this->bytes_events[1], 32);
+  traces.new_trace_event("cmd_latency", &this->cmd_latency_event, 32);
+  traces.new_trace_event("read_queue", &this->global_queue_events[0], 8);
+  traces.new_trace_event("write_queue", &this->global_queue_events[1], 8);
+  traces.new_trace_event("ext_read_full", &this->ext_req_full_events[0], 1);
+  traces.new_trace_event("ext_write_full", &this->ext_req_full_events[1], 1);
+
   this->new_master_port("ext_irq_itf", &ext_irq_itf);
 }
 
@@ -706,17 +807,20 @@ int mchan::alloc_counter(vp::IoReq *req, Mchan_channel *channel)
 
 Mchan_cmd *mchan::get_command()
 {
-  Mchan_cmd *cmd;
-
-  if (first_command == NULL) {
-    // No more commands in the pool, add one.
-    cmd = new Mchan_cmd(this);
-  }
-  else
+  // The pool is sized for all the commands the queues and external requests can hold
+  if (first_command == NULL)
   {
-    cmd = first_command;
-    first_command = cmd->get_next();
+    this->trace.fatal("Command pool exhausted (size: %d)\n", (int)cmd_pool.size());
+    return NULL;
   }
+
+  Mchan_cmd *cmd = first_command;
+  first_command = cmd->get_next();
+
+  nb_used_cmd++;
+  if (nb_used_cmd > max_nb_used_cmd)
+    max_nb_used_cmd = nb_used_cmd;
+
   cmd->init();
   return cmd;
 }
@@ -725,11 +829,12 @@ void mchan::free_command(Mchan_cmd *cmd)
 {
   cmd->set_next(first_command);
   first_command = cmd;
+  nb_used_cmd--;
 }
 
 void mchan::move_to_global_queue(bool read_queue)
 {
-  Mchan_queue<Mchan_cmd> *queue = read_queue ? pending_read_cmds : pending_write_cmds;
+  Mchan_queue<Mchan_cmd> *queue = read_queue ? &pending_read_cmds : &pending_write_cmds;
 
   for (int i=0, j=sched_core_queue; i<nb_channels; i++)
   {
@@ -740,6 +845,7 @@ void mchan::move_to_global_queue(bool read_queue)
       trace.msg("Moving command from core queue to global queue (channel: %d)\n", j);
 
       queue->push(cmd);
+      this->global_queues_update();
 
       sched_core_queue++;
       if (sched_core_queue == nb_channels)
@@ -757,7 +863,7 @@ void mchan::move_to_global_queue(bool read_queue)
 
 void mchan::push_req_to_loc(vp::IoReq *req)
 {
-  pending_write_reqs->push(req);
+  pending_write_reqs.push(req);
 }
 
 void mchan::handle_ext_write_req_end(Mchan_cmd *cmd, vp::IoReq *req)
@@ -771,6 +877,7 @@ void mchan::handle_ext_write_req_end(Mchan_cmd *cmd, vp::IoReq *req)
   req->set_next(first_ext_write_req);
   first_ext_write_req = req;
   nb_pending_ext_write_req--;
+  this->ext_req_update();
 
   account_transfered_bytes(cmd, size);
   if (cmd->size_to_write == 0)
@@ -797,6 +904,7 @@ void mchan::send_loc_read_req()
     size = max_burst_length;
 
   nb_pending_ext_write_req++;
+  this->ext_req_update();
 
   vp::IoReq *req = first_ext_write_req;
   first_ext_write_req = req->get_next();
@@ -843,6 +951,7 @@ void mchan::send_req()
     size = max_burst_length;
 
   nb_pending_ext_read_req++;
+  this->ext_req_update();
 
   vp::IoReq *req = first_ext_read_req;
   first_ext_read_req = req->get_next();
@@ -893,7 +1002,10 @@ void mchan::check_ext_read_handler(vp::Block *__this, vp::ClockEvent *event)
   mchan *_this = (mchan *)__this;
 
   if (_this->current_ext_read_cmd == NULL)
-    _this->current_ext_read_cmd = _this->pending_read_cmds->pop();
+  {
+    _this->current_ext_read_cmd = _this->pending_read_cmds.pop();
+    _this->global_queues_update();
+  }
 
 
   if (_this->current_ext_read_cmd != NULL)
@@ -913,7 +1025,10 @@ void mchan::check_ext_write_handler(vp::Block *__this, vp::ClockEvent *event)
   mchan *_this = (mchan *)__this;
 
   if (_this->current_ext_write_cmd == NULL)
-    _this->current_ext_write_cmd = _this->pending_write_cmds->pop();
+  {
+    _this->current_ext_write_cmd = _this->pending_write_cmds.pop();
+    _this->global_queues_update();
+  }
 
   if (_this->current_ext_write_cmd != NULL)
   {
@@ -931,6 +1046,15 @@ void mchan::check_ext_write_handler(vp::Block *__this, vp::ClockEvent *event)
 void mchan::handle_cmd_termination(Mchan_cmd *cmd)
 {
   this->cmd_events[cmd->counter_id].event(NULL);
+
+  int64_t latency = this->clock.get_cycles() - cmd->enqueue_cycle;
+  Mchan_channel *channel = cmd->channel;
+  channel->nb_done_cmd++;
+  channel->cmd_latency_total += latency;
+  if (latency > channel->cmd_latency_max)
+    channel->cmd_latency_max = latency;
+  this->cmd_latency_event.event((uint8_t *)&latency);
+
   free_command(cmd);
 }
 
@@ -938,6 +1062,9 @@ void mchan::account_transfered_bytes(Mchan_cmd *cmd, int bytes)
 {
   pending_bytes[cmd->counter_id] -= bytes;
 
+  transfered_bytes[cmd->loc2ext] += bytes;
+  this->bytes_events[cmd->loc2ext].event((uint8_t *)&bytes);
+
   trace.msg("Decreasing counter (id: %d, bytes: %d, remaining bytes: %d)\n", cmd->counter_id, bytes, pending_bytes[cmd->counter_id]);
 
   if (pending_bytes[cmd->counter_id] < 0)
@@ -959,6 +1086,226 @@ void mchan::account_transfered_bytes(Mchan_cmd *cmd, int bytes)
   }
 }
 
+// Access a span of the local memory through the specified port.
+// The local interconnect is interleaved on 32bits words, so the span is sent as a sequence of
+// word accesses but they all belong to the same port transaction, which makes it possible to
+// handle a wide port beat or a bulk span in a single event.
+// Returns the highest latency reported by the word accesses.
+int64_t mchan::loc_port_access(int port, uint32_t addr, uint8_t *data, int size, bool is_write)
+{
+  vp::IoReq *req = &this->loc_req[port];
+  int64_t latency = 0;
+
+  while (size > 0)
+  {
+    int word_size = 4 - (addr & 0x3);
+    if (word_size > size) word_size = size;
+
+    req->init();
+    req->set_addr(addr);
+    req->set_size(word_size);
+    req->set_is_write(is_write);
+    req->set_data(data);
+
+    // TODO for now we assume this is synchronous
+    vp::IoReqStatus err = this->loc_itf[port].req(req);
+
+    if (err == vp::IO_REQ_OK && req->get_latency() > latency)
+    {
+      latency = req->get_latency();
+    }
+
+    addr += word_size;
+    data += word_size;
+    size -= word_size;
+  }
+
+  return latency;
+}
+
+// Fast mode execution of a command.
+// The whole 1D or 2D transfer is done immediately, burst by burst, and the command termination
+// is scheduled after a latency estimated from the number of bursts, the number of outstanding
+// external requests, the external latency and the local port bandwidth.
+void mchan::fast_transfer(Mchan_cmd *cmd)
+{
+  bool loc2ext = cmd->loc2ext;
+  uint64_t ext_addr = loc2ext ? cmd->dest : cmd->source;
+  uint64_t ext_chunk = ext_addr;
+  uint32_t loc_addr = (loc2ext ? cmd->source : cmd->dest) & ((1<<tcdm_addr_width) - 1);
+  int size = cmd->size;
+  int line_size = cmd->is_2d ? cmd->length : size;
+  int max_nb_ext_req = loc2ext ? max_nb_ext_write_req : max_nb_ext_read_req;
+  int nb_dir_ports = nb_loc_ports / 2 > 0 ? nb_loc_ports / 2 : 1;
+  int64_t nb_bursts = 0;
+  int64_t nb_beats = 0;
+  int64_t ext_latency = 0;
+  int64_t loc_latency = 0;
+
+  trace.msg("Fast mode transfer (source: 0x%lx, dest: 0x%lx, size: 0x%x, loc2ext: %d, 2d: %d)\n",
+    cmd->source, cmd->dest, size, loc2ext, cmd->is_2d);
+
+  while (size > 0)
+  {
+    int burst_size = line_size < max_burst_length ? line_size : max_burst_length;
+    if (burst_size > size) burst_size = size;
+
+    uint8_t *data = fast_buffer.data();
+    vp::IoReq *req = &fast_req;
+    req->init();
+    req->set_addr(ext_addr);
+    req->set_size(burst_size);
+    req->set_data(data);
+
+    int64_t latency;
+
+    if (loc2ext)
+    {
+      latency = loc_port_access(nb_loc_ports / 2, loc_addr, data, burst_size, false);
+      if (latency > loc_latency) loc_latency = latency;
+
+      req->set_is_write(true);
+      if (ext_itf.req(req) != vp::IO_REQ_OK)
+      {
+        trace.fatal("Fast mode only supports synchronous external accesses (addr: 0x%lx)\n", ext_addr);
+        return;
+      }
+      if (req->get_latency() > ext_latency) ext_latency = req->get_latency();
+    }
+    else
+    {
+      req->set_is_write(false);
+      if (ext_itf.req(req) != vp::IO_REQ_OK)
+      {
+        trace.fatal("Fast mode only supports synchronous external accesses (addr: 0x%lx)\n", ext_addr);
+        return;
+      }
+      if (req->get_latency() > ext_latency) ext_latency = req->get_latency();
+
+      latency = loc_port_access(0, loc_addr, data, burst_size, true);
+      if (latency > loc_latency) loc_latency = latency;
+    }
+
+    nb_bursts++;
+    nb_beats += ((loc_addr & (loc_port_width - 1)) + burst_size + loc_port_width - 1) / loc_port_width;
+
+    loc_addr += burst_size;
+    ext_addr += burst_size;
+    size -= burst_size;
+    line_size -= burst_size;
+
+    if (line_size == 0)
+    {
+      line_size = cmd->length;
+      ext_addr = ext_chunk + cmd->stride;
+      ext_chunk = ext_addr;
+    }
+  }
+
+  // Bursts are issued at most one per cycle, with at most max_nb_ext_req of them waiting for
+  // the external response, while the local side is limited by the ports of this direction.
+  int64_t ext_cycles = (nb_bursts + max_nb_ext_req - 1) / max_nb_ext_req * (ext_latency + 1);
+  if (ext_cycles < nb_bursts) ext_cycles = nb_bursts;
+  int64_t loc_cycles = (nb_beats + nb_dir_ports - 1) / nb_dir_ports + loc_latency;
+  int64_t duration = ext_cycles > loc_cycles ? ext_cycles : loc_cycles;
+
+  // Commands of the same direction are processed one after the other
+  int64_t cycles = clock.get_cycles();
+  int64_t start = fast_ready_cycle[loc2ext] > cycles ? fast_ready_cycle[loc2ext] : cycles;
+  cmd->end_cycle = start + duration + 1;
+  fast_ready_cycle[loc2ext] = cmd->end_cycle;
+
+  trace.msg("Scheduling fast mode termination (bursts: %ld, beats: %ld, end_cycle: %ld)\n",
+    nb_bursts, nb_beats, cmd->end_cycle);
+
+  Mchan_cmd *current = first_fast_cmd, *prev = NULL;
+  while (current && current->end_cycle <= cmd->end_cycle)
+  {
+    prev = current;
+    current = current->get_next();
+  }
+  cmd->set_next(current);
+  if (prev)
+    prev->set_next(cmd);
+  else
+    first_fast_cmd = cmd;
+
+  if (first_fast_cmd == cmd)
+  {
+    if (fast_end_event->is_enqueued())
+      event_cancel(fast_end_event);
+    event_enqueue(fast_end_event, cmd->end_cycle - cycles);
+  }
+}
+
+void mchan::fast_end_handler(vp::Block *__this, vp::ClockEvent *event)
+{
+  mchan *_this = (mchan *)__this;
+  int64_t cycles = _this->clock.get_cycles();
+
+  while (_this->first_fast_cmd && _this->first_fast_cmd->end_cycle <= cycles)
+  {
+    Mchan_cmd *cmd = _this->first_fast_cmd;
+    _this->first_fast_cmd = cmd->get_next();
+
+    Mchan_channel *channel = cmd->channel;
+    _this->account_transfered_bytes(cmd, cmd->size);
+    _this->handle_cmd_termination(cmd);
+
+    // Release the core queue slot kept by the command, which may unstall the core
+    channel->pending_cmd--;
+    channel->check_pending_req();
+  }
+
+  // Terminations may have unstalled cores whose new commands already scheduled the event
+  if (_this->first_fast_cmd && !_this->fast_end_event->is_enqueued())
+  {
+    _this->event_enqueue(_this->fast_end_event, _this->first_fast_cmd->end_cycle - cycles);
+  }
+}
+
+// Integrate the global queue occupancies since the last change and dump them if they changed
+void mchan::global_queues_update()
+{
+  int64_t cycles = this->clock.get_cycles();
+  int occupancy[2] = { pending_read_cmds.get_nb_cmd(), pending_write_cmds.get_nb_cmd() };
+
+  for (int i=0; i<2; i++)
+  {
+    global_queue_occupancy_total[i] += global_queue_occupancy[i] * (cycles - global_queue_update_cycle);
+    if (occupancy[i] != global_queue_occupancy[i])
+    {
+      global_queue_occupancy[i] = occupancy[i];
+      this->global_queue_events[i].event((uint8_t *)&occupancy[i]);
+    }
+  }
+
+  global_queue_update_cycle = cycles;
+}
+
+// Track the cycles where the maximum number of outstanding external requests is reached
+void mchan::ext_req_update()
+{
+  int64_t cycles = this->clock.get_cycles();
+  bool full[2] = { nb_pending_ext_read_req >= max_nb_ext_read_req,
+    nb_pending_ext_write_req >= max_nb_ext_write_req };
+
+  for (int i=0; i<2; i++)
+  {
+    if (full[i] != ext_req_full[i])
+    {
+      if (full[i])
+        ext_req_full_start[i] = cycles;
+      else
+        ext_req_full_cycles[i] += cycles - ext_req_full_start[i];
+
+      ext_req_full[i] = full[i];
+      uint8_t value = full[i];
+      this->ext_req_full_events[i].event(&value);
+    }
+  }
+}
+
 void mchan::check_loc_transfer_handler(vp::Block *__this, vp::ClockEvent *event)
 {
   mchan *_this = (mchan *)__this;
@@ -970,6 +1317,10 @@ void mchan::check_loc_transfer_handler(vp::Block *__this, vp::ClockEvent *event)
 
   for (int i=0; i<_this->nb_loc_ports; i++)
   {
+    // Stop as soon as there is nothing left to transfer, no need to go through the other ports
+    if (_this->pending_write_reqs.is_empty() && _this->pending_loc_read_req == NULL)
+      break;
+
     // Bypass this port if it is still busy with a previous request
     if (_this->loc_port_ready_cycle[i] > cycles)
     {
@@ -985,7 +1336,7 @@ void mchan::check_loc_transfer_handler(vp::Block *__this, vp::ClockEvent *event)
 
     if (i < (_this->nb_loc_ports/2))
     {
-      ext_req = _this->pending_write_reqs->get_first();
+      ext_req = _this->pending_write_reqs.get_first();
       if (ext_req == NULL)
         continue;
       is_write = true;
@@ -1004,32 +1355,23 @@ void mchan::check_loc_transfer_handler(vp::Block *__this, vp::ClockEvent *event)
     int32_t ext_size = ext_req->get_size() - done_size;
     uint32_t addr = *(uint32_t *)ext_req->arg_get(1) + done_size;
     uint8_t *data = ext_req->get_data() + done_size;
-    int32_t size = 4;
-    if (addr & 0x3) size -= addr & 0x3;
-    if (size > ext_size) size = ext_size;
-
-    // Create request to local port
-    vp::IoReq *req = &_this->loc_req[i];
-    _this->trace.msg("Sending %s request to local port (req: %p, port: %d, addr: 0x%x, size: 0x%x)\n",
-      is_write ? "write" : "read", req, i, addr, size);
-    req->init();
-    req->set_addr(addr);
-    req->set_size(size);
-    req->set_is_write(is_write);
-    req->set_data(data);
+    int32_t width = _this->loc_port_width;
+    uint32_t misalign = addr & (width - 1);
+
+    // By default, one port beat is done per event. In bulk mode, the rest of the external
+    // request is done at once and the port is kept busy for all the needed beats.
+    int32_t size = width - misalign;
+    if (_this->loc_bulk || size > ext_size) size = ext_size;
+
+    int64_t nb_beats = (misalign + size + width - 1) / width;
 
     // Send the request to the local port
-    // TODO for now we assume this is synchronous
-    vp::IoReqStatus err = _this->loc_itf[i].req(req);
+    _this->trace.msg("Sending %s request to local port (port: %d, addr: 0x%x, size: 0x%x, beats: %ld)\n",
+      is_write ? "write" : "read", i, addr, size, nb_beats);
 
-    if (err)
-    {
+    int64_t latency = _this->loc_port_access(i, addr, data, size, is_write);
 
-    }
-    else
-    {
-      _this->loc_port_ready_cycle[i] = cycles + req->get_latency() + 1;
-    }
+    _this->loc_port_ready_cycle[i] = cycles + latency + nb_beats;
 
     if (is_write)
     {
@@ -1046,10 +1388,11 @@ void mchan::check_loc_transfer_handler(vp::Block *__this, vp::ClockEvent *event)
       // Removed the request if it is finished
       if (ext_size - size == 0)
       {
-        _this->pending_write_reqs->pop();
+        _this->pending_write_reqs.pop();
         ext_req->set_next(_this->first_ext_read_req);
         _this->first_ext_read_req = ext_req;
         _this->nb_pending_ext_read_req--;
+        _this->ext_req_update();
       }
       else
       {
@@ -1085,12 +1428,12 @@ void mchan::check_queue_handler(vp::Block *__this, vp::ClockEvent *event)
 {
   mchan *_this = (mchan *)__this;
 
-  if (_this->nb_core_read_cmd && !_this->pending_read_cmds->is_full())
+  if (_this->nb_core_read_cmd && !_this->pending_read_cmds.is_full())
   {
     _this->move_to_global_queue(true);
   }
 
-  else if (_this->nb_core_write_cmd && !_this->pending_write_cmds->is_full())
+  else if (_this->nb_core_write_cmd && !_this->pending_write_cmds.is_full())
   {
     _this->move_to_global_queue(false);
   }
@@ -1100,14 +1443,14 @@ void mchan::check_queue_handler(vp::Block *__this, vp::ClockEvent *event)
 
 void mchan::check_queue()
 {
-  if (nb_core_read_cmd && !pending_read_cmds->is_full() ||
-    nb_core_write_cmd && !pending_write_cmds->is_full())
+  if (nb_core_read_cmd && !pending_read_cmds.is_full() ||
+    nb_core_write_cmd && !pending_write_cmds.is_full())
   {
     if (!check_queue_event->is_enqueued())
       event_enqueue(check_queue_event, 1);
   }
 
-  if (!pending_read_cmds->is_empty() && current_ext_read_cmd == NULL ||
+  if (!pending_read_cmds.is_empty() && current_ext_read_cmd == NULL ||
     current_ext_read_cmd != NULL && nb_pending_ext_read_req < max_nb_ext_read_req)
   {
     if (!ext_is_stalled)
@@ -1117,7 +1460,7 @@ void mchan::check_queue()
     }
   }
 
-  if (!pending_write_cmds->is_empty() && current_ext_write_cmd == NULL ||
+  if (!pending_write_cmds.is_empty() && current_ext_write_cmd == NULL ||
     current_ext_write_cmd != NULL && nb_pending_ext_write_req < max_nb_ext_write_req &&
     pending_loc_read_req == NULL)
   {
@@ -1128,7 +1471,7 @@ void mchan::check_queue()
     }
   }
 
-  if (!pending_write_reqs->is_empty() || pending_loc_read_req != NULL)
+  if (!pending_write_reqs.is_empty() || pending_loc_read_req != NULL)
   {
     if (!check_loc_transfer_event->is_enqueued())
     {
@@ -1182,14 +1525,37 @@ void mchan::reset(bool active)
     sched_core_queue = 0;
     nb_pending_ext_read_req = 0;
     nb_pending_ext_write_req = 0;
-    pending_read_cmds->init();
-    pending_write_cmds->init();
-    pending_write_reqs->init();
+    pending_read_cmds.init();
+    pending_write_cmds.init();
+    pending_write_reqs.init();
+
+    first_command = NULL;
+    for (Mchan_cmd &cmd: cmd_pool)
+    {
+      cmd.set_next(first_command);
+      first_command = &cmd;
+    }
+    nb_used_cmd = 0;
+    max_nb_used_cmd = 0;
+
+    stats_start_cycle = clock.get_cycles();
+    global_queue_update_cycle = stats_start_cycle;
+    for (int i=0; i<2; i++)
+    {
+      transfered_bytes[i] = 0;
+      global_queue_occupancy[i] = 0;
+      global_queue_occupancy_total[i] = 0;
+      ext_req_full[i] = false;
+      ext_req_full_cycles[i] = 0;
+    }
     current_ext_read_cmd = NULL;
     current_ext_write_cmd = NULL;
     current_loc_cmd = NULL;
     pending_loc_read_req = NULL;
     ext_is_stalled = false;
+    first_fast_cmd = NULL;
+    fast_ready_cycle[0] = 0;
+    fast_ready_cycle[1] = 0;
     for (int i=0; i<MCHAN_NB_COUNTERS; i++)
     {
       this->cmd_events[i].event(NULL);
@@ -1200,6 +1566,50 @@ void mchan::reset(bool active)
   }
 }
 
+void mchan::stop()
+{
+  if (this->stats_trace.get_active())
+  {
+    this->stats_trace.msg(vp::Trace::LEVEL_INFO, "commands: %d/%d\n",
+      max_nb_used_cmd, (int)cmd_pool.size());
+    this->stats_trace.msg(vp::Trace::LEVEL_INFO, "global queues: read %d/%d, write %d/%d\n",
+      pending_read_cmds.get_max_nb_cmd(), global_queue_depth,
+      pending_write_cmds.get_max_nb_cmd(), global_queue_depth);
+    for (int i=0; i<nb_channels; i++)
+    {
+      Mchan_channel *channel = channels[i];
+      this->stats_trace.msg(vp::Trace::LEVEL_INFO, "channel %d queue: %d/%d, commands: %" PRId64 ", latency: avg %.1f max %" PRId64 "\n",
+        i, channel->pending_cmds.get_max_nb_cmd(), core_queue_depth,
+        channel->nb_done_cmd,
+        channel->nb_done_cmd ? (double)channel->cmd_latency_total / channel->nb_done_cmd : 0.0,
+        channel->cmd_latency_max);
+    }
+
+    // Close the accounting periods which are still on-going
+    int64_t cycles = clock.get_cycles();
+    global_queues_update();
+    for (int i=0; i<2; i++)
+    {
+      if (ext_req_full[i])
+      {
+        ext_req_full_cycles[i] += cycles - ext_req_full_start[i];
+        ext_req_full_start[i] = cycles;
+      }
+    }
+
+    int64_t duration = cycles - stats_start_cycle;
+    if (duration == 0) duration = 1;
+
+    this->stats_trace.msg(vp::Trace::LEVEL_INFO, "bytes: ext2loc %" PRId64 ", loc2ext %" PRId64 "\n",
+      transfered_bytes[0], transfered_bytes[1]);
+    this->stats_trace.msg(vp::Trace::LEVEL_INFO, "global queues average occupancy: read %.2f, write %.2f\n",
+      (double)global_queue_occupancy_total[0] / duration,
+      (double)global_queue_occupancy_total[1] / duration);
+    this->stats_trace.msg(vp::Trace::LEVEL_INFO, "outstanding limit reached: read %" PRId64 " cycles, write %" PRId64 " cycles (total %" PRId64 " cycles)\n",
+      ext_req_full_cycles[0], ext_req_full_cycles[1], duration);
+  }
+}
+
 void Mchan_cmd::init()
 {
   step = 0;
@@ -18,12 +18,28 @@ import gvsoc.systree as st
 
 class Ne16(st.Component):
 
-    def __init__(self, parent, name):
+    def __init__(self, parent, name, nb_contexts=2, prefetch_depth=0,
+            matrixvec_fast=True, matrixvec_check=False):
 
         super(Ne16, self).__init__(parent, name)
 
         self.set_component('pulp.ne16.ne16')
 
+        # Number of job register contexts which can be programmed while a job is running
+        self.add_property('nb_contexts', nb_contexts)
+
+        # Number of feature tiles the load streamer can fetch ahead of the matrix-vector
+        # stage (0 keeps load and matrix-vector strictly sequential). Weights are not
+        # prefetched and still stall the matrix-vector stage as they are streamed in
+        self.add_property('prefetch_depth', prefetch_depth)
+
+        # Compute MATRIXVEC with the dedicated kernels, which skip the disabled MACs,
+        # instead of the generic xtensor path (16-bit and linear modes always use the latter)
+        self.add_property('matrixvec_fast', matrixvec_fast)
+
+        # Run both paths and stop the simulation if the accumulators differ
+        self.add_property('matrixvec_check', matrixvec_check)
+
     def gen_gtkw(self, tree, traces):
         if tree.get_view() == 'overview':
             map_file = tree.new_map_file(self, 'state')
@@ -53,13 +53,6 @@ void Ne16::debug_x_array() {
   // }
 }
 
-void Ne16::debug_accum(){
-  std::ostringstream stringStream;
-  stringStream << "accum[9,32] = \n" << (this->trace_format?std::hex:std::dec) << std::setw(8) << xt::cast<int32_t>(this->accum) << std::dec << "\n";
-  std::string copyOfStr = stringStream.str();
-  this->trace.msg(vp::Trace::LEVEL_DEBUG, copyOfStr.c_str());
-}
-
 // void Ne16::debug_psum_column(){
 //   std::ostringstream stringStream;
 //   stringStream << "psum_column[9] = \n" << (this->trace_format?std::hex:std::dec) << std::setw(8) << xt::cast<int32_t>(this->psum_column) << std::dec << "\n";
@@ -23,7 +23,7 @@
 void Ne16::fsm_start_handler(vp::Block *__this, vp::ClockEvent *event) {
   Ne16 *_this = (Ne16 *)__this;
   _this->state.set(START);
-  _this->running_job_id = _this->cxt_job_id[_this->cxt_use_ptr];
+  _this->job_start();
   if(_this->trace_level == L3_ALL) {
     _this->trace.msg(vp::Trace::LEVEL_DEBUG, "FSM START EVENT\n");
   }
@@ -31,13 +31,12 @@ void Ne16::fsm_start_handler(vp::Block *__this, vp::ClockEvent *event) {
   // clear state and propagate context
   _this->clear_all();
   _this->regfile_cxt();
-  _this->job_running = 1;
 
   // convenience parameters used internally in the model, but not set by register file
   _this->h_out     = (_this->subtile_nb_ho-(_this->subtile_rem_ho ? 1 : 0)) * _this->FILTER_SIZE + _this->subtile_rem_ho;
   _this->w_out     = (_this->subtile_nb_wo-(_this->subtile_rem_wo ? 1 : 0)) * _this->FILTER_SIZE + _this->subtile_rem_wo;
-  _this->h_out_int = (_this->h_out/3)*3 + ((_this->h_out%3) ? 3 : 0);
-  _this->w_out_int = (_this->w_out/3)*3 + ((_this->w_out%3) ? 3 : 0);
+  _this->h_out_int = (_this->h_out/_this->H_SIZE)*_this->H_SIZE + ((_this->h_out%_this->H_SIZE) ? _this->H_SIZE : 0);
+  _this->w_out_int = (_this->w_out/_this->W_SIZE)*_this->W_SIZE + ((_this->w_out%_this->W_SIZE) ? _this->W_SIZE : 0);
   _this->h_in_int  = (_this->h_out_int - 1) + _this->fs;
   _this->w_in_int  = (_this->w_out_int - 1) + _this->fs;
   _this->h_in      = (_this->h_out - 1) + _this->fs;
@@ -88,17 +87,7 @@ void Ne16::fsm_handler(vp::Block *__this, vp::ClockEvent *event) {
 
 void Ne16::fsm_end_handler(vp::Block *__this, vp::ClockEvent *event) {
   Ne16 *_this = (Ne16 *)__this;
-  int job_id = _this->cxt_job_id[_this->cxt_use_ptr];
-  _this->job_running = 0;
-  _this->cxt_job_id[_this->cxt_use_ptr] = -1;
-  _this->cxt_use_ptr = 1-_this->cxt_use_ptr;
-  _this->job_pending--;
-  _this->irq.sync(true);
-  _this->trace.msg(vp::Trace::LEVEL_INFO, "Ending job (id=%d).\n", job_id);
-  if (!_this->fsm_start_event->is_enqueued() && _this->job_pending > 0) {
-      _this->event_enqueue(_this->fsm_start_event, 1);
-      _this->trace.msg(vp::Trace::LEVEL_INFO, "Starting a new job from the queue.\n");
-  }
+  _this->job_end();
   _this->activity.set(0);
   _this->state.set(IDLE);
 }
@@ -106,7 +95,9 @@ void Ne16::fsm_end_handler(vp::Block *__this, vp::ClockEvent *event) {
 void Ne16::fsm_loop() {
   auto latency = 0;
   do {
+    auto current_state = this->state.get();
     latency = this->fsm();
+    this->perf_state(current_state, latency);
   } while(latency == 0 && state.get() != END);
   if(state.get() == END && !this->fsm_end_event->is_enqueued()) {
     this->event_enqueue(this->fsm_end_event, latency);
@@ -120,44 +111,13 @@ int Ne16::fsm() {
   auto state_next = this->state.get();
   auto latency = 0;
 
-  this->x_buffer_traces = false;
-  this->x_buffer_traces_postload = false;
-  this->accum_traces_poststreamin = false;
-  this->accum_traces = false;
-  this->accum_traces_postmatrixvec =false;
-  this->accum_traces_normquant = false;
-  this->accum_traces_streamout = false;
-  this->psum_block_traces = false;
-  this->binconv_traces = false;
-  this->fsm_traces = false;
-  if(this->trace_level == L1_ACTIV_INOUT) {
-    this->x_buffer_traces_postload = true;
-    this->accum_traces_streamout = true;
-  }
-  if(this->trace_level == L2_DEBUG) {
-    this->x_buffer_traces_postload = true;
-    this->fsm_traces = true;
-    this->accum_traces_poststreamin = true;
-    this->accum_traces_streamout = true;
-    this->accum_traces_postmatrixvec = true;
-    this->accum_traces_normquant = true;
-  }
-  if(this->trace_level == L3_ALL) {
-    this->x_buffer_traces = true;
-    this->x_buffer_traces_postload = true;
-    this->fsm_traces = true;
-    this->accum_traces = true;
-    this->accum_traces_poststreamin = true;
-    this->accum_traces_streamout = true;
-    this->accum_traces_postmatrixvec = true;
-    this->accum_traces_normquant = true;
-  }
+  this->debug_traces_update();
 
   switch(this->state.get()) {
     
     case START:
       this->activity.set(1);
-      this->trace.msg(vp::Trace::LEVEL_INFO, "Starting a job (id=%d) with the following configuration:\n", this->cxt_job_id[this->cxt_use_ptr]);
+      this->trace.msg(vp::Trace::LEVEL_INFO, "Starting a job (id=%d) with the following configuration:\n", this->running_job_id);
       this->printout();
 
       state_next = START_STREAMIN;
@@ -168,6 +128,7 @@ int Ne16::fsm() {
         this->trace.msg(vp::Trace::LEVEL_DEBUG, "State START_STREAMIN\n");
       }
       this->constant_setup();
+      this->load_prefetch_sync();
       if(this->streamin) {
         this->streamin_setup();
         state_next = STREAMIN;
@@ -221,6 +182,9 @@ int Ne16::fsm() {
 
       // emulate 6 cycles of latency due to FIFOs + ctrl
       latency += 6;
+      if(this->prefetch_depth > 0) {
+        latency = this->load_prefetch_account(latency);
+      }
       break;
       
     case LOAD:
@@ -255,6 +219,9 @@ int Ne16::fsm() {
       else {
         this->load_update_idx();
       }
+      if(this->prefetch_depth > 0) {
+        latency = this->load_prefetch_account(latency);
+      }
       break;
 
     case LOAD_MATRIXVEC:
@@ -280,6 +247,9 @@ int Ne16::fsm() {
       }
       state_next = MATRIXVEC;
 
+      // wait for the feature tile if it was prefetched and is not yet there
+      latency += this->load_prefetch_stall();
+
       // emulate 6 cycles of latency due to FIFOs + ctrl (10 for 1x1 layers)
       if(this->depthwise && this->dw_iter == 0) {
         latency += 22;
@@ -339,6 +309,9 @@ int Ne16::fsm() {
           this->streamout_setup();
           state_next = STREAMOUT;
         }
+        if(state_next != LOAD_MATRIXVEC) {
+          this->load_prefetch_release(this->clock.get_cycles() + latency);
+        }
       }
       else {
         this->matrixvec_update_idx();
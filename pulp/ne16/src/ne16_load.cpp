@@ -54,7 +54,7 @@ void Ne16::load_setup() {
   auto base_addr_x = !this->mode_linear ? this->infeat_ptr + this->i_major*infeat_hom_iter + this->j_major*infeat_wom_iter + k_in_major*this->TP_IN :
                                           this->infeat_ptr + k_in_major*this->TP_IN*8 * (this->mode16 ? 2 : 2);
 
-  this->vld_x = Ne16VectorLoad<uint8_t>(
+  this->vld_x = VectorLoad(
     this,
     base_addr_x, // base_addr
     this->mode_linear ? (this->mode16 ? 32 : 16) : this->h_size_in_X_w_size_in, // word_length
@@ -93,9 +93,8 @@ void Ne16::load_setup() {
     this->load_j_fbuf = 0;
   }
 
-  xt::view(this->x_buffer, xt::all()) = 0;
-  xt::view(this->x_buffer_linear, xt::all()) = 0;
-  
+  std::fill(this->x_buffer.begin(), this->x_buffer.end(), 0);
+  std::fill(this->x_buffer_linear.begin(), this->x_buffer_linear.end(), 0);
 }
 
 int Ne16::load_cycle() { // not linear
@@ -111,121 +110,6 @@ int Ne16::load_cycle_linear() {
   return (int) cycles;
 }
 
-void Ne16::load_do_padding() { // not linear
-
-  // add explicit padding
-  auto right_lim  = (5-this->padding_right  > this->w_size_in_hw) ? this->w_size_in_hw : 5-this->padding_right;
-  auto bottom_lim = (5-this->padding_bottom > this->h_size_in_hw) ? this->h_size_in_hw : 5-this->padding_bottom;
-
-  // implicit padding (on the right/bottom) and explicit padding (all dimensions) define
-  // sixteen regions:
-  // +-------+-------+-------+-------+
-  // | TL    | T     | TR    | TRR   |
-  // +-------+-------+-------+-------+
-  // | L     | body  | R     | RR    |
-  // +-------+-------+-------+-------+
-  // | BL    | B     | BR    | BRR   |
-  // +-------+-------+-------+-------+
-  // | BBL   | BB    | BBR   | BBRR  |
-  // +-------+-------+-------+-------+
-
-  if(!this->mode16) {
-
-    // top-left
-    if(this->padding_left  > 0 && this->j_major==0 || this->padding_top > 0 && this->i_major==0) {
-      xt::view(this->x_buffer, xt::range(0, this->padding_top), xt::range(0, this->padding_left), xt::range(0, this->load_k_in_lim)) = this->padding_value;
-    }
-
-    // top
-    if(this->padding_top  > 0 && this->i_major==0) {
-      xt::view(this->x_buffer, xt::range(0, this->padding_top), xt::range(this->padding_left, right_lim), xt::range(0, this->load_k_in_lim)) = this->padding_value;
-    }
-
-    // top-right
-    if((this->padding_right > 0 && this->j_major==this->subtile_nb_wo-1 || this->padding_top > 0 && this->i_major==0) && (right_lim <= this->w_size_in_hw)) {
-      xt::view(this->x_buffer, xt::range(0, this->padding_top), xt::range(right_lim, w_size_in_hw), xt::range(0, this->load_k_in_lim)) = this->padding_value;
-    }
-
-    // right
-    if((this->padding_right > 0 && this->j_major==this->subtile_nb_wo-1) && (right_lim <= this->w_size_in_hw)) {
-      xt::view(this->x_buffer, xt::range(this->padding_top, bottom_lim), xt::range(right_lim, this->w_size_in_hw), xt::range(0, this->load_k_in_lim)) = this->padding_value;
-    }
-
-    // bottom-right
-    if((this->padding_right > 0 && this->j_major==this->subtile_nb_wo-1 || this->padding_bottom > 0 && this->i_major==this->subtile_nb_ho-1) && (right_lim <= this->w_size_in_hw) && (bottom_lim <= this->h_size_in_hw)) {
-      xt::view(this->x_buffer, xt::range(bottom_lim, h_size_in_hw), xt::range(right_lim, w_size_in_hw), xt::range(0, this->load_k_in_lim)) = this->padding_value;
-    }
-
-    // bottom
-    if((this->padding_bottom > 0 && this->i_major==this->subtile_nb_ho-1) && (bottom_lim <= this->h_size_in_hw)) {
-      xt::view(this->x_buffer, xt::range(bottom_lim, this->h_size_in_hw), xt::range(this->padding_left, right_lim), xt::range(0, this->load_k_in_lim)) = this->padding_value;
-    }
-
-    // bottom-left
-    if((this->padding_left > 0 && this->j_major==0 || this->padding_bottom > 0 && this->i_major==this->subtile_nb_ho-1) && (bottom_lim <= this->h_size_in_hw)) {
-      xt::view(this->x_buffer, xt::range(bottom_lim, this->h_size_in_hw), xt::range(0, this->padding_left), xt::range(0, this->load_k_in_lim)) = this->padding_value;
-    }
-
-    // left
-    if(this->padding_left > 0 && this->j_major==0) {
-      xt::view(this->x_buffer, xt::range(this->padding_top, bottom_lim), xt::range(0, this->padding_left), xt::range(0, this->load_k_in_lim)) = this->padding_value;
-    }
-    
-  }
-  else {
-    
-    // top-left
-    if(this->padding_left  > 0 && this->j_major==0 || this->padding_top > 0 && this->i_major==0) {
-      xt::view(this->x_buffer, xt::range(0, this->padding_top), xt::range(0, this->padding_left), xt::range(0, this->load_k_in_lim,   2)) = this->padding_value & 0xff;
-      xt::view(this->x_buffer, xt::range(0, this->padding_top), xt::range(0, this->padding_left), xt::range(1, this->load_k_in_lim+1, 2)) = this->padding_value >> 8;
-    }
-  
-    // top
-    if(this->padding_top  > 0 && this->i_major==0) {
-      xt::view(this->x_buffer, xt::range(0, this->padding_top), xt::range(this->padding_left, right_lim), xt::range(0, this->load_k_in_lim,   2)) = this->padding_value & 0xff;
-      xt::view(this->x_buffer, xt::range(0, this->padding_top), xt::range(this->padding_left, right_lim), xt::range(1, this->load_k_in_lim+1, 2)) = this->padding_value >> 8;
-    }
-    
-    // top-right
-    if((this->padding_right > 0 && this->j_major==this->subtile_nb_wo-1 || this->padding_top > 0 && this->i_major==0) && (right_lim <= this->w_size_in_hw)) {
-      xt::view(this->x_buffer, xt::range(0, this->padding_top), xt::range(right_lim, w_size_in_hw), xt::range(0, this->load_k_in_lim,   2)) = this->padding_value & 0xff;
-      xt::view(this->x_buffer, xt::range(0, this->padding_top), xt::range(right_lim, w_size_in_hw), xt::range(1, this->load_k_in_lim+1, 2)) = this->padding_value >> 8;
-    }
-  
-    // right
-    if((this->padding_right > 0 && this->j_major==this->subtile_nb_wo-1) && (right_lim <= this->w_size_in_hw)) {
-      xt::view(this->x_buffer, xt::range(this->padding_top, bottom_lim), xt::range(right_lim, this->w_size_in_hw), xt::range(0, this->load_k_in_lim,   2)) = this->padding_value & 0xff;
-      xt::view(this->x_buffer, xt::range(this->padding_top, bottom_lim), xt::range(right_lim, this->w_size_in_hw), xt::range(1, this->load_k_in_lim+1, 2)) = this->padding_value >> 8;
-    }
-  
-    // bottom-right
-    if((this->padding_right > 0 && this->j_major==this->subtile_nb_wo-1 || this->padding_bottom > 0 && this->i_major==this->subtile_nb_ho-1) && (right_lim <= this->w_size_in_hw) && (bottom_lim <= this->h_size_in_hw)) {
-      xt::view(this->x_buffer, xt::range(bottom_lim, h_size_in_hw), xt::range(right_lim, w_size_in_hw), xt::range(0, this->load_k_in_lim,   2)) = this->padding_value & 0xff;
-      xt::view(this->x_buffer, xt::range(bottom_lim, h_size_in_hw), xt::range(right_lim, w_size_in_hw), xt::range(1, this->load_k_in_lim+1, 2)) = this->padding_value >> 8;
-    }
-  
-    // bottom
-    if((this->padding_bottom > 0 && this->i_major==this->subtile_nb_ho-1) && (bottom_lim <= this->h_size_in_hw)) {
-      xt::view(this->x_buffer, xt::range(bottom_lim, this->h_size_in_hw), xt::range(this->padding_left, right_lim), xt::range(0, this->load_k_in_lim,   2)) = this->padding_value & 0xff;
-      xt::view(this->x_buffer, xt::range(bottom_lim, this->h_size_in_hw), xt::range(this->padding_left, right_lim), xt::range(1, this->load_k_in_lim+1, 2)) = this->padding_value >> 8;
-    }
-  
-    // bottom-left
-    if((this->padding_left > 0 && this->j_major==0 || this->padding_bottom > 0 && this->i_major==this->subtile_nb_ho-1) && (bottom_lim <= this->h_size_in_hw)) {
-      xt::view(this->x_buffer, xt::range(bottom_lim, this->h_size_in_hw), xt::range(0, this->padding_left), xt::range(0, this->load_k_in_lim,   2)) = this->padding_value & 0xff;
-      xt::view(this->x_buffer, xt::range(bottom_lim, this->h_size_in_hw), xt::range(0, this->padding_left), xt::range(1, this->load_k_in_lim+1, 2)) = this->padding_value >> 8;
-    }
-  
-    // left
-    if(this->padding_left > 0 && this->j_major==0) {
-      xt::view(this->x_buffer, xt::range(this->padding_top, bottom_lim), xt::range(0, this->padding_left), xt::range(0, this->load_k_in_lim,   2)) = this->padding_value & 0xff;
-      xt::view(this->x_buffer, xt::range(this->padding_top, bottom_lim), xt::range(0, this->padding_left), xt::range(1, this->load_k_in_lim+1, 2)) = this->padding_value >> 8;
-    }
-    
-  }
-
-}
-
 void Ne16::load_do_extract() {
   // extract x_array from x_buffer
   if(this->mode_linear) {
@@ -269,6 +153,7 @@ void Ne16::load_filter_masking() {
       xt::view(W_mask, xt::range(0, this->fs), xt::range(0, this->filter_mask_left)) = 0;
   }
   this->row_enable = xt::flatten(W_mask);
+  this->nb_row_enable = xt::sum(this->row_enable)();
 }
 
 bool Ne16::load_exit_idx() {
@@ -86,6 +86,10 @@ void Ne16::__BinConvArray(
   bool                 mode16,
   bool                 mode_linear
 ) {
+  // BinConv lanes enabled by the row and MAC masks, vs all the lanes of the array. The
+  // masks are always the ones of the accelerator, whose counts are kept up to date.
+  this->perf_mac(this->NR_COLUMN * this->nb_row_enable * this->nb_mac_enable, this->NR_COLUMN * this->COLUMN_SIZE * this->TP_IN);
+
   for(auto c=0; c<this->NR_COLUMN; c++) { // spatial loop - over columns
     xt::view(this->psum_column, c) = 0;
     for(auto r=0; r<this->COLUMN_SIZE; r++) { // spatial loop - over blocks in a column
@@ -173,8 +177,21 @@ void Ne16::__weightoffs(
       // std::cout << "block_enable_linear=" << block_enable_linear << "\n";
     }
 
-    this->__BinConvArray(weight, scale, this->depthwise ? dw_iter : 0, block_enable_linear, row_enable, mac_enable, !this->depthwise, false, false, this->mode16, this->mode_linear);
-    
+    if(!this->matrixvec_fast || this->binconv_traces || this->mode16 || this->mode_linear) {
+      this->__BinConvArray(weight, scale, this->depthwise ? dw_iter : 0, block_enable_linear, row_enable, mac_enable, !this->depthwise, false, false, this->mode16, this->mode_linear);
+    }
+    else {
+      xt::xarray<int64_t> accum_ref;
+      if(this->matrixvec_check) {
+        accum_ref = this->accum;
+        this->__BinConvArray(weight, scale, this->depthwise ? dw_iter : 0, block_enable_linear, row_enable, mac_enable, !this->depthwise, false, false, this->mode16, this->mode_linear);
+        std::swap(accum_ref, this->accum);
+      }
+      this->__BinConvArrayFast(weight.data(), read_size, scale, this->depthwise ? dw_iter : 0, row_enable, mac_enable, !this->depthwise, false);
+      if(this->matrixvec_check) {
+        this->__matrixvec_check(accum_ref, "weight offset");
+      }
+    }
   }
 }
 
@@ -183,6 +200,7 @@ void Ne16::depthwise_setup() {
   this->dw_lim = this->depthwise ? this->k_out_lim_dw : 1;
   this->dw_iter = 0;
   this->mac_enable = xt::zeros<int32_t>({this->TP_IN});
+  this->nb_mac_enable = 0;
 }
 
 void Ne16::depthwise_update_idx() {
@@ -193,9 +211,11 @@ void Ne16::weightoffs() {
   if(this->depthwise) {
     xt::view(this->mac_enable, xt::all()) = 0;
     xt::view(this->mac_enable, this->dw_iter) = 1;
+    this->nb_mac_enable = 1;
   }
   else {
     xt::view(this->mac_enable, xt::all()) = 1;
+    this->nb_mac_enable = this->TP_IN;
   }
   this->__weightoffs(this->dw_iter, this->row_enable, this->mac_enable);
 }
@@ -207,7 +227,7 @@ void Ne16::matrixvec_setup() {
   // set up streamer to address weights (32b word-based)
   // depthwise mode: layout is (subtile_nb_ki*qw, 9, TP_IN/8)
   this->base_addr_W_dw = this->weights_ptr + (k_in_major*this->qw) * this->FILTER_SIZE*this->FILTER_SIZE * 2;
-  this->vld_W_dw = Ne16VectorLoad<uint8_t>(
+  this->vld_W_dw = VectorLoad(
     this,
     this->base_addr_W_dw, // base_addr
     this->subtile_nb_ki*this->qw, // word_length
@@ -221,7 +241,7 @@ void Ne16::matrixvec_setup() {
   
   // 3x3 mode: layout is (k_out, subtile_nb_ki*qw, 9, TP_IN/8)
   this->base_addr_W_3x3 = this->weights_ptr + (k_out_major*this->TP_OUT*this->subtile_nb_ki*this->qw + k_in_major*this->qw) * this->FILTER_SIZE*this->FILTER_SIZE * (this->mode16 ? 1 : 2);
-  this->vld_W_3x3 = Ne16VectorLoad<uint8_t>(
+  this->vld_W_3x3 = VectorLoad(
     this,
     this->base_addr_W_3x3, // base_addr
     this->TP_OUT*this->subtile_nb_ki*this->qw, // word_length
@@ -235,7 +255,7 @@ void Ne16::matrixvec_setup() {
 
   // 1x1 mode: layout is (k_out, subtile_nb_ki, qw, TP_IN/8)
   this->base_addr_W_1x1 = this->weights_ptr + (k_out_major*this->TP_OUT*this->subtile_nb_ki*this->qw + k_in_major*this->qw) * (this->mode16 ? 1 : 2);
-  this->vld_W_1x1 = Ne16VectorLoad<uint8_t>(
+  this->vld_W_1x1 = VectorLoad(
     this,
     this->base_addr_W_1x1, // base_addr
     this->TP_OUT*this->subtile_nb_ki, // word_length
@@ -251,7 +271,7 @@ void Ne16::matrixvec_setup() {
   auto linear_d0_stride = (this->mode16 ? 1 : 2) * this->k_in; // distance in QW = 2 * k_in
   auto linear_d1_stride = this->qw * (this->mode16 ? 1 : 2) * this->k_in; // distance in K_IN subtiles = 32
   this->base_addr_W_linear = this->weights_ptr + this->k_out_major * this->qw * (this->mode16 ? 1 : 2) * this->k_in * 32 + k_in_major * 32;
-  this->vld_W_linear = Ne16VectorLoad<uint8_t>(
+  this->vld_W_linear = VectorLoad(
     this,
     this->base_addr_W_linear, // base_addr
     -1, // word_length
@@ -278,6 +298,34 @@ int Ne16::matrixvec_cycle() {
   // load and unpack weight bits
   int64_t cycles = 0;
   xt::xarray<uint8_t> weight_ld = vld_W.ex(read_size*2, cycles); // each packet is composed of read_size x 16 bit
+
+  // the fast kernels do not model the 16-bit and linear modes
+  if(!this->matrixvec_fast || this->binconv_traces || this->mode16 || this->mode_linear) {
+    this->__matrixvec_generic(weight_ld, k_out);
+    return (int) cycles;
+  }
+
+  xt::xarray<int64_t> accum_ref;
+  if(this->matrixvec_check) {
+    accum_ref = this->accum;
+    this->__matrixvec_generic(weight_ld, k_out);
+    std::swap(accum_ref, this->accum);
+  }
+
+  uint8_t weight[this->COLUMN_SIZE*this->TP_IN];
+  __WeightUnpackFast(weight_ld.data(), read_size, this->TP_IN, weight);
+
+  this->__BinConvArrayFast(weight, read_size, 1 << this->mv_qw_iter, k_out, this->row_enable, this->mac_enable, false, this->fs==1);
+
+  if(this->matrixvec_check) {
+    this->__matrixvec_check(accum_ref, "matrixvec");
+  }
+
+  return (int) cycles;
+}
+
+void Ne16::__matrixvec_generic(xt::xarray<uint8_t>& weight_ld, int k_out) {
+  auto read_size = (this->fs == 3) ? this->FILTER_SIZE*this->FILTER_SIZE : (this->mode_linear) ? 16 : this->qw;
   auto weight = __WeightUnpack(weight_ld, read_size, this->mode16);
   auto scale = 1 << this->mv_qw_iter;
 
@@ -296,8 +344,6 @@ int Ne16::matrixvec_cycle() {
   }
   
   this->__BinConvArray(weight, scale, k_out, block_enable_linear, this->row_enable, this->mac_enable, false, false, this->fs==1 && !this->mode_linear, this->mode16, this->mode_linear);
-
-  return (int) cycles;
 }
 
 bool Ne16::matrixvec_exit_idx() {
@@ -20,76 +20,13 @@
 
 #include <ne16.hpp>
 
-int Ne16::regfile_rd(int addr) {
-  if(addr == NE16_SPECIAL_TRACE_REG) {
-    if(this->trace_level == L0_CONFIG) {
-      return 0;
-    }
-    else if(this->trace_level == L1_ACTIV_INOUT) {
-      return 1;
-    }
-    else if(this->trace_level == L2_DEBUG) {
-      return 2;
-    }
-    else {
-      return 3;
-    }
-  }
-  else if(addr < NE16_NB_REG) {
-    if (this->cxt_cfg_ptr == 0) {
-      return this->cxt0[addr];
-    }
-    else {
-      return this->cxt1[addr];
-    }
-  }
-  else if (addr < 2*NE16_NB_REG) {
-    return this->cxt0[addr - NE16_NB_REG];
-  }
-  else {
-    return this->cxt1[addr - 2*NE16_NB_REG];
-  }
-}
-
-void Ne16::regfile_wr(int addr, int value) {
-  if(addr == NE16_SPECIAL_TRACE_REG) {
-    if(value == 0) {
-      this->trace_level = L0_CONFIG;
-    }
-    else if(value == 1) {
-      this->trace_level = L1_ACTIV_INOUT;
-    }
-    else if(value == 2) {
-      this->trace_level = L2_DEBUG;
-    }
-    else {
-      this->trace_level = L3_ALL;
-    }
-  }
-  else if (addr == NE16_SPECIAL_FORMAT_TRACE_REG) {
-    this->trace_format = value;
-  }
-  else if(addr < NE16_NB_REG) {
-    if (this->cxt_cfg_ptr == 0) {
-      this->cxt0[addr] = value;
-    }
-    else if(this->cxt_cfg_ptr == 1) {
-      this->cxt1[addr] = value;
-    }
-  }
-  else if (addr < 2*NE16_NB_REG) {
-    this->cxt0[addr - NE16_NB_REG] = value;
-  }
-  else {
-    this->cxt1[addr - 2*NE16_NB_REG] = value;
-  }
-}
-
 void Ne16::regfile_cxt() {
 
+  int *regs = this->job_regs();
+
   for(auto addr=0; addr<NE16_NB_REG; addr++) {
 
-    auto value = this->cxt_use_ptr == 0 ? this->cxt0[addr] : this->cxt1[addr];
+    auto value = regs[addr];
 
     switch(addr) {
 
@@ -251,11 +188,13 @@ void Ne16::printout() {
   this->trace.msg(vp::Trace::LEVEL_DEBUG, "(archi) OVERHEAD_MV=%d\n", this->OVERHEAD_MV);
   this->trace.msg(vp::Trace::LEVEL_DEBUG, "(archi) QUANT_PER_CYCLE=%d\n", this->QUANT_PER_CYCLE);
   // REGISTER FILE and HWPE CTRL
+  this->trace.msg(vp::Trace::LEVEL_INFO, "(ctrl) nb_contexts=%d\n", this->nb_contexts);
   this->trace.msg(vp::Trace::LEVEL_INFO, "(ctrl) cxt_cfg_ptr=%d\n", this->cxt_cfg_ptr);
   this->trace.msg(vp::Trace::LEVEL_INFO, "(ctrl) cxt_use_ptr=%d\n", this->cxt_use_ptr);
   this->trace.msg(vp::Trace::LEVEL_INFO, "(ctrl) job_pending=%d\n", this->job_pending);
   this->trace.msg(vp::Trace::LEVEL_INFO, "(ctrl) job_state=%d\n", this->job_state);
   this->trace.msg(vp::Trace::LEVEL_INFO, "(ctrl) job_id=%d\n", this->job_id);
+  this->trace.msg(vp::Trace::LEVEL_INFO, "(ctrl) cmdlist_remaining=%d\n", this->cmdlist_remaining);
   // REGISTER FILE configuration parameters
   this->trace.msg(vp::Trace::LEVEL_INFO, "(cfg) weights_ptr=%p\n", this->weights_ptr); //int
   this->trace.msg(vp::Trace::LEVEL_INFO, "(cfg) infeat_ptr=%p\n", this->infeat_ptr); //int
@@ -318,34 +257,3 @@ void Ne16::printout() {
   this->trace.msg(vp::Trace::LEVEL_DEBUG, "(model) h_in_int=%d\n", this->h_in_int);
   this->trace.msg(vp::Trace::LEVEL_DEBUG, "(model) w_in_int=%d\n", this->w_in_int);
 }
-
-void Ne16::commit() {
-  this->trace.msg(vp::Trace::LEVEL_DEBUG, "JOB COMMITTED: job_state=%d job_pending=%d job_running=%d\n", this->job_state, this->job_pending, this->job_running);
-  this->job_pending++;
-  this->job_state = 0;
-  this->cxt_cfg_ptr = 1-this->cxt_cfg_ptr;
-}
-
-int Ne16::acquire() {
-  this->trace.msg(vp::Trace::LEVEL_DEBUG, "JOB ACQUIRED: job_state=%d job_pending=%d job_running=%d\n", this->job_state, this->job_pending, this->job_running);
-  if(this->job_state == 0 & this->job_pending < 2) {
-    int job_id = (int) this->job_id++;
-    this->cxt_job_id[this->cxt_cfg_ptr] = job_id;
-    this->job_state = -2;
-    return job_id;
-  }
-  else if(this->job_pending == 2) {
-    return -1;
-  }
-  else {
-    return this->job_state;
-  }
-}
-
-bool Ne16::status() {
-  this->trace.msg(vp::Trace::LEVEL_DEBUG, "job_state=%d job_pending=%d\n", this->job_state, this->job_pending);
-  if(this->job_state == 0 & this->job_pending == 0)
-    return false;
-  else
-    return true;
-}
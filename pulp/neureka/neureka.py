@@ -18,8 +18,25 @@ import gvsoc.systree as st
 
 class Neureka(st.Component):
 
-    def __init__(self, parent, name):
+    def __init__(self, parent, name, nb_contexts=2, prefetch_depth=0,
+            matrixvec_fast=True, matrixvec_check=False):
 
         super(Neureka, self).__init__(parent, name)
 
         self.set_component('pulp.neureka.neureka')
+
+        # Number of job register contexts which can be programmed while a job is running
+        self.add_property('nb_contexts', nb_contexts)
+
+        # Number of feature tiles the load streamer can fetch ahead of the matrix-vector
+        # stage (0 keeps load and matrix-vector strictly sequential). Weights are not
+        # prefetched and still stall the matrix-vector stage as they are streamed in.
+        # Ignored for the jobs which enable the activation prefetch of the hardware.
+        self.add_property('prefetch_depth', prefetch_depth)
+
+        # Compute MATRIXVEC with the dedicated 1x1, 3x3 and depthwise kernels, which skip
+        # the disabled MACs, instead of the generic xtensor path
+        self.add_property('matrixvec_fast', matrixvec_fast)
+
+        # Run both paths and stop the simulation if the accumulators differ
+        self.add_property('matrixvec_check', matrixvec_check)
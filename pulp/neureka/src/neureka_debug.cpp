@@ -40,16 +40,6 @@ void Neureka::debug_x_array() {
     this->trace.msg(vp::Trace::LEVEL_DEBUG, copyOfStr2.c_str());
 }
 
-void Neureka::debug_accum(){
-  std::ostringstream stringStream;
-  stringStream << "accum[32,36] = \n" << (this->trace_format?std::hex:std::dec) << std::setw(8) << xt::view(this->accum,xt::range(0,1),xt::range(0,2)) << std::dec << "\n";
-  std::string copyOfStr = stringStream.str();
-  this->trace.msg(vp::Trace::LEVEL_DEBUG, copyOfStr.c_str());
-  stringStream << "accum[32,36] = \n" << (this->trace_format?std::hex:std::dec) << std::setw(8) << xt::view(this->accum,xt::range(0,1),xt::range(6,8)) << std::dec << "\n";
-  std::string copyOfStr2 = stringStream.str();
-  this->trace.msg(vp::Trace::LEVEL_DEBUG, copyOfStr2.c_str());
-}
-
 void Neureka::debug_psum_block(){
   std::ostringstream stringStream;
   stringStream << "psum_block[36,9] = \n" << (this->trace_format?std::hex:std::dec) << std::setw(8) << xt::cast<int32_t>(this->psum_block) << std::dec << "\n";
@@ -24,7 +24,7 @@
 void Neureka::fsm_start_handler(vp::Block *__this, vp::ClockEvent *event) {
   Neureka *_this = (Neureka *)__this;
   _this->state.set(START);
-  _this->running_job_id = _this->cxt_job_id[_this->cxt_use_ptr];
+  _this->job_start();
   if(_this->trace_level == L3_ALL) {
     _this->trace.msg(vp::Trace::LEVEL_DEBUG, "FSM START EVENT\n");
   }
@@ -32,7 +32,6 @@ void Neureka::fsm_start_handler(vp::Block *__this, vp::ClockEvent *event) {
   // clear state and propagate context
   _this->clear_all();
   _this->regfile_cxt();
-  _this->job_running = 1;
 
   // convenience parameters used internally in the model, but not set by register file
   _this->h_out     = (_this->subtile_nb_ho-(_this->subtile_rem_ho ? 1 : 0)) * _this->H_SIZE + _this->subtile_rem_ho;
@@ -92,21 +91,10 @@ void Neureka::fsm_handler(vp::Block *__this, vp::ClockEvent *event) {
 
 void Neureka::fsm_end_handler(vp::Block *__this, vp::ClockEvent *event) {
   Neureka *_this = (Neureka *)__this;
-  int job_id = _this->cxt_job_id[_this->cxt_use_ptr];
-  _this->job_running = 0;
-  _this->cxt_job_id[_this->cxt_use_ptr] = -1;
-  _this->cxt_use_ptr = 1-_this->cxt_use_ptr;
-  _this->job_pending--;
-  _this->irq.sync(true);
   _this->start_cycles = _this->fsm_start_event->get_cycle();
   std::cout<<"FSM START EVENT CYCLES="<<_this->start_cycles<<std::endl;
   std::cout<<"TOTAL CYCLES="<<(_this->end_cycles - _this->start_cycles)<<std::endl;
-  _this->trace.msg(vp::Trace::LEVEL_INFO, "Ending job (id=%d).\n", job_id);
-  if (!_this->fsm_start_event->is_enqueued() && _this->job_pending > 0) {
-      _this->event_enqueue(_this->fsm_start_event, 1);
-      _this->trace.msg(vp::Trace::LEVEL_DEBUG, "FSM Start Event enqueued with cycles=%d\n", _this->fsm_start_event->get_cycle());
-      _this->trace.msg(vp::Trace::LEVEL_INFO, "Starting a new job from the queue.\n");
-  }
+  _this->job_end();
   _this->activity.set(0);
   _this->state.set(IDLE);
 }
@@ -114,7 +102,9 @@ void Neureka::fsm_end_handler(vp::Block *__this, vp::ClockEvent *event) {
 void Neureka::fsm_loop() {
   auto latency = 0;
   do {
+    auto current_state = this->state.get();
     latency = this->fsm();
+    this->perf_state(current_state, latency);
   } while(latency == 0 && state.get() != END);
   if(state.get() == END && !this->fsm_end_event->is_enqueued()) {
     this->event_enqueue(this->fsm_end_event, latency);
@@ -141,44 +131,13 @@ int Neureka::fsm() {
   auto latency = 0;
   auto k_in_major_lim = 0;
 
-  this->x_buffer_traces = false;
-  this->x_buffer_traces_postload = false;
-  this->accum_traces_poststreamin = false;
-  this->accum_traces = false;
-  this->accum_traces_postmatrixvec =false;
-  this->accum_traces_normquant = false;
-  this->accum_traces_streamout = false;
-  this->psum_block_traces = false;
-  this->binconv_traces = false;
-  this->fsm_traces = false;
-  if(this->trace_level == L1_ACTIV_INOUT) {
-    this->x_buffer_traces_postload = true;
-    this->accum_traces_streamout = true;
-  }
-  if(this->trace_level == L2_DEBUG) {
-    this->x_buffer_traces_postload = true;
-    this->fsm_traces = true;
-    this->accum_traces_poststreamin = true;
-    this->accum_traces_streamout = true;
-    this->accum_traces_postmatrixvec = true;
-    this->accum_traces_normquant = true;
-  }
-  if(this->trace_level == L3_ALL) {
-    this->x_buffer_traces = true;
-    this->x_buffer_traces_postload = true;
-    this->fsm_traces = true;
-    this->accum_traces = true;
-    this->accum_traces_poststreamin = true;
-    this->accum_traces_streamout = true;
-    this->accum_traces_postmatrixvec = true;
-    this->accum_traces_normquant = true;
-  }
+  this->debug_traces_update();
 
   switch(this->state.get()) {
     
     case START:
       this->activity.set(1);
-      this->trace.msg(vp::Trace::LEVEL_INFO, "Starting a job (id=%d) with the following configuration:\n", this->cxt_job_id[this->cxt_use_ptr]);
+      this->trace.msg(vp::Trace::LEVEL_INFO, "Starting a job (id=%d) with the following configuration:\n", this->running_job_id);
       this->printout();
       this->reset_dw_weight_buffer();
 
@@ -190,6 +149,7 @@ int Neureka::fsm() {
         this->trace.msg(vp::Trace::LEVEL_DEBUG, "State START_STREAMIN\n");
       }
       this->constant_setup();
+      this->load_prefetch_sync();
       if(this->streamin) {
         this->streamin_setup();
         state_next = STREAMIN;
@@ -250,6 +210,9 @@ int Neureka::fsm() {
       latency += 6;
       if(this->activation_prefetch)
         this->load_latency = 3;
+      else if(this->prefetch_depth > 0) {
+        latency = this->load_prefetch_account(latency);
+      }
       // this->trace.msg(vp::Trace::LEVEL_DEBUG, "  After streamin load cycle=%d\n", latency);
       break;
       
@@ -286,6 +249,9 @@ int Neureka::fsm() {
       }
       if(this->activation_prefetch)
         this->load_latency += latency;
+      else if(this->prefetch_depth > 0) {
+        latency = this->load_prefetch_account(latency);
+      }
       break;
 
     case LOAD_MATRIXVEC:
@@ -310,6 +276,10 @@ int Neureka::fsm() {
         this->trace.msg(vp::Trace::LEVEL_DEBUG, "  mv_qw_lim=%d\n", mv_qw_lim); // was simply qw
       }
       state_next = MATRIXVEC;
+
+      // wait for the feature tile if it was prefetched and is not yet there
+      latency += this->load_prefetch_stall();
+
       if((this->matrixvec_latency > this->load_latency) && this->activation_prefetch)
         latency += this->matrixvec_latency - this->load_latency;
       this->matrixvec_latency = 0;
@@ -403,6 +373,9 @@ int Neureka::fsm() {
           this->streamout_setup();
           state_next = STREAMOUT;
         }
+        if(state_next != LOAD_MATRIXVEC) {
+          this->load_prefetch_release(this->clock.get_cycles() + latency);
+        }
       }
       else {
         this->matrixvec_update_idx();// for depthwise only updates w.r.t. qw
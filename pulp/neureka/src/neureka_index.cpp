@@ -21,34 +21,6 @@
 
 #include <neureka.hpp>
 
-void Neureka::k_in_major_update_idx() {
-  this->k_in_major_iter++;
-  if(this->trace_level == L3_ALL) {
-    this->trace.msg(vp::Trace::LEVEL_DEBUG, "  k_out_major=%d\n", this->k_out_major);
-    this->trace.msg(vp::Trace::LEVEL_DEBUG, "  i_major=%d\n", this->i_major);
-    this->trace.msg(vp::Trace::LEVEL_DEBUG, "  j_major=%d\n", this->j_major);
-    this->trace.msg(vp::Trace::LEVEL_DEBUG, "  k_in_major_iter=%d\n", k_in_major);
-  }
-}
-
-void Neureka::high_update_idx() {
-  if(this->j_major == this->subtile_nb_wo-1 && this->i_major == this->subtile_nb_ho-1) {
-    this->k_out_major++;
-    this->i_major = 0;
-    this->j_major = 0;
-    this->k_in_major_iter = 0;
-  }
-  else if(this->j_major == this->subtile_nb_wo-1) {
-    this->i_major++;
-    this->j_major = 0;
-    this->k_in_major_iter = 0;
-  }
-  else {
-    this->j_major++;
-    this->k_in_major_iter = 0;
-  }
-}
-
 void Neureka::next_high_update_idx() {
   if(this->next_j_major == this->subtile_nb_wo-1 && this->next_i_major == this->subtile_nb_ho-1) {
     this->next_k_out_major++;
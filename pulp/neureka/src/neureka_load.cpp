@@ -54,7 +54,7 @@ void Neureka::load_setup() {
 
   auto base_addr_x = (this->fs==1) ? this->infeat_ptr + this->i_major*infeat_hom_iter + this->j_major*infeat_wom_iter + k_in_major*this->TP_IN : this->infeat_ptr + this->i_major*infeat_hom_iter + this->j_major*infeat_wom_iter + k_in_major*this->TP_IN_S;
 
-  this->vld_x = NeurekaVectorLoad<uint8_t>(
+  this->vld_x = VectorLoad(
     this,
     base_addr_x, // base_addr
     this->h_size_in_X_w_size_in, // word_length
@@ -89,67 +89,6 @@ int Neureka::load_cycle() { // not linear
   return (int) cycles;
 }
 
-void Neureka::load_do_padding() { // not linear
-
-  // add explicit padding
-  auto right_lim  = (this->F_BUFFER_SIZE-this->padding_right  > this->w_size_in_hw) ? this->w_size_in_hw : this->F_BUFFER_SIZE-this->padding_right;
-  auto bottom_lim = (this->F_BUFFER_SIZE-this->padding_bottom > this->h_size_in_hw) ? this->h_size_in_hw : this->F_BUFFER_SIZE-this->padding_bottom;
-
-  // implicit padding (on the right/bottom) and explicit padding (all dimensions) define
-  // sixteen regions:
-  // +-------+-------+-------+-------+
-  // | TL    | T     | TR    | TRR   |
-  // +-------+-------+-------+-------+
-  // | L     | body  | R     | RR    |
-  // +-------+-------+-------+-------+
-  // | BL    | B     | BR    | BRR   |
-  // +-------+-------+-------+-------+
-  // | BBL   | BB    | BBR   | BBRR  |
-  // +-------+-------+-------+-------+
-
-  // FIXME: non0-padding values do not work in mode16 in the model, see similar bug in NE16 RTL
-  
-  // top-left
-  if(this->padding_left  > 0 && this->j_major==0 || this->padding_top > 0 && this->i_major==0) {
-    xt::view(this->x_buffer, xt::range(0, this->padding_top), xt::range(0, this->padding_left), xt::range(0, this->load_k_in_lim)) = this->padding_value;
-  }
-
-  // top
-  if(this->padding_top  > 0 && this->i_major==0) {
-    xt::view(this->x_buffer, xt::range(0, this->padding_top), xt::range(this->padding_left, right_lim), xt::range(0, this->load_k_in_lim)) = this->padding_value;
-  }
-
-  // top-right
-  if((this->padding_right > 0 && this->j_major==this->subtile_nb_wo-1 || this->padding_top > 0 && this->i_major==0) && (right_lim <= this->w_size_in_hw)) {
-    xt::view(this->x_buffer, xt::range(0, this->padding_top), xt::range(right_lim, w_size_in_hw), xt::range(0, this->load_k_in_lim)) = this->padding_value;
-  }
-
-  // right
-  if((this->padding_right > 0 && this->j_major==this->subtile_nb_wo-1) && (right_lim <= this->w_size_in_hw)) {
-    xt::view(this->x_buffer, xt::range(this->padding_top, bottom_lim), xt::range(right_lim, this->w_size_in_hw), xt::range(0, this->load_k_in_lim)) = this->padding_value;
-  }
-
-  // bottom-right
-  if((this->padding_right > 0 && this->j_major==this->subtile_nb_wo-1 || this->padding_bottom > 0 && this->i_major==this->subtile_nb_ho-1) && (right_lim <= this->w_size_in_hw) && (bottom_lim <= this->h_size_in_hw)) {
-    xt::view(this->x_buffer, xt::range(bottom_lim, h_size_in_hw), xt::range(right_lim, w_size_in_hw), xt::range(0, this->load_k_in_lim)) = this->padding_value;
-  }
-
-  // bottom
-  if((this->padding_bottom > 0 && this->i_major==this->subtile_nb_ho-1) && (bottom_lim <= this->h_size_in_hw)) {
-    xt::view(this->x_buffer, xt::range(bottom_lim, this->h_size_in_hw), xt::range(this->padding_left, right_lim), xt::range(0, this->load_k_in_lim)) = this->padding_value;
-  }
-
-  // bottom-left
-  if((this->padding_left > 0 && this->j_major==0 || this->padding_bottom > 0 && this->i_major==this->subtile_nb_ho-1) && (bottom_lim <= this->h_size_in_hw)) {
-    xt::view(this->x_buffer, xt::range(bottom_lim, this->h_size_in_hw), xt::range(0, this->padding_left), xt::range(0, this->load_k_in_lim)) = this->padding_value;
-  }
-
-  // left
-  if(this->padding_left > 0 && this->j_major==0) {
-    xt::view(this->x_buffer, xt::range(this->padding_top, bottom_lim), xt::range(0, this->padding_left), xt::range(0, this->load_k_in_lim)) = this->padding_value;
-  }
-}
-
 void Neureka::load_do_extract() {
   // extract x_array from x_buffer
   if(this->fs == 3) {
@@ -190,6 +129,7 @@ void Neureka::load_filter_masking() {
     }
   }
   this->row_enable = xt::flatten(W_mask);
+  this->nb_row_enable = xt::sum(this->row_enable)();
 }
 
 bool Neureka::load_exit_idx() {
@@ -20,6 +20,7 @@
  */
 
 // as the internal max precision of NE16 is 32 bits, this is emulated by casting x to 32 bits here
+#include <cstring>
 #include <neureka.hpp>
 xt::xarray<uint8_t> __Weight_transform_1x1(xt::xarray<uint8_t> W)
 {
@@ -133,6 +134,10 @@ void Neureka::__BinConvArray(
   bool                 weight_invert,
   bool                 use_row_as_scale
 ) {
+  // BinConv lanes enabled by the row and MAC masks, vs all the lanes of the array. The
+  // masks are always the ones of the accelerator, whose counts are kept up to date.
+  this->perf_mac(this->NR_COLUMN * this->nb_row_enable * this->nb_mac_enable, this->NR_COLUMN * this->COLUMN_SIZE * this->TP_IN);
+
   for(auto c=0; c<this->NR_COLUMN; c++) { // spatial loop - over columns
     xt::view(this->psum_column, c) = 0;
     for(auto r=0; r<this->COLUMN_SIZE; r++) { // spatial loop - over blocks in a column
@@ -163,6 +168,46 @@ void Neureka::__BinConvArray(
   }
 }
 
+// Raw-buffer versions of the weight transforms above, used by the fast MATRIXVEC
+// kernels of the engine.
+static void __Weight_transform_1x1_fast(const uint8_t *W, uint8_t *wout)
+{
+  for(int i=0; i<32; i++)
+  {
+    int index_l = 8*(i%4)+i/8;
+    int index_h = index_l+4;
+    if((i/4)%2==0){
+      wout[i] = (W[index_l] & 0x0F) + ((W[index_h] & 0x0F)<<4);
+    }
+    else{
+      wout[i] = ((W[index_l] & 0xF0)>>4) + 16*((W[index_h] & 0xF0)>>4);
+    }
+  }
+}
+
+static void __Weight_transform_28_fast(const uint8_t *W, uint8_t *wout)
+{
+  memset(wout, 0, 36);
+  for(int i=0; i<32; i++)
+  {
+    int index0 = i % 7;
+    int index1 = i / 7;
+    if(index0==3)
+    {
+      wout[index1*8+index0] = (W[i] & 0x0F);
+    }
+    else if(index0>3)
+    {
+      wout[index1*8+index0] = ((W[i-1] & 0xF0) >> 4) + ((W[i] & 0x0F)*16);
+      if(index0==6)
+        wout[index1*8+index0+1] = ((W[i] & 0xF0) >> 4);
+    }
+    else{
+      wout[index1*8+index0] = W[i];
+    }
+  }
+}
+
 void Neureka::__weightoffs(
   int dw_iter,
   xt::xarray<int32_t> row_enable,
@@ -181,8 +226,22 @@ void Neureka::__weightoffs(
     auto weight = __WeightUnpack(weight_ld, read_size, this->TP_IN); //this->mode16 & this->mode_linear);
     
     auto scale = this->Wmin;
-    
-    this->__BinConvArray(weight, scale, this->depthwise ? dw_iter : 0, row_enable, mac_enable, !this->depthwise, false, false); 
+
+    if(!this->matrixvec_fast || this->binconv_traces) {
+      this->__BinConvArray(weight, scale, this->depthwise ? dw_iter : 0, row_enable, mac_enable, !this->depthwise, false, false); 
+    }
+    else {
+      xt::xarray<int64_t> accum_ref;
+      if(this->matrixvec_check) {
+        accum_ref = this->accum;
+        this->__BinConvArray(weight, scale, this->depthwise ? dw_iter : 0, row_enable, mac_enable, !this->depthwise, false, false); 
+        std::swap(accum_ref, this->accum);
+      }
+      this->__BinConvArrayFast(weight.data(), read_size, scale, this->depthwise ? dw_iter : 0, row_enable, mac_enable, !this->depthwise, false);
+      if(this->matrixvec_check) {
+        this->__matrixvec_check(accum_ref, "weight offset");
+      }
+    }
   }
 }
 
@@ -191,6 +250,7 @@ void Neureka::depthwise_setup() {
   this->dw_lim = this->depthwise ? this->k_out_lim_dw : 1;
   this->dw_iter = 0;
   this->mac_enable = xt::zeros<int32_t>({this->TP_IN});
+  this->nb_mac_enable = 0;
 }
 
 void Neureka::depthwise_update_idx() {
@@ -201,10 +261,12 @@ void Neureka::weightoffs() {
   if(this->depthwise) {
     xt::view(this->mac_enable, xt::all()) = 0;
     xt::view(this->mac_enable, this->dw_iter) = 1;
+    this->nb_mac_enable = 1;
   }
   else {
     xt::view(this->mac_enable, xt::range(0,this->TP_IN_S)) = 1;
     xt::view(this->mac_enable, xt::range(this->TP_IN_S, this->TP_IN)) = (this->fs==3) ? 0 : 1;
+    this->nb_mac_enable = (this->fs==3) ? this->TP_IN_S : this->TP_IN;
   }
   this->__weightoffs(this->dw_iter, this->row_enable, this->mac_enable);
 }
@@ -215,7 +277,7 @@ void Neureka::matrixvec_setup() {
   // set up streamer to address weights (32b word-based)
   // depthwise mode: layout is (subtile_nb_ki*qw, 9, TP_IN/8)
   this->base_addr_W_dw = this->weights_ptr + (k_in_major*this->qw) * 8 * (this->TP_IN/8);
-  this->vld_W_dw = NeurekaVectorLoad<uint8_t>(
+  this->vld_W_dw = VectorLoad(
     this,
     this->base_addr_W_dw, // base_addr
     this->subtile_nb_ki*this->qw, // word_length
@@ -230,7 +292,7 @@ void Neureka::matrixvec_setup() {
   
   // 3x3 mode: layout is (k_out, subtile_nb_ki*qw, 9, TP_IN/8)
   this->base_addr_W_3x3 = this->weights_ptr + (k_out_major*this->TP_OUT*this->subtile_nb_ki*this->qw + k_in_major*this->qw) * 8 * (this->TP_IN/8);
-  this->vld_W_3x3 = NeurekaVectorLoad<uint8_t>(
+  this->vld_W_3x3 = VectorLoad(
     this,
     this->base_addr_W_3x3, // base_addr
     this->TP_OUT*this->subtile_nb_ki*this->qw, // word_length
@@ -244,7 +306,7 @@ void Neureka::matrixvec_setup() {
 
   // 1x1 mode: layout is (k_out, subtile_nb_ki, qw, TP_IN/8)
   this->base_addr_W_1x1 = this->weights_ptr + (k_out_major*this->TP_OUT*this->subtile_nb_ki*8 + k_in_major*8) * (this->TP_IN/8);
-  this->vld_W_1x1 = NeurekaVectorLoad<uint8_t>(
+  this->vld_W_1x1 = VectorLoad(
     this,
     this->base_addr_W_1x1, // base_addr
     this->TP_OUT*this->subtile_nb_ki, // word_length
@@ -289,26 +351,55 @@ int Neureka::matrixvec_cycle() {
     weight_ld = xt::view(this->dw_weight_buffer, this->mv_qw_iter, xt::all());
   }
 
-  std::ostringstream stringStream;
-  stringStream << "Weight Read =" << xt::view(weight_ld, xt::all())<<"\n";
-  std::string copyOfStr = stringStream.str();
-  this->trace.msg(vp::Trace::LEVEL_DEBUG, copyOfStr.c_str());
+  if (this->trace_level == L3_ALL) {
+    std::ostringstream stringStream;
+    stringStream << "Weight Read =" << xt::view(weight_ld, xt::all())<<"\n";
+    std::string copyOfStr = stringStream.str();
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, copyOfStr.c_str());
+  }
 
-  auto shape = xt::adapt(weight_ld.shape());
+  if(!this->matrixvec_fast || this->binconv_traces) {
+    this->__matrixvec_generic(weight_ld, k_out);
+    return (int) cycles;
+  }
 
-  xt::xarray<uint8_t> weight_ld_transform = (this->fs == 3) ? __Weight_transform_28(weight_ld) : __Weight_transform_1x1(weight_ld);
+  xt::xarray<int64_t> accum_ref;
+  if(this->matrixvec_check) {
+    accum_ref = this->accum;
+    this->__matrixvec_generic(weight_ld, k_out);
+    std::swap(accum_ref, this->accum);
+  }
 
-  auto weight = __WeightUnpack(weight_ld_transform, (this->fs==3) ? 9 : read_size, this->TP_IN);
-  auto scale = 1 << this->mv_qw_iter;
+  // 3x3 (dense and depthwise) weights are 9 rows of TP_IN bits, 1x1 weights are one row per bit
+  auto nb_rows = (this->fs==3) ? 9 : read_size;
+  uint8_t weight_transform[36];
+  uint8_t weight[9*this->TP_IN];
+  if(this->fs == 3) {
+    __Weight_transform_28_fast(weight_ld.data(), weight_transform);
+  }
+  else {
+    __Weight_transform_1x1_fast(weight_ld.data(), weight_transform);
+  }
+  __WeightUnpackFast(weight_transform, nb_rows, this->TP_IN, weight);
 
-  xt::xarray<int32_t> space = xt::logspace(0, 7, 8, 2);
-  space = xt::reshape_view(space, {8, 1});
+  this->__BinConvArrayFast(weight, nb_rows, 1 << this->mv_qw_iter, k_out, this->row_enable, this->mac_enable, false, this->fs==1);
 
-  this->__BinConvArray(weight, scale, k_out, this->row_enable, this->mac_enable, false, false, this->fs==1);
+  if(this->matrixvec_check) {
+    this->__matrixvec_check(accum_ref, "matrixvec");
+  }
 
   return (int) cycles;
 }
 
+void Neureka::__matrixvec_generic(xt::xarray<uint8_t>& weight_ld, int k_out) {
+  xt::xarray<uint8_t> weight_ld_transform = (this->fs == 3) ? __Weight_transform_28(weight_ld) : __Weight_transform_1x1(weight_ld);
+
+  auto weight = __WeightUnpack(weight_ld_transform, (this->fs==3) ? 9 : 8, this->TP_IN);
+  auto scale = 1 << this->mv_qw_iter;
+
+  this->__BinConvArray(weight, scale, k_out, this->row_enable, this->mac_enable, false, false, this->fs==1);
+}
+
 void Neureka::reset_dw_weight_buffer() {
   this->dw_weight_buffer = xt::zeros<uint8_t>({8, 32});
 }
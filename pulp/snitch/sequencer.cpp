@@ -28,7 +28,9 @@
 #include <vp/itf/wire.hpp>
 #include <vp/proxy.hpp>
 #include <stdio.h>
+#include <inttypes.h>
 #include <math.h>
+#include <vector>
 
 #define RISCY
 #define CONFIG_GVSOC_ISS_SNITCH
@@ -97,6 +99,19 @@ public:
     int next_entry = -1;  
     // The corresponding frep configuration
     FrepConfig config;
+
+    // Replay information, pre-decoded once when the entry is written so that
+    // the FREP loop can be replayed without walking the configuration again.
+    // Last instruction of the frep body
+    bool insn_last = false;
+    // Number of times the entry has been issued
+    int rpt_iter = 0;
+    // Staggered registers wrap every stagger_max+1 iterations
+    int stagger_period = 1;
+    // rd, rs1, rs2 and rs3 before staggering
+    int stagger_base[4] = {0, 0, 0, 0};
+    // Instruction arguments whose register index must follow the staggered registers
+    uint32_t stagger_args = 0;
 };
 
 BufferEntry::BufferEntry(OffloadReq req, bool is_outer, int max_inst, int max_rpt, int stagger_max, unsigned int stagger_mask, int base_entry, int next_entry, FrepConfig config) : 
@@ -118,10 +133,10 @@ public:
 private:
 
     // Functions for read/write logic
-    void write_entry(BufferEntry entry);
+    void write_entry(OffloadReq *req, FrepConfig *frep_config);
     void update_entry(int index);
-    BufferEntry read_entry(int index);
-    BufferEntry gen_entry(OffloadReq *req, FrepConfig *frep_config);
+    bool read_entry(int index, OffloadReq *req);
+    void gen_entry(BufferEntry &entry, OffloadReq *req, FrepConfig *frep_config);
     // Functions determining the state of the buffer
     bool isFull();
     bool isEmpty();
@@ -136,6 +151,10 @@ private:
     inline void stalled_dec();
     inline void stalled_inc();
     void reset(bool active);
+    void stop();
+
+    // Statistics
+    void stats_update();
 
     vp::Trace     trace;
     vp::ClockEvent *event;
@@ -160,9 +179,15 @@ private:
     // Generic latency of sequencer module
     int latency = 0;
 
-    // Build a ring buffer table with 16 entries
-    static const int size = 16;
-    BufferEntry RingBuffer[size];
+    // Maximum number of frep instructions replayed in the same cycle when the
+    // subsystem keeps accepting them, 1 keeps one instruction per cycle
+    int replay_batch = 1;
+
+    // Ring buffer table, the number of entries is given by the depth property.
+    // Entries are written and updated in place, only the request is copied when
+    // it is offloaded.
+    int size;
+    std::vector<BufferEntry> RingBuffer;
     // Important index for read/write operations
     int write_id = 0;
     int read_id = 0;
@@ -174,6 +199,23 @@ private:
 
     // Store latest frep configuration
     FrepConfig frep_config;
+
+    // Statistics, the cycle counters are updated each time the state of the buffer changes
+    int64_t stats_last_cycle = 0;
+    bool stats_full = false;
+    bool stats_empty = true;
+    bool stats_blocked = false;
+    int stats_occupancy = 0;
+    int64_t cycles_full = 0;
+    int64_t cycles_empty = 0;
+    int64_t cycles_blocked = 0;
+    int64_t nb_frep_iter = 0;
+    int64_t nb_fresh = 0;
+    int64_t nb_replayed = 0;
+    vp::Trace stats_trace;  // End-of-simulation summary, dumped by stop() when active
+    vp::Trace occupancy_event;
+    vp::Trace full_event;
+    vp::Trace blocked_event;
 };
 
 
@@ -181,6 +223,10 @@ sequencer::sequencer(vp::ComponentConf &config)
     : vp::Component(config)
 {
     traces.new_trace("trace", &trace, vp::DEBUG);
+    traces.new_trace("stats", &stats_trace, vp::DEBUG);
+    traces.new_trace_event("occupancy", &this->occupancy_event, 32);
+    traces.new_trace_event("full", &this->full_event, 1);
+    traces.new_trace_event("blocked", &this->blocked_event, 1);
 
     event = event_new((vp::Block *)this, offload_event);
 
@@ -197,6 +243,19 @@ sequencer::sequencer(vp::ComponentConf &config)
 
     this->latency = get_js_config()->get_child_int("latency");
 
+    this->replay_batch = get_js_config()->get_child_int("replay_batch");
+    if (this->replay_batch < 1)
+    {
+        this->replay_batch = 1;
+    }
+
+    this->size = get_js_config()->get_child_int("depth");
+    if (this->size <= 0)
+    {
+        this->trace.fatal("Invalid sequence buffer depth: %d\n", this->size);
+    }
+    this->RingBuffer.resize(this->size);
+
 }
 
 
@@ -213,19 +272,41 @@ void sequencer::offload_event(vp::Block *__this, vp::ClockEvent *event)
     // Check if the subsystem is idle
     _this->acc_req_ready_o = _this->check_state();
     _this->trace.msg(vp::Trace::LEVEL_TRACE, "Sequencer receives acceleration request output handshaking signal: %d\n", _this->acc_req_ready_o);
+    _this->stats_update();
 
-    // If the buffer has some entries, offload entry one by one each cycle
-    BufferEntry offload_entry;
-    int buf_id = _this->read_id;
+    // If the buffer has some entries, offload entry one by one each cycle.
+    // When replay batching is enabled, the following instructions of a frep body
+    // are also offloaded in the same cycle as long as the subsystem accepts them.
+    int nb_offloaded = 0;
 
     // The buffer is not empty and the subsystem is ready, offload the request from the buffer.
-    if (!_this->isEmpty() && _this->acc_req_ready_o)
+    while (!_this->isEmpty() && _this->acc_req_ready_o)
     {
-        // Read out an entry from the buffer.
-        offload_entry = _this->read_entry(buf_id);
+        int buf_id = _this->read_id;
+
+        if (nb_offloaded > 0 && (_this->RingBuffer[buf_id].isn_sequence || _this->RingBuffer[buf_id].max_rpt < 0))
+        {
+            break;
+        }
 
+        // Entries of a frep body which have already been issued once are replayed
+        BufferEntry &entry = _this->RingBuffer[buf_id];
+        if (!entry.isn_sequence && entry.rpt_iter > 0)
+        {
+            _this->nb_replayed++;
+        }
+        else
+        {
+            _this->nb_fresh++;
+        }
+        if (!entry.isn_sequence && entry.insn_last)
+        {
+            _this->nb_frep_iter++;
+        }
+
+        // Read out an entry from the buffer, directly into the output request.
         // Output handshaking, between sequencer and fp subsystem
-        _this->acc_req = offload_entry.req;
+        _this->read_entry(buf_id, &_this->acc_req);
         _this->trace.msg("Offload to fp subsystem from buffer index %d (opcode: 0x%lx, pc: 0x%lx)\n", buf_id, _this->acc_req.insn.opcode, _this->acc_req.pc);
 
         // Offload request if the port is connected
@@ -243,7 +324,15 @@ void sequencer::offload_event(vp::Block *__this, vp::ClockEvent *event)
             _this->nb_entries--;
         }
         _this->trace.msg(vp::Trace::LEVEL_TRACE, "Number of entries in the ring buffer: %d\n", _this->nb_entries);
+
+        if (++nb_offloaded >= _this->replay_batch || _this->RingBuffer[buf_id].isn_sequence)
+        {
+            break;
+        }
+
+        _this->acc_req_ready_o = _this->check_state();
     }
+    _this->stats_update();
 
     // Stall the event if the buffer is empty or the next entry to be read is invalid.
     if ((_this->isEmpty() | _this->RingBuffer[_this->read_id].max_rpt < 0) && !_this->stalled)
@@ -269,6 +358,58 @@ void sequencer::reset(bool active)
 }
 
 
+// Get called at the end of the simulation.
+void sequencer::stop()
+{
+    this->stats_update();
+
+    if (this->stats_trace.get_active())
+    {
+        this->stats_trace.msg(vp::Trace::LEVEL_INFO, "full %" PRId64 " cycles, empty %" PRId64 " cycles, blocked %" PRId64 " cycles, %" PRId64
+            " frep iterations, %" PRId64 " fresh / %" PRId64 " replayed instructions\n",
+            this->cycles_full, this->cycles_empty, this->cycles_blocked,
+            this->nb_frep_iter, this->nb_fresh, this->nb_replayed);
+    }
+}
+
+
+// Get called each time the state of the buffer may have changed, accounts the cycles
+// spent in the previous state and dumps the new one.
+// The buffer is blocked when it has entries but the subsystem does not accept them.
+void sequencer::stats_update()
+{
+    int64_t cycles = this->clock.get_cycles();
+    int64_t elapsed = cycles - this->stats_last_cycle;
+    this->stats_last_cycle = cycles;
+
+    if (this->stats_full) this->cycles_full += elapsed;
+    if (this->stats_empty) this->cycles_empty += elapsed;
+    if (this->stats_blocked) this->cycles_blocked += elapsed;
+
+    bool full = this->isFull();
+    bool empty = this->isEmpty();
+    bool blocked = !empty && !this->acc_req_ready_o;
+
+    if (full != this->stats_full)
+    {
+        this->full_event.event((uint8_t *)&full);
+    }
+    if (blocked != this->stats_blocked)
+    {
+        this->blocked_event.event((uint8_t *)&blocked);
+    }
+    if (this->nb_entries != this->stats_occupancy)
+    {
+        this->occupancy_event.event((uint8_t *)&this->nb_entries);
+        this->stats_occupancy = this->nb_entries;
+    }
+
+    this->stats_full = full;
+    this->stats_empty = empty;
+    this->stats_blocked = blocked;
+}
+
+
 // Get called when the sequencer offload event is enabled again.
 inline void sequencer::stalled_dec()
 {
@@ -353,13 +494,11 @@ void sequencer::req(vp::Block *__this, OffloadReq *req)
     
 
     // 2. Instructions are sequenced from the FPU sequence buffer. Write a new entry into the buffer.
-    BufferEntry new_entry;
     if(!insn.desc->tags[ISA_TAG_FREP_ID] && !insn.desc->tags[ISA_TAG_NSEQ_ID])
     {
         // The buffer must have vacancy after rsp_state() function.
-        new_entry = _this->gen_entry(req, &_this->frep_config);
         // Write in new requests into the buffer.
-        _this->write_entry(new_entry);
+        _this->write_entry(req, &_this->frep_config);
 
         // If the sequencer stalls, re-activate if there's new instruction.
         if(_this->stalled == true)
@@ -447,10 +586,9 @@ bool sequencer::check_state()
 
 
 // Get called when we need to generate new buffer entry according to new request and freg configuration.
-BufferEntry sequencer::gen_entry(OffloadReq *req, FrepConfig *config)
+// The entry is built in place in the buffer slot.
+void sequencer::gen_entry(BufferEntry &new_entry, OffloadReq *req, FrepConfig *config)
 {
-    BufferEntry new_entry;
-
     // Observe whether it's inside a sequence defined by a frep configuration
     bool sequence = true;
     if (((this->write_id > ((this->base_id + config->max_inst) % this->size)) & (this->write_id < this->base_id))
@@ -468,9 +606,14 @@ BufferEntry sequencer::gen_entry(OffloadReq *req, FrepConfig *config)
         // If the instruction isn't covered in frep configuration, write this instruction in buffer index write_id.
         new_entry.req = *req;
         new_entry.isn_sequence = true;
+        new_entry.is_outer = false;
+        new_entry.max_inst = -1;
         new_entry.max_rpt = 0;
+        new_entry.stagger_max = 0;
+        new_entry.stagger_mask = 0x0;
         new_entry.base_entry = this->write_id;
         new_entry.next_entry = (this->write_id + 1) % this->size;
+        new_entry.config = FrepConfig();
         this->trace.msg(vp::Trace::LEVEL_TRACE, "Generate IO req in buffer index %d (opcode: 0x%llx, pc: 0x%llx)\n", this->write_id, new_entry.req.insn.opcode, new_entry.req.pc);
     }
     else
@@ -498,6 +641,29 @@ BufferEntry sequencer::gen_entry(OffloadReq *req, FrepConfig *config)
             insn_last = true;
         }
 
+        // Pre-decode what is needed to replay the entry
+        new_entry.insn_last = insn_last;
+        new_entry.rpt_iter = 0;
+        new_entry.stagger_period = config->stagger_max + 1;
+        new_entry.stagger_base[0] = req->insn.out_regs[0];
+        new_entry.stagger_base[1] = req->insn.in_regs[0];
+        new_entry.stagger_base[2] = req->insn.in_regs[1];
+        new_entry.stagger_base[3] = req->insn.in_regs[2];
+        new_entry.stagger_args = 0;
+        if (config->stagger_max > 0)
+        {
+            int nb_args = req->insn.decoder_item->u.insn.nb_args;
+            for (int i = 0; i < nb_args; i++)
+            {
+                iss_decoder_arg_t *arg = &req->insn.decoder_item->u.insn.args[i];
+                iss_insn_arg_t *insn_arg = &req->insn.args[i];
+                if ((arg->type == ISS_DECODER_ARG_TYPE_OUT_REG || arg->type == ISS_DECODER_ARG_TYPE_IN_REG) && (insn_arg->u.reg.index != 0 || arg->flags & ISS_DECODER_ARG_FLAG_FREG))
+                {
+                    new_entry.stagger_args |= 1 << i;
+                }
+            }
+        }
+
         bool rpt_last = false;
         if (!new_entry.max_rpt)
         {
@@ -555,13 +721,11 @@ BufferEntry sequencer::gen_entry(OffloadReq *req, FrepConfig *config)
             config->stagger_mask = 0x0;
         }
     }
-
-    return new_entry;
 }
 
 
 // Get called when there is a new entry that needs to be written into the buffer.
-void sequencer::write_entry(BufferEntry entry)
+void sequencer::write_entry(OffloadReq *req, FrepConfig *config)
 {
     if (this->isFull()) 
     {
@@ -571,58 +735,57 @@ void sequencer::write_entry(BufferEntry entry)
     else
     {
         // Write new entry to write_id
-        this->RingBuffer[this->write_id] = entry;
+        this->gen_entry(this->RingBuffer[this->write_id], req, config);
         this->trace.msg("Wrote IO request in buffer index %d (opcode: 0x%llx, pc: 0x%llx)\n", this->write_id, this->RingBuffer[this->write_id].req.insn.opcode, this->RingBuffer[this->write_id].req.pc);
 
         // Update write_id for the next write operation
         this->write_id = (this->write_id + 1) % this->size;
         this->nb_entries++;
+        this->stats_update();
     }
 }
 
 
 // Get called when we read out an entry from the buffer.
-BufferEntry sequencer::read_entry(int index)
+// The request of the entry is copied to req, which is the only copy done per offloaded instruction.
+bool sequencer::read_entry(int index, OffloadReq *req)
 {
     if (this->isEmpty()) 
     {
         this->trace.msg("Sequence buffer is empty and no instruction can be read\n");
-        // Todo: write a return here to avoid accident happening.
-        // For now return a dummy one to avoid gcc warning
-        return BufferEntry();
+        return false;
     }
     else
     {
-        BufferEntry entry = this->RingBuffer[index];
+        BufferEntry &entry = this->RingBuffer[index];
+        *req = entry.req;
         this->trace.msg("Read IO request in buffer index %d (opcode: 0x%llx, pc: 0x%llx)\n", index, this->RingBuffer[index].req.insn.opcode, this->RingBuffer[index].req.pc);
 
         // Assign read_id to index of next instruction
         this->read_id = entry.next_entry;
         this->trace.msg(vp::Trace::LEVEL_TRACE, "Update buffer read_id to %d after a read\n", this->read_id);
 
-        // Update register index for trace if this instruction's stagger_max>0
-        if (!entry.isn_sequence & entry.config.stagger_max > 0)
+        // Update register index for trace if this instruction's stagger_max>0,
+        // the concerned arguments have been found when the entry was written.
+        if (!entry.isn_sequence)
         {
-            int nb_args = entry.req.insn.decoder_item->u.insn.nb_args;
-            for (int i = 0; i < nb_args; i++)
+            for (uint32_t args = entry.stagger_args; args; args &= args - 1)
             {
-                iss_decoder_arg_t *arg = &entry.req.insn.decoder_item->u.insn.args[i];
-                iss_insn_arg_t *insn_arg = &entry.req.insn.args[i];
-                if ((arg->type == ISS_DECODER_ARG_TYPE_OUT_REG || arg->type == ISS_DECODER_ARG_TYPE_IN_REG) && (insn_arg->u.reg.index != 0 || arg->flags & ISS_DECODER_ARG_FLAG_FREG))
+                int i = __builtin_ctz(args);
+                iss_decoder_arg_t *arg = &req->insn.decoder_item->u.insn.args[i];
+                iss_insn_arg_t *insn_arg = &req->insn.args[i];
+                if (arg->type == ISS_DECODER_ARG_TYPE_OUT_REG)
                 {
-                    if (arg->type == ISS_DECODER_ARG_TYPE_OUT_REG)
-                    {
-                        insn_arg->u.reg.index = entry.req.insn.out_regs[arg->u.reg.id];
-                    }
-                    else if (arg->type == ISS_DECODER_ARG_TYPE_IN_REG)
-                    {
-                        insn_arg->u.reg.index = entry.req.insn.in_regs[arg->u.reg.id];
-                    }
+                    insn_arg->u.reg.index = req->insn.out_regs[arg->u.reg.id];
+                }
+                else
+                {
+                    insn_arg->u.reg.index = req->insn.in_regs[arg->u.reg.id];
                 }
             }
         }
 
-        return entry;
+        return true;
     }
 }
 
@@ -637,122 +800,51 @@ void sequencer::update_entry(int index)
 
     if(!entry->isn_sequence)
     {
-        // Update next_entry index for the next iteration
-        bool insn_last = false;
-        // base_entry and config.max_inst are const variables after configuration.
-        if (index == ((entry->base_entry + entry->config.max_inst) % this->size))
-        {
-            insn_last = true;
-        }
-
-        bool rpt_last = false;
-        if (entry->max_rpt == 0)
-        {
-            // The next iteration is the last iterations
-            rpt_last = true;
-        }
+        // Update next_entry index for the next iteration.
+        // insn_last has been computed when the entry was written, as base_entry and
+        // config.max_inst are const variables after configuration.
+        bool rpt_last = entry->max_rpt == 0;
 
-        // Find the index of next instruction 
         if (entry->config.is_outer)
         {
-            if (!insn_last)
-            {
-                // There is still instruction following in this configuration.
-                entry->next_entry = (index + 1) % this->size; 
-            }
-            else
-            {
-                // This is the last instruction in this configuration.
-                if (!rpt_last)
-                {
-                    // If there's still iteration left, go back to the initial instruction index.
-                    entry->next_entry = entry->base_entry; 
-                }
-                else
-                {
-                    // No iteration, move to the following entry in buffer.
-                    entry->next_entry = (index + 1) % this->size; 
-                }
-            }
+            // Go back to the initial instruction index at the end of the body if there's still
+            // iteration left, otherwise move to the following entry in buffer.
+            entry->next_entry = (entry->insn_last && !rpt_last) ? entry->base_entry : (index + 1) % this->size;
         }
-        else 
-        {
-            // inner loop
-            if(rpt_last)
-            {
-                // No iteration, move to the following entry in buffer.
-                entry->next_entry = (index + 1) % this->size; 
-            }
-            else
-            {
-                // Repeat itself, next instruction remains itself
-                entry->next_entry = index;
-            }
-        }
-
-        // Update stagger related information
-        int temp_out = entry->req.insn.out_regs[0] + entry->stagger_max;
-        int temp_in1 = entry->req.insn.in_regs[0] + entry->stagger_max;
-        int temp_in2 = entry->req.insn.in_regs[1] + entry->stagger_max;
-        int temp_in3 = entry->req.insn.in_regs[2] + entry->stagger_max;
-    
-        entry->stagger_max --;
-        int stagger_cnt = entry->stagger_max;
-
-        if (entry->stagger_mask & 0x1)
+        else
         {
-            if (stagger_cnt < 0)
-            {
-                entry->stagger_max = entry->config.stagger_max;
-                entry->req.insn.out_regs[0] = temp_out - entry->stagger_max;
-            }
-            else
-            {
-                entry->req.insn.out_regs[0]++;
-            }
-            this->trace.msg(vp::Trace::LEVEL_TRACE, "Update rd to %d (stagger_mask: 0x%llx)\n", entry->req.insn.out_regs[0], entry->stagger_mask);
+            // inner loop, repeat itself until the last iteration
+            entry->next_entry = rpt_last ? (index + 1) % this->size : index;
         }
 
-        if (entry->stagger_mask & 0x2)
+        // Update stagger related information. Staggered registers are incremented at
+        // each iteration and go back to their initial value every stagger_max+1 iterations.
+        entry->rpt_iter++;
+        if (entry->stagger_mask)
         {
-            if (stagger_cnt < 0)
-            {
-                entry->stagger_max = entry->config.stagger_max;
-                entry->req.insn.in_regs[0] = temp_in1 - entry->stagger_max;
-            }
-            else
-            {
-                entry->req.insn.in_regs[0]++;
-            }
-            this->trace.msg(vp::Trace::LEVEL_TRACE, "Update rs1 to %d (stagger_mask: 0x%llx)\n", entry->req.insn.in_regs[0], entry->stagger_mask);
-        }
+            int offset = entry->rpt_iter % entry->stagger_period;
+            entry->stagger_max = entry->config.stagger_max - offset;
 
-        if (entry->stagger_mask & 0x4)
-        {
-            if (stagger_cnt < 0)
+            if (entry->stagger_mask & 0x1)
             {
-                entry->stagger_max = entry->config.stagger_max;
-                entry->req.insn.in_regs[1] = temp_in2 - entry->stagger_max;
+                entry->req.insn.out_regs[0] = entry->stagger_base[0] + offset;
+                this->trace.msg(vp::Trace::LEVEL_TRACE, "Update rd to %d (stagger_mask: 0x%llx)\n", entry->req.insn.out_regs[0], entry->stagger_mask);
             }
-            else
+            if (entry->stagger_mask & 0x2)
             {
-                entry->req.insn.in_regs[1]++;
+                entry->req.insn.in_regs[0] = entry->stagger_base[1] + offset;
+                this->trace.msg(vp::Trace::LEVEL_TRACE, "Update rs1 to %d (stagger_mask: 0x%llx)\n", entry->req.insn.in_regs[0], entry->stagger_mask);
             }
-            this->trace.msg(vp::Trace::LEVEL_TRACE, "Update rs2 to %d (stagger_mask: 0x%llx)\n", entry->req.insn.in_regs[1], entry->stagger_mask);
-        }
-
-        if (entry->stagger_mask & 0x8)
-        {
-            if (stagger_cnt < 0)
+            if (entry->stagger_mask & 0x4)
             {
-                entry->stagger_max = entry->config.stagger_max;
-                entry->req.insn.in_regs[2] = temp_in3 - entry->stagger_max;
+                entry->req.insn.in_regs[1] = entry->stagger_base[2] + offset;
+                this->trace.msg(vp::Trace::LEVEL_TRACE, "Update rs2 to %d (stagger_mask: 0x%llx)\n", entry->req.insn.in_regs[1], entry->stagger_mask);
             }
-            else
+            if (entry->stagger_mask & 0x8)
             {
-                entry->req.insn.in_regs[2]++;
+                entry->req.insn.in_regs[2] = entry->stagger_base[3] + offset;
+                this->trace.msg(vp::Trace::LEVEL_TRACE, "Update rs3 to %d (stagger_mask: 0x%llx)\n", entry->req.insn.in_regs[2], entry->stagger_mask);
             }
-            this->trace.msg(vp::Trace::LEVEL_TRACE, "Update rs3 to %d (stagger_mask: 0x%llx)\n", entry->req.insn.in_regs[2], entry->stagger_mask);
         }
 
         this->trace.msg(vp::Trace::LEVEL_TRACE, "Update sequence frep configuration in buffer index %d (is_outer: %d, max_inst: %d, max_rpt: %d, stagger_max: %d, stagger_mask: 0x%llx, base_id: %d, next_id: %d)\n", 
@@ -34,11 +34,19 @@ class Sequencer(gvsoc.systree.Component):
         The name of the component within the parent space.
     latency: int
         Global latency applied to all incoming requests. This impacts the start time of the burst.
+    depth: int
+        Number of entries of the sequence buffer.
+    replay_batch: int
+        Maximum number of frep instructions replayed in the same cycle when the subsystem
+        keeps accepting them. 1 keeps the cycle-accurate behavior of one instruction per cycle.
     """
-    def __init__(self, parent: gvsoc.systree.Component, name: str, latency: int=0):
+    def __init__(self, parent: gvsoc.systree.Component, name: str, latency: int=0, depth: int=16,
+            replay_batch: int=1):
         super(Sequencer, self).__init__(parent, name)
 
         self.set_component('pulp.snitch.sequencer')
 
         self.add_property('latency', latency)
+        self.add_property('depth', depth)
+        self.add_property('replay_batch', replay_batch)
 
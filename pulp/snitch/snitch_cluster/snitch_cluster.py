@@ -53,6 +53,7 @@ class ClusterArch:
         self.peripheral    = Area( base + 0x0002_0000, 0x0001_0000)
         self.zero_mem      = Area( base + 0x0003_0000, 0x0001_0000)
         self.core_type = properties.core_type
+        self.sequencer_depth = properties.sequencer_depth
 
     class Tcdm:
         def __init__(self, base, nb_masters):
@@ -147,7 +148,8 @@ class SnitchCluster(gvsoc.systree.Component):
                     fetch_enable=arch.auto_fetch, boot_addr=arch.boot_addr,
                     core_id=arch.first_hartid + core_id, htif=False))
                 if xfrep:
-                    fpu_sequencers.append(Sequencer(self, f'fpu_sequencer{core_id}', latency=0))
+                    fpu_sequencers.append(Sequencer(self, f'fpu_sequencer{core_id}', latency=0,
+                        depth=arch.sequencer_depth))
 
             cores_ico.append(router.Router(self, f'pe{core_id}_ico', bandwidth=arch.tcdm.bank_width))
 
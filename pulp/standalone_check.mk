@@ -0,0 +1,20 @@
+# Shared rules for the standalone checks, which build a single test program against some model
+# sources without gvsoc. The including Makefile sets CHECK, the program built from $(CHECK).cpp,
+# and optionally CHECK_SRCS, the model sources linked with it, and CHECK_DEPS, the headers it
+# depends on. Model sources and headers are found from the parent directory.
+
+CXX ?= g++
+CXXFLAGS ?= -O2 -Wall -std=c++11
+
+all: $(CHECK)
+
+$(CHECK): $(CHECK).cpp $(CHECK_SRCS) $(CHECK_DEPS)
+	$(CXX) $(CXXFLAGS) -I.. -o $@ $(CHECK).cpp $(CHECK_SRCS)
+
+run: $(CHECK)
+	./$(CHECK)
+
+clean:
+	rm -f $(CHECK)
+
+.PHONY: all run clean
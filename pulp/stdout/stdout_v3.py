@@ -25,5 +25,17 @@ class Stdout(st.Component):
         self.set_component('pulp.stdout.stdout_v3_impl')
         self.add_properties({
             'max_cluster': 33,
-            'max_core_per_cluster': 16
+            'max_core_per_cluster': 16,
+            # Prefix each line with the cycle at which it started
+            'timestamp': False,
+            # Write each core to its own stdout_cluster<c>_core<p>.log file
+            'per_core_files': False,
+            # Write from a separate thread through per-core queues
+            'async_writer': False,
+            # When the writer is woken up, after each line, once a queue holds flush_size
+            # bytes, or only at the end of the simulation
+            'flush_policy': 'line',
+            'flush_size': 4096,
+            # Size in bytes of each per-core queue, must be a power of 2
+            'queue_size': 65536
         })
\ No newline at end of file
@@ -24,8 +24,47 @@
 #include <stdio.h>
 #include <string.h>
 #include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #define MAX_PUTC_LENGTH 1024
+#define MAX_PREFIX_LENGTH 32
+
+typedef enum
+{
+  STDOUT_FLUSH_LINE,
+  STDOUT_FLUSH_SIZE,
+  STDOUT_FLUSH_EXIT
+} stdout_flush_policy_e;
+
+
+/*
+ * Lock-free single-producer single-consumer byte queue. The simulation thread pushes complete
+ * lines and the writer thread pops them.
+ */
+class Stdout_queue
+{
+public:
+  Stdout_queue(int size);
+  // Returns false if there is not enough room for the whole data
+  bool push(const char *data, int size);
+  // Returns the number of bytes copied
+  int pop(char *data, int size);
+  int64_t get_size() { return this->head.load(std::memory_order_acquire) - this->tail.load(std::memory_order_acquire); }
+  int64_t get_capacity() { return this->buffer.size(); }
+
+private:
+  std::vector<char> buffer;
+  uint64_t mask;
+  // Only written by the producer
+  std::atomic<uint64_t> head;
+  // Only written by the consumer
+  std::atomic<uint64_t> tail;
+};
+
 
 class Stdout : public vp::Component
 {
@@ -35,9 +74,17 @@ public:
   Stdout(vp::ComponentConf &config);
 
   static vp::IoReqStatus req(vp::Block *__this, vp::IoReq *req);
+  void stop();
 
 private:
 
+  void write_line(int index, char *line, int size);
+  FILE *get_file(int index);
+  Stdout_queue *get_queue(int index);
+  void wake_writer();
+  void writer_routine();
+  void drain_queues();
+
   vp::Trace     trace;
   vp::IoSlave in;
 
@@ -46,9 +93,74 @@ private:
 
   std::vector <char *> putc_buffer;
   int *putc_buffer_pos;
+  // Cycle at which the first character of the pending line was received
+  int64_t *putc_line_cycle;
+
+  bool timestamp;
+  bool per_core_files;
+  // Files are only opened once a core prints something, NULL means stdout is used
+  std::vector<FILE *> files;
 
+  // When the writer is active, lines are pushed to per-core queues and written to the files by
+  // a separate thread, so that the simulation never waits for the host output
+  bool async_writer;
+  stdout_flush_policy_e flush_policy;
+  int flush_size;
+  int queue_size;
+  std::atomic<Stdout_queue *> *queues;
+  std::thread *writer_thread;
+  std::mutex writer_mutex;
+  std::condition_variable writer_cond;
+  bool writer_pending;
+  bool writer_exit;
 };
 
+
+
+Stdout_queue::Stdout_queue(int size) : buffer(size), mask(size - 1), head(0), tail(0)
+{
+}
+
+
+
+bool Stdout_queue::push(const char *data, int size)
+{
+  uint64_t head = this->head.load(std::memory_order_relaxed);
+  uint64_t tail = this->tail.load(std::memory_order_acquire);
+
+  if (this->buffer.size() - (head - tail) < (uint64_t)size)
+    return false;
+
+  for (int i=0; i<size; i++)
+  {
+    this->buffer[(head + i) & this->mask] = data[i];
+  }
+
+  this->head.store(head + size, std::memory_order_release);
+  return true;
+}
+
+
+
+int Stdout_queue::pop(char *data, int size)
+{
+  uint64_t tail = this->tail.load(std::memory_order_relaxed);
+  uint64_t head = this->head.load(std::memory_order_acquire);
+
+  if ((uint64_t)size > head - tail)
+    size = head - tail;
+
+  for (int i=0; i<size; i++)
+  {
+    data[i] = this->buffer[(tail + i) & this->mask];
+  }
+
+  this->tail.store(tail + size, std::memory_order_release);
+  return size;
+}
+
+
+
 Stdout::Stdout(vp::ComponentConf &config)
 : vp::Component(config)
 {
@@ -60,16 +172,202 @@ Stdout::Stdout(vp::ComponentConf &config)
   nb_core = get_js_config()->get_child_int("max_core_per_cluster");
 
   putc_buffer_pos = new int[nb_cluster*nb_core];
+  putc_line_cycle = new int64_t[nb_cluster*nb_core];
   for (int j=0; j<nb_cluster; j++) {
     for (int i=0; i<nb_core; i++) {
       putc_buffer.push_back(new char[MAX_PUTC_LENGTH]);
       putc_buffer_pos[j*nb_core+i] = 0;
+      files.push_back(NULL);
     }
   }
 
+  this->timestamp = get_js_config()->get_child_bool("timestamp");
+  this->per_core_files = get_js_config()->get_child_bool("per_core_files");
+  this->async_writer = get_js_config()->get_child_bool("async_writer");
+  this->flush_size = get_js_config()->get_child_int("flush_size");
+  this->queue_size = get_js_config()->get_child_int("queue_size");
+
+  std::string flush_policy = get_js_config()->get_child_str("flush_policy");
+  if (flush_policy == "line")
+    this->flush_policy = STDOUT_FLUSH_LINE;
+  else if (flush_policy == "size")
+    this->flush_policy = STDOUT_FLUSH_SIZE;
+  else if (flush_policy == "exit")
+    this->flush_policy = STDOUT_FLUSH_EXIT;
+  else
+    throw logic_error("Unknown stdout flush policy: " + flush_policy);
+
+  if (this->queue_size < MAX_PUTC_LENGTH + MAX_PREFIX_LENGTH || (this->queue_size & (this->queue_size - 1)) != 0)
+  {
+    throw logic_error("Invalid stdout queue size, must be a power of 2 bigger than a line: " + std::to_string(this->queue_size));
+  }
+
+  this->queues = new std::atomic<Stdout_queue *>[nb_cluster*nb_core];
+  for (int i=0; i<nb_cluster*nb_core; i++)
+  {
+    this->queues[i] = NULL;
+  }
+
+  this->writer_thread = NULL;
+  this->writer_pending = false;
+  this->writer_exit = false;
+  if (this->async_writer)
+  {
+    this->writer_thread = new std::thread(&Stdout::writer_routine, this);
+  }
+}
+
+
+
+void Stdout::stop()
+{
+  if (this->writer_thread)
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->writer_mutex);
+      this->writer_exit = true;
+    }
+    this->writer_cond.notify_one();
+    this->writer_thread->join();
+    delete this->writer_thread;
+    this->writer_thread = NULL;
+  }
 
+  for (FILE *file: this->files)
+  {
+    if (file)
+      fclose(file);
+  }
+  fflush(stdout);
 }
 
+
+
+FILE *Stdout::get_file(int index)
+{
+  if (!this->per_core_files)
+    return stdout;
+
+  if (this->files[index] == NULL)
+  {
+    std::string path = "stdout_cluster" + std::to_string(index / this->nb_core) + "_core" +
+      std::to_string(index % this->nb_core) + ".log";
+    this->files[index] = fopen(path.c_str(), "w");
+    if (this->files[index] == NULL)
+    {
+      this->trace.force_warning("Unable to open stdout file, using stdout (path: %s)\n", path.c_str());
+      this->per_core_files = false;
+      return stdout;
+    }
+  }
+
+  return this->files[index];
+}
+
+
+
+Stdout_queue *Stdout::get_queue(int index)
+{
+  Stdout_queue *queue = this->queues[index].load(std::memory_order_acquire);
+  if (queue == NULL)
+  {
+    queue = new Stdout_queue(this->queue_size);
+    this->queues[index].store(queue, std::memory_order_release);
+  }
+  return queue;
+}
+
+
+
+void Stdout::wake_writer()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->writer_mutex);
+    this->writer_pending = true;
+  }
+  this->writer_cond.notify_one();
+}
+
+
+
+void Stdout::write_line(int index, char *line, int size)
+{
+  if (!this->async_writer)
+  {
+    fwrite((void *)line, 1, size, this->get_file(index));
+    return;
+  }
+
+  Stdout_queue *queue = this->get_queue(index);
+
+  // The writer is the only one which can free space, the simulation has to wait for it if the
+  // queue is full
+  while (!queue->push(line, size))
+  {
+    this->wake_writer();
+    std::this_thread::yield();
+  }
+
+  if (this->flush_policy == STDOUT_FLUSH_LINE ||
+    (this->flush_policy == STDOUT_FLUSH_SIZE && queue->get_size() >= this->flush_size))
+  {
+    this->wake_writer();
+  }
+}
+
+
+
+void Stdout::drain_queues()
+{
+  char chunk[4096];
+
+  for (int i=0; i<this->nb_cluster*this->nb_core; i++)
+  {
+    Stdout_queue *queue = this->queues[i].load(std::memory_order_acquire);
+    if (queue == NULL)
+      continue;
+
+    // Lines of a core are drained completely before going to the next core so that they are
+    // never interleaved
+    int size;
+    bool written = false;
+    FILE *file = NULL;
+    while ((size = queue->pop(chunk, sizeof(chunk))) > 0)
+    {
+      if (file == NULL)
+        file = this->get_file(i);
+      fwrite(chunk, 1, size, file);
+      written = true;
+    }
+
+    if (written)
+      fflush(file);
+  }
+}
+
+
+
+void Stdout::writer_routine()
+{
+  std::unique_lock<std::mutex> lock(this->writer_mutex);
+
+  while (1)
+  {
+    this->writer_cond.wait(lock, [this]{ return this->writer_pending || this->writer_exit; });
+    this->writer_pending = false;
+    bool exit = this->writer_exit;
+
+    lock.unlock();
+    this->drain_queues();
+    lock.lock();
+
+    if (exit)
+      break;
+  }
+}
+
+
+
 vp::IoReqStatus Stdout::req(vp::Block *__this, vp::IoReq *req)
 {
   Stdout *_this = (Stdout *)__this;
@@ -88,14 +386,26 @@ vp::IoReqStatus Stdout::req(vp::Block *__this, vp::IoReq *req)
     _this->trace.warning("Accessing invalid stdout channel (coreId: %d, clusterId: %d)\n", core_id, cluster_id);
     return vp::IO_REQ_INVALID;
   }
-  
-  _this->putc_buffer[cluster_id*_this->nb_core+core_id][_this->putc_buffer_pos[cluster_id*_this->nb_core+core_id]++] = *data;
-  if (*data == '\n' || _this->putc_buffer_pos[cluster_id*_this->nb_core+core_id] == MAX_PUTC_LENGTH - 1) {
-    _this->putc_buffer[cluster_id*_this->nb_core+core_id][_this->putc_buffer_pos[cluster_id*_this->nb_core+core_id]] = 0;
-      //if (stdoutPrefix) fprintf(stdout, "# [STDOUT-CL%d_PE%d] ", clusterId, coreId);
-    fwrite((void *)_this->putc_buffer[cluster_id*_this->nb_core+core_id], 1, _this->putc_buffer_pos[cluster_id*_this->nb_core+core_id], stdout);
-  //  if (stdoutToFile) fwrite((void *)putcBuffer[clusterId][coreId], 1, putcBufferPos[clusterId][coreId], stdoutFiles[clusterId][coreId]);
-    _this->putc_buffer_pos[cluster_id*_this->nb_core+core_id] = 0;
+
+  int index = cluster_id*_this->nb_core+core_id;
+
+  if (_this->putc_buffer_pos[index] == 0)
+    _this->putc_line_cycle[index] = _this->clock.get_cycles();
+
+  _this->putc_buffer[index][_this->putc_buffer_pos[index]++] = *data;
+  if (*data == '\n' || _this->putc_buffer_pos[index] == MAX_PUTC_LENGTH - 1) {
+    if (_this->timestamp)
+    {
+      char line[MAX_PREFIX_LENGTH + MAX_PUTC_LENGTH];
+      int prefix_size = snprintf(line, MAX_PREFIX_LENGTH, "[%ld] ", _this->putc_line_cycle[index]);
+      memcpy(&line[prefix_size], _this->putc_buffer[index], _this->putc_buffer_pos[index]);
+      _this->write_line(index, line, prefix_size + _this->putc_buffer_pos[index]);
+    }
+    else
+    {
+      _this->write_line(index, _this->putc_buffer[index], _this->putc_buffer_pos[index]);
+    }
+    _this->putc_buffer_pos[index] = 0;
   }
 
   return vp::IO_REQ_OK;
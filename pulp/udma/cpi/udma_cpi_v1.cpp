@@ -38,6 +38,22 @@ Cpi_periph_v1::Cpi_periph_v1(udma *top, int id, int itf_id) : Udma_periph(top, i
 
   cpi_itf.set_sync_meth(&Cpi_periph_v1::sync);
   cpi_itf.set_sync_cycle_meth(&Cpi_periph_v1::sync_cycle);
+
+  this->stream = NULL;
+  js::Config *stream_config = top->get_js_config()->get("cpi/streams/" + itf_name);
+  if (stream_config)
+  {
+    this->stream = new Udma_file_source(&this->trace, stream_config);
+    this->stream_width = stream_config->get_child_int("width");
+    this->stream_height = stream_config->get_child_int("height");
+    if (this->stream_width <= 0 || this->stream_height <= 0)
+    {
+      throw logic_error("Invalid CPI stream resolution: " + std::to_string(this->stream_width) +
+        "x" + std::to_string(this->stream_height));
+    }
+    this->stream_line_buffer = new uint8_t[this->stream_width * 2];
+    this->stream_event = top->event_new((vp::Block *)this, Cpi_periph_v1::stream_handler);
+  }
 }
  
 
@@ -46,6 +62,12 @@ void Cpi_periph_v1::reset(bool active)
   Udma_periph::reset(active);
 
   this->glob = 0;
+
+  if (this->stream && !active && !this->stream_event->is_enqueued())
+  {
+    this->stream_line = 0;
+    this->top->event_enqueue(this->stream_event, this->stream->get_period());
+  }
 }
 
 
@@ -293,6 +315,55 @@ void Cpi_periph_v1::sync_cycle(vp::Block *__this, int href, int vsync, int data)
 
 
 
+/* Pushes the next line of the file source, or starts a new frame. Pixels are made of 2 bytes,
+   the first one being the MSB, as on the pins */
+void Cpi_periph_v1::stream_handler(vp::Block *__this, vp::ClockEvent *event)
+{
+  Cpi_periph_v1 *_this = (Cpi_periph_v1 *)__this;
+  int line_bytes = _this->stream_width * 2;
+  int64_t line_cycles = line_bytes * _this->stream->get_period();
+
+  if (_this->stream_line == 0)
+  {
+    _this->handle_sof();
+
+    // Frames are not consumed from the file until a transfer is ready to receive them, so that
+    // the same frames are seen whatever the time the software takes to start
+    if (!_this->cmd_ready)
+    {
+      _this->top->event_enqueue(_this->stream_event, line_cycles * _this->stream_height);
+      return;
+    }
+  }
+
+  int size = _this->stream->read(_this->stream_line_buffer, line_bytes);
+  if (size < line_bytes)
+  {
+    _this->trace.msg("CPI stream is over\n");
+    return;
+  }
+
+  if (_this->enabled && (!_this->frameDrop || !_this->frameDropCount))
+  {
+    for (int i=0; i<line_bytes; i+=2)
+    {
+      _this->push_pixel((_this->stream_line_buffer[i] << 8) | _this->stream_line_buffer[i+1]);
+    }
+  }
+
+  _this->stream_line++;
+  if (_this->stream_line == _this->stream_height)
+  {
+    _this->stream_line = 0;
+  }
+
+  _this->top->event_enqueue(_this->stream_event, line_cycles);
+}
+
+
+
+
+
 Cpi_rx_channel::Cpi_rx_channel(udma *top, Cpi_periph_v1 *periph, int id, string name) : Udma_rx_channel(top, id, name), periph(periph)
 {
 }
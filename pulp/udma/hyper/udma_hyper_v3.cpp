@@ -67,6 +67,13 @@ Hyper_periph_v3::Hyper_periph_v3(udma *top, int id, int itf_id) : Udma_periph(to
 
   this->cfg_setup = new bool[HYPER_NB_CHANNELS]{false};
   this->command_word = new bool[HYPER_NB_CHANNELS]{false};
+
+  this->burst_mode = top->get_js_config()->get_child_bool("hyper/burst_mode");
+  this->ddr_width = top->get_js_config()->get_child_int("hyper/ddr_width");
+  if (this->ddr_width <= 0)
+  {
+    this->ddr_width = 2;
+  }
 }
  
 
@@ -99,8 +106,64 @@ void Hyper_periph_v3::rx_sync(vp::Block *__this, int data)
 
 
 void Hyper_periph_v3::handle_pending_word(vp::Block *__this, vp::ClockEvent *event)
-{   
+{
   Hyper_periph_v3 *_this = (Hyper_periph_v3 *)__this;
+
+  if (_this->burst_mode)
+  {
+    _this->handle_burst();
+  }
+  else
+  {
+    _this->handle_step();
+  }
+
+  _this->check_state();
+}
+
+
+/* Transaction-level mode. All the steps of the protocol are executed in a row as long as data
+   is available, only the release of the chip select, which ends the transfer, is delayed until the
+   end of the burst computed when it was started */
+void Hyper_periph_v3::handle_burst()
+{
+  int64_t cycles = this->top->get_periph_clock()->clock.get_engine()->get_cycles();
+
+  while (1)
+  {
+    if (this->state == HYPER_STATE_CS_OFF && this->next_bit_cycle > cycles)
+    {
+      break;
+    }
+
+    if (this->pending_bytes == 0 && !this->ending)
+    {
+      this->load_pending_bytes();
+      if (this->pending_bytes == 0)
+      {
+        break;
+      }
+    }
+
+    this->handle_step();
+  }
+}
+
+
+/* Duration in periph clock cycles of a burst, including chip select, command/address and latency.
+   The bus transfers ddr_width bytes per HyperBus clock cycle. */
+int64_t Hyper_periph_v3::get_burst_cycles(int size, int latency)
+{
+  int64_t clk_cycles = this->clkdiv > 0 ? this->clkdiv : 1;
+  int64_t ca_cycles = (6 + this->ddr_width - 1) / this->ddr_width;
+  int64_t data_cycles = (size + this->ddr_width - 1) / this->ddr_width;
+
+  return clk_cycles * (1 + ca_cycles + latency + data_cycles);
+}
+
+
+void Hyper_periph_v3::handle_step()
+{
   uint8_t byte;
   int cs;
   int cs_value;
@@ -108,141 +171,151 @@ void Hyper_periph_v3::handle_pending_word(vp::Block *__this, vp::ClockEvent *eve
   bool send_cs = false;
   bool end = false;  
 
-  if (_this->state == HYPER_STATE_IDLE)
+  if (this->state == HYPER_STATE_IDLE)
   {
-    if (_this->pending_bytes > 0)
+    if (this->pending_bytes > 0)
     {
-      _this->delay = _this->current_command->latency << _this->current_command->en_add_latency;
+      this->delay = this->current_command->latency << this->current_command->en_add_latency;
       /* Skip to the end of delay part of the protocol */
-      _this->next_bit_cycle = _this->top->get_periph_clock()->clock.get_engine()->get_cycles() + _this->clkdiv + _this->delay;
-      _this->delay = 0;
-      _this->state = HYPER_STATE_CS;     
-
-      _this->ca_count = 6;
-      _this->ca.low_addr = ARCHI_REG_FIELD_GET(_this->current_command->ex_addr, 0, 3);
-      _this->ca.high_addr = ARCHI_REG_FIELD_GET(_this->current_command->ex_addr, 3, 29);      
-      _this->ca.burst_type = ARCHI_REG_FIELD_GET(_this->current_command->ca_setup, 0, 1);
-      _this->ca.address_space = ARCHI_REG_FIELD_GET(_this->current_command->ca_setup, 1, 1);
-      _this->ca.read = ARCHI_REG_FIELD_GET(_this->current_command->ca_setup, 2, 1); 
-
-      if(!_this->command_mode)
+      this->next_bit_cycle = this->top->get_periph_clock()->clock.get_engine()->get_cycles() + this->clkdiv + this->delay;
+      this->state = HYPER_STATE_CS;     
+
+      this->ca_count = 6;
+      this->ca.low_addr = ARCHI_REG_FIELD_GET(this->current_command->ex_addr, 0, 3);
+      this->ca.high_addr = ARCHI_REG_FIELD_GET(this->current_command->ex_addr, 3, 29);      
+      this->ca.burst_type = ARCHI_REG_FIELD_GET(this->current_command->ca_setup, 0, 1);
+      this->ca.address_space = ARCHI_REG_FIELD_GET(this->current_command->ca_setup, 1, 1);
+      this->ca.read = ARCHI_REG_FIELD_GET(this->current_command->ca_setup, 2, 1); 
+
+      if(!this->command_mode)
       {
-        if (_this->ca.read)
+        if (this->ca.read)
         {
-          _this->transfer_size = _this->rx_channel->current_cmd->size;         
+          this->transfer_size = this->rx_channel->current_cmd->size;         
         }
         else
         {
-          _this->transfer_size = _this->tx_channel->current_cmd->size;
+          this->transfer_size = this->tx_channel->current_cmd->size;
         }
       }
       else
       {
         /* Command mode writes just an half-word */
-        _this->transfer_size = 2;
+        this->transfer_size = 2;
+      }
+
+      if (this->burst_mode)
+      {
+        this->next_bit_cycle = this->top->get_periph_clock()->clock.get_engine()->get_cycles() +
+          this->get_burst_cycles(this->transfer_size, this->delay);
+        this->trace.msg("%d: Starting burst (size: %d, end_cycle: %ld)\n", this->channel_id, this->transfer_size, this->next_bit_cycle);
       }
+      this->delay = 0;
     }
   }
-  else if (_this->state == HYPER_STATE_CS)
+  else if (this->state == HYPER_STATE_CS)
   {
-    _this->state = HYPER_STATE_CA;
+    this->state = HYPER_STATE_CA;
     send_cs = true;
     /* Selects first  the right device */
-    _this->set_device(_this->current_command->mem_sel);
-    cs = _this->mem_sel;
+    this->set_device(this->current_command->mem_sel);
+    cs = this->mem_sel;
     cs_value = 1;
   }
-  else if (_this->state == HYPER_STATE_CA)
+  else if (this->state == HYPER_STATE_CA)
   {
     send_byte = true;
-    _this->ca_count--;
-    byte = _this->ca.raw[_this->ca_count];
-    if (_this->ca_count == 0)
+    this->ca_count--;
+    byte = this->ca.raw[this->ca_count];
+    if (this->ca_count == 0)
     {
-      _this->state = HYPER_STATE_DATA;
+      this->state = HYPER_STATE_DATA;
     }
   }
-  else if (_this->state == HYPER_STATE_DATA && _this->pending_bytes > 0)
+  else if (this->state == HYPER_STATE_DATA && this->pending_bytes > 0)
   {
     send_byte = true;
 
     // /* If L2 request is misaligned skips the number of more loaded bytes, just the first time and during transaction from L2 to memory */
-    // if(_this->current_command->is_write && _this->current_command->extra_size)
+    // if(this->current_command->is_write && this->current_command->extra_size)
     // {
-    //   _this->trace.msg(vp::Trace::LEVEL_DEBUG, "%d:DATA (skipping %d bytes)\n", _this->channel_id, _this->current_command->extra_size);
-    //   _this->pending_word >>= (8 * _this->current_command->extra_size);
-    //   _this->pending_bytes -= _this->current_command->extra_size;
-    //   _this->transfer_size -= _this->current_command->extra_size;
-    //   _this->current_command->extra_size = 0;
+    //   this->trace.msg(vp::Trace::LEVEL_DEBUG, "%d:DATA (skipping %d bytes)\n", this->channel_id, this->current_command->extra_size);
+    //   this->pending_word >>= (8 * this->current_command->extra_size);
+    //   this->pending_bytes -= this->current_command->extra_size;
+    //   this->transfer_size -= this->current_command->extra_size;
+    //   this->current_command->extra_size = 0;
     // }
 
-    byte = _this->pending_word & 0xff;
-    _this->pending_word >>= 8;
-    _this->pending_bytes--;
-    _this->transfer_size--;
+    byte = this->pending_word & 0xff;
+    this->pending_word >>= 8;
+    this->pending_bytes--;
+    this->transfer_size--;
 
-    if (_this->transfer_size == 0)
+    if (this->transfer_size == 0)
     {  
-      _this->pending_bytes = 0;
-      _this->state = HYPER_STATE_CS_OFF;
+      this->pending_bytes = 0;
+      this->state = HYPER_STATE_CS_OFF;
       /* To naturally conclude the transaction */
-      _this->ending = true;
+      this->ending = true;
     }
-    if (_this->pending_bytes == 0)
+    if (this->pending_bytes == 0)
     {
       end = true;
     }
   }
-  else if (_this->state == HYPER_STATE_CS_OFF)
+  else if (this->state == HYPER_STATE_CS_OFF)
   {
-    _this->state = HYPER_STATE_IDLE;
+    this->state = HYPER_STATE_IDLE;
     send_cs = true;
-    cs = _this->mem_sel;
+    cs = this->mem_sel;
     cs_value = 0;
 
     /* Nothing will be fetched until the whole 2d transaction is completed */
-    if(_this->twd_count)
+    if(this->twd_count)
     {
-      _this->transfer_splitter();
+      this->transfer_splitter();
     }
     else
     {
-      if(_this->get_nb_tran(_this->channel_id) == 0)
+      if(this->get_nb_tran(this->channel_id) == 0)
       {
-        _this->set_busy_reg(_this->channel_id, 0);
-        _this->common_regs[(TRANS_ID_ALLOC_OFFSET)/4] = _this->update_trans_id_alloc();
-        _this->trace.msg("Current transfer is finished\n");
-        if (!_this->ca.read)
+        this->set_busy_reg(this->channel_id, 0);
+        this->common_regs[(TRANS_ID_ALLOC_OFFSET)/4] = this->update_trans_id_alloc();
+        this->trace.msg("Current transfer is finished\n");
+        if (!this->ca.read)
         {
-          _this->top->trigger_event(ARCHI_SOC_EVENT_HYPER_EOT_TX);
+          this->top->trigger_event(ARCHI_SOC_EVENT_HYPER_EOT_TX);
         }
         else
         {
-          _this->top->trigger_event(ARCHI_SOC_EVENT_HYPER_EOT_RX);
+          this->top->trigger_event(ARCHI_SOC_EVENT_HYPER_EOT_RX);
         }
       }
     }
-    _this->ending = false;
+    this->ending = false;
   }
 
   if (send_byte || send_cs)
   {
-    if (!_this->hyper_itf.is_bound())
+    if (!this->hyper_itf.is_bound())
     {
-      _this->trace.warning("%d: Trying to send to HYPER interface while it is not connected\n", _this->channel_id);
+      this->trace.warning("%d: Trying to send to HYPER interface while it is not connected\n", this->channel_id);
     }
     else
     {
-      _this->next_bit_cycle = _this->top->get_periph_clock()->clock.get_engine()->get_cycles() + _this->clkdiv;
+      if (!this->burst_mode)
+      {
+        this->next_bit_cycle = this->top->get_periph_clock()->clock.get_engine()->get_cycles() + this->clkdiv;
+      }
       if (send_byte)
       {
-        _this->trace.msg("%d: Sending byte (value: 0x%x)\n", _this->channel_id, byte);
-        _this->hyper_itf.sync_cycle(byte);
+        this->trace.msg("%d: Sending byte (value: 0x%x)\n", this->channel_id, byte);
+        this->hyper_itf.sync_cycle(byte);
       }
       else
       {
-        _this->trace.msg("%d: Updating CS (cs: %d, value: %d)\n", _this->channel_id, cs, cs_value);
-        _this->hyper_itf.cs_sync(cs, cs_value);
+        this->trace.msg("%d: Updating CS (cs: %d, value: %d)\n", this->channel_id, cs, cs_value);
+        this->hyper_itf.cs_sync(cs, cs_value);
       }
     }
   }
@@ -250,31 +323,28 @@ void Hyper_periph_v3::handle_pending_word(vp::Block *__this, vp::ClockEvent *eve
   if (end)
   {
     /* Transaction is resetted only when whole 2d transfer is completed */
-    if(_this->ending && _this->twd_count == 0)
+    if(this->ending && this->twd_count == 0)
     {
-      _this->free_fifo[_this->channel_id]->push(_this->current_command);
-      _this->current_command = NULL;
-      _this->update_nb_tran(_this->channel_id, -1);
+      this->free_fifo[this->channel_id]->push(this->current_command);
+      this->current_command = NULL;
+      this->update_nb_tran(this->channel_id, -1);
     }
 
-    if(!_this->command_mode)
+    if(!this->command_mode)
     {
-      if (!_this->ca.read)
+      if (!this->ca.read)
       {
-        _this->pending_tx = false;
-        _this->tx_channel->handle_ready_req_end(_this->pending_req);
-        _this->tx_channel->handle_ready_reqs();
+        this->pending_tx = false;
+        this->tx_channel->handle_ready_req_end(this->pending_req);
+        this->tx_channel->handle_ready_reqs();
       }
       else
-        _this->pending_rx = false;
+        this->pending_rx = false;
     }
   }
-
-  _this->check_state();
-
 }
 
-void Hyper_periph_v3::check_state()
+void Hyper_periph_v3::load_pending_bytes()
 {
   if (this->pending_bytes == 0 && !this->ending)
   {
@@ -300,14 +370,21 @@ void Hyper_periph_v3::check_state()
       }
     }
   }
+}
+
+void Hyper_periph_v3::check_state()
+{
+  this->load_pending_bytes();
 
   if (this->pending_bytes != 0 || this->ending)
   {
     if (!this->pending_word_event->is_enqueued())
     {
+      // In burst mode, next_bit_cycle is the end of the whole burst, only the chip select release
+      // waits for it, the data arriving from L2 during the burst is handled straight away
       int latency = 1;
       int64_t cycles = this->top->get_periph_clock()->clock.get_engine()->get_cycles();
-      if (this->next_bit_cycle > cycles)
+      if (this->next_bit_cycle > cycles && (!this->burst_mode || this->state == HYPER_STATE_CS_OFF))
         latency = this->next_bit_cycle - cycles;
 
       this->top->get_periph_clock()->enqueue_ext(this->pending_word_event, latency);
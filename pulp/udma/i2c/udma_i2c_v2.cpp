@@ -24,6 +24,7 @@
 #include "archi/udma/i2c/udma_i2c_v2.h"
 #include "archi/utils.h"
 #include "vp/itf/i2c.hpp"
+#include <inttypes.h>
 
 
 I2c_periph_v2::I2c_periph_v2(udma *top, int id, int itf_id) : Udma_periph(top, id)
@@ -31,6 +32,7 @@ I2c_periph_v2::I2c_periph_v2(udma *top, int id, int itf_id) : Udma_periph(top, i
   std::string itf_name = "i2c" + std::to_string(itf_id);
 
   top->traces.new_trace(itf_name, &trace, vp::DEBUG);
+  top->traces.new_trace(itf_name + "/stats", &stats_trace, vp::DEBUG);
 
   channel0 = new I2c_rx_channel(top, this, UDMA_EVENT_ID(id), itf_name + "_rx");
   channel1 = new I2c_tx_channel(top, this, UDMA_EVENT_ID(id) + 1, itf_name + "_tx");
@@ -38,6 +40,8 @@ I2c_periph_v2::I2c_periph_v2(udma *top, int id, int itf_id) : Udma_periph(top, i
   top->new_master_port(itf_name, &i2c_itf, (vp::Block *)this);
 
   i2c_itf.set_sync_meth(&I2c_periph_v2::rx_sync);
+
+  this->transaction_mode = top->get_js_config()->get_child_bool("i2c/transaction_mode");
 }
  
 
@@ -53,7 +57,78 @@ void I2c_periph_v2::reset(bool active)
     this->waiting_rx = false;
     this->gen_ack = false;
     this->waiting_pending_bits = true;
+    this->slave_addr = -1;
+  }
+}
+
+
+
+void I2c_periph_v2::stop()
+{
+  if (this->stats_trace.get_active())
+  {
+    for (auto &it: this->slave_stats)
+    {
+      I2c_slave_stats &stats = it.second;
+      this->stats_trace.msg(vp::Trace::LEVEL_INFO, "slave 0x%x: transactions: %" PRId64 ", written bytes: %" PRId64
+        ", read bytes: %" PRId64 ", cycles: %" PRId64 "\n",
+        it.first, stats.nb_transactions, stats.nb_written_bytes,
+        stats.nb_read_bytes, stats.cycles);
+    }
+  }
+}
+
+
+
+/* A transaction goes from a start to the next start or stop, the first written byte gives
+   the slave address and the direction */
+void I2c_periph_v2::transaction_start(int64_t cycles)
+{
+  this->transaction_end(cycles);
+  this->slave_addr = -2;
+  this->slave_bytes = 0;
+  this->slave_start_cycle = cycles;
+}
+
+
+
+void I2c_periph_v2::transaction_byte(uint32_t value)
+{
+  if (this->slave_addr == -2)
+  {
+    this->slave_addr = value >> 1;
+    this->slave_is_read = value & 1;
+  }
+  else if (this->slave_addr >= 0)
+  {
+    this->slave_bytes++;
+  }
+}
+
+
+
+void I2c_periph_v2::transaction_end(int64_t cycles)
+{
+  if (this->slave_addr < 0)
+  {
+    this->slave_addr = -1;
+    return;
   }
+
+  int64_t duration = cycles - this->slave_start_cycle;
+
+  this->trace.msg("Transaction done (slave: 0x%x, %s, bytes: %d, cycles: %ld)\n",
+    this->slave_addr, this->slave_is_read ? "read" : "write", this->slave_bytes, duration);
+
+  I2c_slave_stats &stats = this->slave_stats[this->slave_addr];
+  stats.nb_transactions++;
+  stats.cycles += duration;
+  if (this->slave_is_read)
+    stats.nb_read_bytes += this->slave_bytes;
+  else
+    stats.nb_written_bytes += this->slave_bytes;
+
+  this->slave_addr = -1;
 }
 
 
@@ -104,37 +179,99 @@ std::string get_command_name(unsigned int command)
 void I2c_tx_channel::handle_pending_word(vp::Block *__this, vp::ClockEvent *event)
 {
   I2c_tx_channel *_this = (I2c_tx_channel *)__this;
+  int64_t cycles = _this->top->clock.get_engine()->get_cycles();
+
+  if (_this->periph->transaction_mode)
+  {
+    // Chain all the steps for which commands are available in the same event, so that a whole
+    // start/address/data/stop sequence is sent at once. Each step is accounted at the cycle it
+    // would have been executed in bit-level mode. The step consuming the last byte of a request
+    // is kept for the next event, at its own cycle, since it is the one releasing the request.
+    // Releasing it pops the next request, which already schedules the event at the cycle of the
+    // next step, so the chain also stops there.
+    int nb_steps = 0;
+    while (_this->has_pending_step() && (nb_steps == 0 || !_this->step_ends_req())
+      && !_this->pending_word_event->is_enqueued())
+    {
+      _this->handle_step(cycles);
+      nb_steps++;
+      cycles = _this->next_bit_cycle > cycles + 1 ? _this->next_bit_cycle : cycles + 1;
+    }
+    _this->next_bit_cycle = cycles;
+  }
+  else
+  {
+    _this->handle_step(cycles);
+  }
+
+  _this->check_state();
+}
+
+
+
+bool I2c_tx_channel::has_pending_step()
+{
+  return this->pending_bits != 0 || !this->periph->waiting_pending_bits || this->periph->waiting_rx;
+}
+
 
-  if (_this->periph->waiting_rx)
+
+/* Tells if the next step consumes the last byte of the current request */
+bool I2c_tx_channel::step_ends_req()
+{
+  if (this->pending_bits != 8 || this->periph->waiting_rx)
+    return false;
+
+  switch (this->periph->state)
+  {
+    case I2C_PERIPH_STATE_WAIT_CMD:
+      return this->periph->repeat_count == 0;
+    case I2C_PERIPH_STATE_WAIT_RPT_CMD:
+    case I2C_PERIPH_STATE_WAIT_CFG:
+    case I2C_PERIPH_STATE_WAIT_RPT:
+      return true;
+    case I2C_PERIPH_STATE_WR1:
+      return this->periph->pending_value_bits == 0;
+    default:
+      return false;
+  }
+}
+
+
+
+void I2c_tx_channel::handle_step(int64_t cycles)
+{
+  if (this->periph->waiting_rx)
   {
-    _this->periph->prev_scl ^= 1;
-    _this->periph->i2c_itf.sync(_this->periph->prev_scl, 0);
+    this->periph->prev_scl ^= 1;
+    this->periph->i2c_itf.sync(this->periph->prev_scl, 0);
 
-    if (_this->periph->prev_scl)
+    if (this->periph->prev_scl)
     {
-      _this->next_bit_cycle = _this->top->clock.get_engine()->get_cycles() + _this->periph->clkdiv;
+      this->next_bit_cycle = cycles + this->periph->clkdiv;
 
-      if (_this->periph->gen_ack)
+      if (this->periph->gen_ack)
       {
-        _this->periph->waiting_rx = false;
-        _this->periph->gen_ack = false;
+        this->periph->waiting_rx = false;
+        this->periph->gen_ack = false;
       }
       else
       {
-        int bit = _this->periph->pending_rx_bit;
+        int bit = this->periph->pending_rx_bit;
 
-        _this->periph->pending_value = (_this->periph->pending_value << 1) | bit;
-        _this->periph->pending_value_bits--;
+        this->periph->pending_value = (this->periph->pending_value << 1) | bit;
+        this->periph->pending_value_bits--;
 
-        _this->periph->trace.msg("Sampled bit (value: 0x%x, pending_value: 0x%x, pending_word_bits: %d)\n", bit, _this->periph->pending_value & 0xff, _this->periph->pending_value_bits);
+        this->periph->trace.msg("Sampled bit (value: 0x%x, pending_value: 0x%x, pending_word_bits: %d)\n", bit, this->periph->pending_value & 0xff, this->periph->pending_value_bits);
 
-        if (_this->periph->pending_value_bits == 0)
+        if (this->periph->pending_value_bits == 0)
         {
-          _this->periph->trace.msg("Sampled byte, pushing to channel (value: 0x%x)\n", _this->periph->pending_value & 0xff);
+          this->periph->trace.msg("Sampled byte, pushing to channel (value: 0x%x)\n", this->periph->pending_value & 0xff);
 
-          (static_cast<I2c_rx_channel *>(_this->periph->channel0))->push_data((uint8_t *)&_this->periph->pending_value, 1);
+          (static_cast<I2c_rx_channel *>(this->periph->channel0))->push_data((uint8_t *)&this->periph->pending_value, 1);
+          this->periph->transaction_byte(this->periph->pending_value & 0xff);
           
-          _this->periph->gen_ack = true;
+          this->periph->gen_ack = true;
         }
       }
     }
@@ -146,184 +283,185 @@ void I2c_tx_channel::handle_pending_word(vp::Block *__this, vp::ClockEvent *even
     bool end = false;
     bool stop = false;
 
-    uint8_t pending_byte =  _this->pending_word & 0xff;
-    _this->periph->trace.msg("Handling byte (value: 0x%x)\n", pending_byte);
+    uint8_t pending_byte =  this->pending_word & 0xff;
+    this->periph->trace.msg("Handling byte (value: 0x%x)\n", pending_byte);
 
-    if (_this->periph->state == I2C_PERIPH_STATE_WAIT_CMD || _this->periph->state == I2C_PERIPH_STATE_WAIT_RPT_CMD)
+    if (this->periph->state == I2C_PERIPH_STATE_WAIT_CMD || this->periph->state == I2C_PERIPH_STATE_WAIT_RPT_CMD)
     {
       unsigned int command = pending_byte;
 
-      if (_this->periph->state == I2C_PERIPH_STATE_WAIT_CMD && _this->periph->repeat_count)
+      if (this->periph->state == I2C_PERIPH_STATE_WAIT_CMD && this->periph->repeat_count)
       {
-        _this->periph->repeat_count--;
-        command = _this->periph->repeat_command;
+        this->periph->repeat_count--;
+        command = this->periph->repeat_command;
       }
       else
       {
-        _this->pending_word >>= 8;
-        _this->pending_bits -= 8;
+        this->pending_word >>= 8;
+        this->pending_bits -= 8;
 
-        if (_this->periph->state == I2C_PERIPH_STATE_WAIT_RPT_CMD)
+        if (this->periph->state == I2C_PERIPH_STATE_WAIT_RPT_CMD)
         {
-          _this->periph->repeat_command = command;
-          _this->periph->repeat_count--;
+          this->periph->repeat_command = command;
+          this->periph->repeat_count--;
         }
       }
 
-      _this->periph->trace.msg("Received command (value: 0x%x, name: %s)\n", command, get_command_name(command).c_str());
+      this->periph->trace.msg("Received command (value: 0x%x, name: %s)\n", command, get_command_name(command).c_str());
 
       switch (command)
       {
         case I2C_CMD_CFG:
-          _this->periph->state = I2C_PERIPH_STATE_WAIT_CFG;
-          _this->periph->pending_value_bits = 0;
+          this->periph->state = I2C_PERIPH_STATE_WAIT_CFG;
+          this->periph->pending_value_bits = 0;
           break;
         case I2C_CMD_START:
-          _this->periph->state = I2C_PERIPH_STATE_START0;
-          _this->periph->waiting_pending_bits = false;
+          this->periph->transaction_start(cycles);
+          this->periph->state = I2C_PERIPH_STATE_START0;
+          this->periph->waiting_pending_bits = false;
           bit = 1;
           scl = 1;
           break;
         case I2C_CMD_STOP:
-          _this->periph->state = I2C_PERIPH_STATE_STOP0;
-          _this->periph->waiting_pending_bits = false;
+          this->periph->transaction_end(cycles);
+          this->periph->state = I2C_PERIPH_STATE_STOP0;
+          this->periph->waiting_pending_bits = false;
           bit = 0;
           scl = 0;
           break;
         case I2C_CMD_WR:
-          _this->periph->state = I2C_PERIPH_STATE_WR0;
-          _this->periph->pending_value_bits = 8;
+          this->periph->state = I2C_PERIPH_STATE_WR0;
+          this->periph->pending_value_bits = 8;
           break;
         case I2C_CMD_RD_NACK:
         case I2C_CMD_RD_ACK:
-          _this->periph->state = I2C_PERIPH_STATE_WAIT_CMD;
-          _this->periph->waiting_rx = true;
-          _this->periph->pending_value_bits = 8;
+          this->periph->state = I2C_PERIPH_STATE_WAIT_CMD;
+          this->periph->waiting_rx = true;
+          this->periph->pending_value_bits = 8;
           break;
         case I2C_CMD_RPT:
-          _this->periph->state = I2C_PERIPH_STATE_WAIT_RPT;
+          this->periph->state = I2C_PERIPH_STATE_WAIT_RPT;
           break;
         case I2C_CMD_WAIT:
           break;
-        default: _this->periph->trace.force_warning("Unknown command (value: 0x%x)\n", command);
+        default: this->periph->trace.force_warning("Unknown command (value: 0x%x)\n", command);
       }
     }
-    else if (_this->periph->state == I2C_PERIPH_STATE_WAIT_CFG)
+    else if (this->periph->state == I2C_PERIPH_STATE_WAIT_CFG)
     {
-      if (_this->periph->pending_value_bits == 0)
-        _this->periph->pending_value = pending_byte << 8;
+      if (this->periph->pending_value_bits == 0)
+        this->periph->pending_value = pending_byte << 8;
       else
       {
-        _this->periph->clkdiv = _this->periph->pending_value | pending_byte;
-        _this->periph->state = I2C_PERIPH_STATE_WAIT_CMD;
-        _this->periph->trace.msg("Configuring clock divider (value: %d)\n", _this->periph->clkdiv);
+        this->periph->clkdiv = this->periph->pending_value | pending_byte;
+        this->periph->state = I2C_PERIPH_STATE_WAIT_CMD;
+        this->periph->trace.msg("Configuring clock divider (value: %d)\n", this->periph->clkdiv);
       }
 
-      _this->periph->pending_value_bits += 8;
-      _this->pending_bits -= 8;
-      _this->pending_word >>= 8;
+      this->periph->pending_value_bits += 8;
+      this->pending_bits -= 8;
+      this->pending_word >>= 8;
     }
-    else if (_this->periph->state == I2C_PERIPH_STATE_WR0)
+    else if (this->periph->state == I2C_PERIPH_STATE_WR0)
     {
       scl = 0;
-      if (_this->periph->pending_value_bits == 8)
+      if (this->periph->pending_value_bits == 8)
       {
-        _this->periph->pending_value = _this->pending_word & 0xff;
+        this->periph->pending_value = this->pending_word & 0xff;
+        this->periph->transaction_byte(this->periph->pending_value);
       }
 
 
-      bit = (_this->periph->pending_value >> 7) & 1;
-      _this->periph->prev_sda = bit;
-      _this->periph->pending_value <<= 1;
-      _this->periph->pending_value_bits--;
+      bit = (this->periph->pending_value >> 7) & 1;
+      this->periph->prev_sda = bit;
+      this->periph->pending_value <<= 1;
+      this->periph->pending_value_bits--;
 
-      _this->periph->state = I2C_PERIPH_STATE_WR1;
+      this->periph->state = I2C_PERIPH_STATE_WR1;
     }
-    else if (_this->periph->state == I2C_PERIPH_STATE_WR1)
+    else if (this->periph->state == I2C_PERIPH_STATE_WR1)
     {
       scl = 1;
-      bit = _this->periph->prev_sda;
+      bit = this->periph->prev_sda;
 
-      if (_this->periph->pending_value_bits == 0)
+      if (this->periph->pending_value_bits == 0)
       {
-        _this->periph->state = I2C_PERIPH_STATE_ACK0;
-        _this->pending_bits -= 8;
-        _this->pending_word = _this->pending_word >> 8;
+        this->periph->state = I2C_PERIPH_STATE_ACK0;
+        this->pending_bits -= 8;
+        this->pending_word = this->pending_word >> 8;
       }
       else
       {
-        _this->periph->state = I2C_PERIPH_STATE_WR0;
+        this->periph->state = I2C_PERIPH_STATE_WR0;
       }
     }
-    else if (_this->periph->state == I2C_PERIPH_STATE_ACK0)
+    else if (this->periph->state == I2C_PERIPH_STATE_ACK0)
     {
       scl = 0;
       bit = 1;
-      _this->periph->state = I2C_PERIPH_STATE_ACK1;
+      this->periph->state = I2C_PERIPH_STATE_ACK1;
     }
-    else if (_this->periph->state == I2C_PERIPH_STATE_ACK1)
+    else if (this->periph->state == I2C_PERIPH_STATE_ACK1)
     {
       scl = 1;
       bit = 1;
-      _this->periph->state = I2C_PERIPH_STATE_WAIT_CMD;
+      this->periph->state = I2C_PERIPH_STATE_WAIT_CMD;
     }
-    else if (_this->periph->state == I2C_PERIPH_STATE_WAIT_RPT)
+    else if (this->periph->state == I2C_PERIPH_STATE_WAIT_RPT)
     {
-      _this->periph->repeat_count = pending_byte;
-      _this->periph->trace.msg("Configuring repeat mode (iterations: %d)\n", _this->periph->repeat_count);
+      this->periph->repeat_count = pending_byte;
+      this->periph->trace.msg("Configuring repeat mode (iterations: %d)\n", this->periph->repeat_count);
 
-      _this->pending_bits -= 8;
-      _this->pending_word >>= 8;
+      this->pending_bits -= 8;
+      this->pending_word >>= 8;
       if (pending_byte)
-        _this->periph->state = I2C_PERIPH_STATE_WAIT_RPT_CMD;
+        this->periph->state = I2C_PERIPH_STATE_WAIT_RPT_CMD;
       else
-        _this->periph->state = I2C_PERIPH_STATE_WAIT_CMD;
+        this->periph->state = I2C_PERIPH_STATE_WAIT_CMD;
     }
-    else if (_this->periph->state == I2C_PERIPH_STATE_STOP0)
+    else if (this->periph->state == I2C_PERIPH_STATE_STOP0)
     {
-      _this->periph->state = I2C_PERIPH_STATE_STOP1;
+      this->periph->state = I2C_PERIPH_STATE_STOP1;
       bit = 0;
       scl = 1;
     }
-    else if (_this->periph->state == I2C_PERIPH_STATE_START0)
+    else if (this->periph->state == I2C_PERIPH_STATE_START0)
     {
-      _this->periph->state = I2C_PERIPH_STATE_WAIT_CMD;
-      _this->periph->waiting_pending_bits = true;
+      this->periph->state = I2C_PERIPH_STATE_WAIT_CMD;
+      this->periph->waiting_pending_bits = true;
       bit = 0;
       scl = 1;
     }
-    else if (_this->periph->state == I2C_PERIPH_STATE_STOP1)
+    else if (this->periph->state == I2C_PERIPH_STATE_STOP1)
     {
-      _this->periph->state = I2C_PERIPH_STATE_WAIT_CMD;
-      _this->periph->waiting_pending_bits = true;
+      this->periph->state = I2C_PERIPH_STATE_WAIT_CMD;
+      this->periph->waiting_pending_bits = true;
       bit = 1;
       scl = 1;
     }
 
     if (bit != -1)
     {
-      if (!_this->periph->i2c_itf.is_bound())
+      if (!this->periph->i2c_itf.is_bound())
       {
-        _this->top->warning.force_warning("Trying to send to I2C interface while it is not connected\n");
+        this->top->warning.force_warning("Trying to send to I2C interface while it is not connected\n");
       }
       else
       {
-        _this->next_bit_cycle = _this->top->clock.get_engine()->get_cycles() + _this->periph->clkdiv;
-        _this->periph->trace.msg("Sending bit (scl: %d, sda: %d)\n", scl, bit);
-        _this->periph->i2c_itf.sync(scl, bit);
-        _this->periph->prev_scl = scl;
+        this->next_bit_cycle = cycles + this->periph->clkdiv;
+        this->periph->trace.msg("Sending bit (scl: %d, sda: %d)\n", scl, bit);
+        this->periph->i2c_itf.sync(scl, bit);
+        this->periph->prev_scl = scl;
       }
     }
 
-    if (_this->pending_bits == 0 && _this->pending_req)
+    if (this->pending_bits == 0 && this->pending_req)
     {
-      _this->handle_ready_req_end(_this->pending_req);
-      _this->pending_req = NULL;
+      this->handle_ready_req_end(this->pending_req);
+      this->pending_req = NULL;
     }
-    _this->handle_ready_reqs();
+    this->handle_ready_reqs();
   }
-
-  _this->check_state();
 }
 
 
@@ -333,18 +471,7 @@ void I2c_tx_channel::check_state()
   if (pending_word_event->is_enqueued())
     return;
 
-  bool enqueue = false;
-
-  if (this->pending_bits != 0)
-    enqueue = true;
-
-  if (!this->periph->waiting_pending_bits)
-    enqueue = true;
-
-  if (this->periph->waiting_rx)
-    enqueue = true;
-
-  if (enqueue)
+  if (this->has_pending_step())
   {
     int latency = 1;
     int64_t cycles = this->top->clock.get_engine()->get_cycles();
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+#include "i2s_cic_filter.hpp"
+
+
+I2s_cic_filter::I2s_cic_filter() : pdm_pending_bits(0)
+{
+  this->pdm_y1_old = 0;
+  this->pdm_y2_old = 0;
+  this->pdm_y3_old = 0;
+  this->pdm_y4_old = 0;
+  this->pdm_y5_old = 0;
+  this->pdm_z1_old = 0;
+  this->pdm_z2_old = 0;
+  this->pdm_z3_old = 0;
+  this->pdm_z4_old = 0;
+  this->pdm_z5_old = 0;
+  this->pdm_zin1_old = 0;
+  this->pdm_zin2_old = 0;
+  this->pdm_zin3_old = 0;
+  this->pdm_zin4_old = 0;
+  this->pdm_zin5_old = 0;
+}
+
+
+void I2s_cic_filter::reset()
+{
+  this->pdm_pending_bits = 0;
+}
+
+
+
+void I2s_cic_filter::integrate(int64_t value)
+{
+  // The integrators are pipelined, each stage takes the previous output of the stage before
+  this->pdm_y5_old = this->pdm_y5_old + this->pdm_y4_old;
+  this->pdm_y4_old = this->pdm_y4_old + this->pdm_y3_old;
+  this->pdm_y3_old = this->pdm_y3_old + this->pdm_y2_old;
+  this->pdm_y2_old = this->pdm_y2_old + this->pdm_y1_old;
+  this->pdm_y1_old = this->pdm_y1_old + value;
+}
+
+
+
+uint32_t I2s_cic_filter::comb(int pdm_shift)
+{
+  int64_t y5 = this->pdm_y5_old;
+
+  int64_t z1 = y5         - this->pdm_zin1_old;
+  int64_t z2 = this->pdm_z1_old - this->pdm_zin2_old;
+  int64_t z3 = this->pdm_z2_old - this->pdm_zin3_old;
+  int64_t z4 = this->pdm_z3_old - this->pdm_zin4_old;
+  int64_t z5 = this->pdm_z4_old - this->pdm_zin5_old;
+
+  this->pdm_zin1_old = y5;
+  this->pdm_zin2_old = this->pdm_z1_old;
+  this->pdm_zin3_old = this->pdm_z2_old;
+  this->pdm_zin4_old = this->pdm_z3_old;
+  this->pdm_zin5_old = this->pdm_z4_old;
+
+  this->pdm_z1_old = z1;
+  this->pdm_z2_old = z2;
+  this->pdm_z3_old = z3;
+  this->pdm_z4_old = z4;
+  this->pdm_z5_old = z5;
+
+  return z5 >> pdm_shift;
+}
+
+
+
+bool I2s_cic_filter::handle_bit(int din, int pdm_decimation, int pdm_shift, uint32_t *dout)
+{
+  this->integrate(din == 0 ? -1 : 1);
+
+  this->pdm_pending_bits++;
+  if (this->pdm_pending_bits == pdm_decimation)
+  {
+    this->pdm_pending_bits = 0;
+    *dout = this->comb(pdm_shift);
+    return true;
+  }
+
+  return false;
+}
+
+
+
+int64_t I2s_cic_filter::byte_table[256][5];
+bool I2s_cic_filter::byte_table_init = false;
+
+void I2s_cic_filter::init_byte_table()
+{
+  I2s_cic_filter filter;
+
+  for (int byte=0; byte<256; byte++)
+  {
+    filter.pdm_y1_old = filter.pdm_y2_old = filter.pdm_y3_old = filter.pdm_y4_old = filter.pdm_y5_old = 0;
+
+    for (int i=0; i<8; i++)
+    {
+      filter.integrate((byte >> i) & 1 ? 1 : -1);
+    }
+
+    byte_table[byte][0] = filter.pdm_y1_old;
+    byte_table[byte][1] = filter.pdm_y2_old;
+    byte_table[byte][2] = filter.pdm_y3_old;
+    byte_table[byte][3] = filter.pdm_y4_old;
+    byte_table[byte][4] = filter.pdm_y5_old;
+  }
+
+  byte_table_init = true;
+}
+
+
+
+/* Applies 8 integrator steps at once. The integrators are linear so the new state is the state
+   propagated through 8 steps without input, whose coefficients are the binomials C(8, k), plus
+   the contribution of the input bits taken from the table */
+void I2s_cic_filter::integrate_byte(int byte)
+{
+  int64_t y1 = this->pdm_y1_old;
+  int64_t y2 = this->pdm_y2_old;
+  int64_t y3 = this->pdm_y3_old;
+  int64_t y4 = this->pdm_y4_old;
+  int64_t y5 = this->pdm_y5_old;
+  int64_t *contrib = byte_table[byte];
+
+  this->pdm_y1_old = y1 + contrib[0];
+  this->pdm_y2_old = y2 + 8*y1 + contrib[1];
+  this->pdm_y3_old = y3 + 8*y2 + 28*y1 + contrib[2];
+  this->pdm_y4_old = y4 + 8*y3 + 28*y2 + 56*y1 + contrib[3];
+  this->pdm_y5_old = y5 + 8*y4 + 28*y3 + 56*y2 + 70*y1 + contrib[4];
+}
+
+
+
+int I2s_cic_filter::handle_word(uint64_t din, int nb_bits, int pdm_decimation, int pdm_shift, uint32_t *dout)
+{
+  int nb_samples = 0;
+
+  if (!byte_table_init)
+    I2s_cic_filter::init_byte_table();
+
+  while (nb_bits > 0)
+  {
+    // Integrate up to the next decimation point or to the end of the word
+    int bits = pdm_decimation - this->pdm_pending_bits;
+    if (bits > nb_bits)
+      bits = nb_bits;
+
+    nb_bits -= bits;
+    this->pdm_pending_bits += bits;
+
+    for (; bits >= 8; bits -= 8)
+    {
+      this->integrate_byte(din & 0xff);
+      din >>= 8;
+    }
+
+    for (; bits > 0; bits--)
+    {
+      this->integrate(din & 1 ? 1 : -1);
+      din >>= 1;
+    }
+
+    if (this->pdm_pending_bits == pdm_decimation)
+    {
+      this->pdm_pending_bits = 0;
+      dout[nb_samples++] = this->comb(pdm_shift);
+    }
+  }
+
+  return nb_samples;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+#ifndef __PULP_UDMA_I2S_I2S_CIC_FILTER_HPP__
+#define __PULP_UDMA_I2S_I2S_CIC_FILTER_HPP__
+
+#include <stdint.h>
+
+/*
+ * 5-stage CIC decimation filter of the PDM mode
+ */
+
+class I2s_cic_filter {
+public:
+  I2s_cic_filter();
+
+  bool handle_bit(int din, int pdm_decimation, int pdm_shift, uint32_t *dout);
+  // Same as handle_bit for nb_bits packed bits, LSB first. Decimated outputs are written to dout,
+  // which must have room for nb_bits / pdm_decimation + 1 samples, and their number is returned.
+  int handle_word(uint64_t din, int nb_bits, int pdm_decimation, int pdm_shift, uint32_t *dout);
+  void reset();
+
+  int     pdm_pending_bits;
+  int64_t pdm_y1_old;
+  int64_t pdm_y2_old;
+  int64_t pdm_y3_old;
+  int64_t pdm_y4_old;
+  int64_t pdm_y5_old;
+  int64_t pdm_z1_old;
+  int64_t pdm_z2_old;
+  int64_t pdm_z3_old;
+  int64_t pdm_z4_old;
+  int64_t pdm_z5_old;
+  int64_t pdm_zin1_old;
+  int64_t pdm_zin2_old;
+  int64_t pdm_zin3_old;
+  int64_t pdm_zin4_old;
+  int64_t pdm_zin5_old;
+
+private:
+  void integrate(int64_t value);
+  void integrate_byte(int byte);
+  uint32_t comb(int pdm_shift);
+
+  static void init_byte_table();
+  // Contribution of each possible byte of PDM bits to the 5 integrators, starting from a null state
+  static int64_t byte_table[256][5];
+  static bool byte_table_init;
+};
+
+#endif
@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Standalone bit-exactness check of the PDM CIC filter. The block path (handle_word) and the
+// per-bit path (handle_bit) are compared against the original per-bit filter for several
+// decimations, shifts and word sizes. Also reports the throughput of both paths.
+// Run with "make run".
+
+#include <stdio.h>
+#include <stdint.h>
+#include <chrono>
+#include <vector>
+#include "i2s_cic_filter.hpp"
+
+// Original per-bit CIC filter, kept as reference
+class Ref_cic_filter
+{
+public:
+  bool handle_bit(int din, int pdm_decimation, int pdm_shift, uint32_t *dout)
+  {
+    int64_t value = din == 0 ? -1 : 1;
+    int64_t y1 = this->y1_old + value;
+    int64_t y2 = this->y2_old + this->y1_old;
+    int64_t y3 = this->y3_old + this->y2_old;
+    int64_t y4 = this->y4_old + this->y3_old;
+    int64_t y5 = this->y5_old + this->y4_old;
+
+    this->y1_old = y1;
+    this->y2_old = y2;
+    this->y3_old = y3;
+    this->y4_old = y4;
+    this->y5_old = y5;
+
+    this->pending_bits++;
+    if (this->pending_bits == pdm_decimation)
+    {
+      this->pending_bits = 0;
+
+      int64_t z1 = y5         - this->zin1_old;
+      int64_t z2 = this->z1_old - this->zin2_old;
+      int64_t z3 = this->z2_old - this->zin3_old;
+      int64_t z4 = this->z3_old - this->zin4_old;
+      int64_t z5 = this->z4_old - this->zin5_old;
+
+      this->zin1_old = y5;
+      this->zin2_old = this->z1_old;
+      this->zin3_old = this->z2_old;
+      this->zin4_old = this->z3_old;
+      this->zin5_old = this->z4_old;
+
+      this->z1_old = z1;
+      this->z2_old = z2;
+      this->z3_old = z3;
+      this->z4_old = z4;
+      this->z5_old = z5;
+
+      *dout = z5 >> pdm_shift;
+      return true;
+    }
+
+    return false;
+  }
+
+private:
+  int pending_bits = 0;
+  int64_t y1_old = 0, y2_old = 0, y3_old = 0, y4_old = 0, y5_old = 0;
+  int64_t z1_old = 0, z2_old = 0, z3_old = 0, z4_old = 0, z5_old = 0;
+  int64_t zin1_old = 0, zin2_old = 0, zin3_old = 0, zin4_old = 0, zin5_old = 0;
+};
+
+static uint64_t rand_state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t rand64()
+{
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 7;
+  rand_state ^= rand_state << 17;
+  return rand_state;
+}
+
+// PDM streams are kept to a few thousand bits so that the 5th integrator does not overflow
+static std::vector<uint64_t> gen_words(int pattern, int nb_words)
+{
+  std::vector<uint64_t> words;
+  for (int i=0; i<nb_words; i++)
+  {
+    switch (pattern)
+    {
+      case 0: words.push_back(rand64()); break;
+      case 1: words.push_back(~0ULL); break;
+      case 2: words.push_back(0); break;
+      case 3: words.push_back(0x5555555555555555ULL); break;
+      // Mostly ones, as for a signal close to full scale
+      default: words.push_back(rand64() | rand64() | rand64()); break;
+    }
+  }
+  return words;
+}
+
+static int check(int decimation, int shift, int word_bits, int pattern)
+{
+  std::vector<uint64_t> words = gen_words(pattern, 8192 / word_bits);
+  Ref_cic_filter ref;
+  I2s_cic_filter block, bit;
+  std::vector<uint32_t> ref_out, block_out, bit_out;
+  uint32_t results[65];
+
+  for (uint64_t word: words)
+  {
+    for (int i=0; i<word_bits; i++)
+    {
+      uint32_t result;
+      if (ref.handle_bit((word >> i) & 1, decimation, shift, &result))
+        ref_out.push_back(result);
+      if (bit.handle_bit((word >> i) & 1, decimation, shift, &result))
+        bit_out.push_back(result);
+    }
+
+    int nb_results = block.handle_word(word, word_bits, decimation, shift, results);
+    block_out.insert(block_out.end(), results, results + nb_results);
+  }
+
+  if (block_out != ref_out || bit_out != ref_out)
+  {
+    printf("  FAILED: decimation %d, shift %d, %d-bit words, pattern %d: %d/%d/%d samples\n",
+      decimation, shift, word_bits, pattern, (int)ref_out.size(), (int)block_out.size(), (int)bit_out.size());
+    return 1;
+  }
+
+  return 0;
+}
+
+// Words split into chunks of random sizes, so that the decimation points fall anywhere
+static int check_chunks(int decimation)
+{
+  std::vector<uint64_t> words = gen_words(0, 128);
+  Ref_cic_filter ref;
+  I2s_cic_filter block;
+  std::vector<uint32_t> ref_out, block_out;
+  uint32_t results[65];
+
+  for (uint64_t word: words)
+  {
+    int offset = 0;
+    while (offset < 64)
+    {
+      int nb_bits = 1 + rand64() % (64 - offset);
+      uint64_t chunk = nb_bits == 64 ? word : (word >> offset) & ((1ULL << nb_bits) - 1);
+
+      for (int i=0; i<nb_bits; i++)
+      {
+        uint32_t result;
+        if (ref.handle_bit((chunk >> i) & 1, decimation, 0, &result))
+          ref_out.push_back(result);
+      }
+
+      int nb_results = block.handle_word(chunk, nb_bits, decimation, 0, results);
+      block_out.insert(block_out.end(), results, results + nb_results);
+      offset += nb_bits;
+    }
+  }
+
+  if (block_out != ref_out)
+  {
+    printf("  FAILED: decimation %d with random chunks\n", decimation);
+    return 1;
+  }
+
+  return 0;
+}
+
+static void bench(int decimation)
+{
+  const int nb_words = 1 << 20;
+  std::vector<uint64_t> words = gen_words(0, 256);
+  uint32_t results[33];
+  uint64_t sum = 0;
+
+  // The filters are restarted every 256 words so that the integrators do not overflow
+  I2s_cic_filter block;
+  auto start = std::chrono::steady_clock::now();
+  for (int i=0; i<nb_words; i++)
+  {
+    if ((i & 255) == 0) block = I2s_cic_filter();
+    int nb_results = block.handle_word(words[i & 255] & 0xffffffff, 32, decimation, 0, results);
+    for (int j=0; j<nb_results; j++) sum += results[j];
+  }
+  double block_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  I2s_cic_filter bit;
+  start = std::chrono::steady_clock::now();
+  for (int i=0; i<nb_words; i++)
+  {
+    if ((i & 255) == 0) bit = I2s_cic_filter();
+    uint64_t word = words[i & 255];
+    for (int j=0; j<32; j++)
+    {
+      uint32_t result;
+      if (bit.handle_bit((word >> j) & 1, decimation, 0, &result)) sum += result;
+    }
+  }
+  double bit_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("Decimation %d: handle_word %.2f Gbit/s, handle_bit %.2f Gbit/s (checksum %llx)\n", decimation,
+    nb_words * 32.0 / block_time / 1e9, nb_words * 32.0 / bit_time / 1e9, (unsigned long long)sum);
+}
+
+int main()
+{
+  static const int decimations[] = { 1, 3, 7, 8, 16, 32, 33, 64, 100, 256 };
+  static const int shifts[] = { 0, 5, 20, 35 };
+  static const int word_sizes[] = { 32, 64 };
+  int nb_errors = 0;
+  int nb_checks = 0;
+
+  for (int decimation: decimations)
+  {
+    for (int shift: shifts)
+    {
+      for (int word_bits: word_sizes)
+      {
+        for (int pattern=0; pattern<5; pattern++)
+        {
+          nb_errors += check(decimation, shift, word_bits, pattern);
+          nb_checks++;
+        }
+      }
+    }
+
+    nb_errors += check_chunks(decimation);
+    nb_checks++;
+  }
+
+  bench(32);
+  bench(64);
+
+  if (nb_errors)
+  {
+    printf("%d/%d checks failed\n", nb_errors, nb_checks);
+    return 1;
+  }
+
+  printf("All %d checks passed\n", nb_checks);
+  return 0;
+}
@@ -338,6 +338,14 @@ I2s_rx_channel::I2s_rx_channel(udma *top, I2s_periph *periph, int id, int event_
   {
     this->filters[i] = new I2s_cic_filter();
   }
+
+  this->stream = NULL;
+  js::Config *stream_config = top->get_js_config()->get("i2s/streams/" + name);
+  if (stream_config)
+  {
+    this->stream = new Udma_file_source(&periph->trace, stream_config);
+    this->stream_event = top->event_new((vp::Block *)this, I2s_rx_channel::stream_handler);
+  }
 }
 
 void I2s_rx_channel::reset(bool active)
@@ -351,96 +359,77 @@ void I2s_rx_channel::reset(bool active)
   {
     this->filters[i]->reset();
   }
-}
-
 
-I2s_cic_filter::I2s_cic_filter() : pdm_pending_bits(0)
-{
-  this->pdm_y1_old = 0;
-  this->pdm_y2_old = 0;
-  this->pdm_y3_old = 0;
-  this->pdm_y4_old = 0;
-  this->pdm_y5_old = 0;
-  this->pdm_z1_old = 0;
-  this->pdm_z2_old = 0;
-  this->pdm_z3_old = 0;
-  this->pdm_z4_old = 0;
-  this->pdm_z5_old = 0;
-  this->pdm_zin1_old = 0;
-  this->pdm_zin2_old = 0;
-  this->pdm_zin3_old = 0;
-  this->pdm_zin4_old = 0;
-  this->pdm_zin5_old = 0;
-}
-
-
-void I2s_cic_filter::reset()
-{
-  this->pdm_pending_bits = 0;
+  if (this->stream && !active && !this->stream_event->is_enqueued())
+  {
+    this->stream_started = false;
+    this->top->event_enqueue(this->stream_event, this->stream->get_period());
+  }
 }
 
 
 
-bool I2s_cic_filter::handle_bit(int din, int pdm_decimation, int pdm_shift, uint32_t *dout)
+/* Feeds the channel from the file source, one 32-bit word per event. PDM streams go through the
+   CIC filter as on the pins while PCM streams are directly pushed as samples */
+void I2s_rx_channel::stream_handler(vp::Block *__this, vp::ClockEvent *event)
 {
+  I2s_rx_channel *_this = (I2s_rx_channel *)__this;
+  int64_t period = _this->stream->get_period();
 
-  int64_t value = din == 0 ? -1 : 1;
-
-  int64_t y1 = this->pdm_y1_old + value;
-  int64_t y2 = this->pdm_y2_old + this->pdm_y1_old;
-  int64_t y3 = this->pdm_y3_old + this->pdm_y2_old;
-  int64_t y4 = this->pdm_y4_old + this->pdm_y3_old;
-  int64_t y5 = this->pdm_y5_old + this->pdm_y4_old;
-
-  //gv_trace_dumpMsg(&channel->trace, "Enqueueing bit to CIC filter (channel: %s, bit: %d, value: %d, pendingBits: %d, decimator: %d)\n", id ? "R" : "L", din, value, pdm_pending_bits, pdm_decimation);
-
-  this->pdm_y1_old = y1;
-  this->pdm_y2_old = y2;
-  this->pdm_y3_old = y3;
-  this->pdm_y4_old = y4;
-  this->pdm_y5_old = y5;
-
-        //printf("INT %lx %lx %lx %lx %lx\n", y1, y2, y3, y4, y5);
-
-  this->pdm_pending_bits++;
-  if (this->pdm_pending_bits == pdm_decimation)
+  // The stream is not consumed until the first transfer is ready, so that the same samples are
+  // received whatever the time the software takes to start
+  if (!_this->stream_started)
   {
-    this->pdm_pending_bits = 0;
-
-    int64_t z1 = y5         - this->pdm_zin1_old;
-    int64_t z2 = this->pdm_z1_old - this->pdm_zin2_old;
-    int64_t z3 = this->pdm_z2_old - this->pdm_zin3_old;
-    int64_t z4 = this->pdm_z3_old - this->pdm_zin4_old;
-    int64_t z5 = this->pdm_z4_old - this->pdm_zin5_old;
+    if (!_this->has_cmd())
+    {
+      _this->top->event_enqueue(_this->stream_event, period * 32);
+      return;
+    }
+    _this->stream_started = true;
+  }
 
-    this->pdm_zin1_old = y5;
-    this->pdm_zin2_old = this->pdm_z1_old;
-    this->pdm_zin3_old = this->pdm_z2_old;
-    this->pdm_zin4_old = this->pdm_z3_old;
-    this->pdm_zin5_old = this->pdm_z4_old;
+  int width = _this->periph->r_i2s_slv_setup.slave_bits_get() + 1;
+  int64_t cycles;
 
-    this->pdm_z1_old = z1;
-    this->pdm_z2_old = z2;
-    this->pdm_z3_old = z3;
-    this->pdm_z4_old = z4;
-    this->pdm_z5_old = z5;
+  if (_this->stream->get_format() == UDMA_FILE_SOURCE_PDM)
+  {
+    uint32_t word;
+    if (_this->stream->read((uint8_t *)&word, 4) < 4)
+      return;
 
-    int64_t result = z5 >> pdm_shift;
+    int decimation = _this->periph->r_i2s_pdm_setup.pdm_decimation_get();
+    int shift = _this->periph->r_i2s_pdm_setup.pdm_shift_get();
 
+    uint32_t results[33];
+    int nb_results = _this->filters[0]->handle_word(word, 32, decimation + 1, (7 - shift)*5, results);
+    for (int i=0; i<nb_results; i++)
+    {
+      _this->push_sample(results[i], width);
+    }
 
-    //gv_trace_dumpMsg(&channel->trace, "Reached decimator, enqueueing value (value: %x)\n", result);
+    cycles = period * 32;
+  }
+  else
+  {
+    int sample_bytes = _this->stream->get_sample_bytes();
+    int nb_samples = sample_bytes >= 4 ? 1 : 4 / sample_bytes;
 
+    for (int i=0; i<nb_samples; i++)
+    {
+      uint32_t sample = 0;
+      if (_this->stream->read((uint8_t *)&sample, sample_bytes) < sample_bytes)
+        return;
 
-    *dout = result;
+      _this->push_sample(sample, width);
+    }
 
-    return true;
+    cycles = period * nb_samples;
   }
 
-  return false;
+  _this->top->event_enqueue(_this->stream_event, cycles);
 }
 
 
-
 void I2s_rx_channel::handle_rx_bit(int sck, int ws, int bit)
 {
   int pdm = this->periph->r_i2s_pdm_setup.pdm_en_get();
@@ -483,9 +472,16 @@ void I2s_rx_channel::handle_rx_bit(int sck, int ws, int bit)
 
   if (push)
   {
-    result = result & ((1<<width)-1);
-    int bytes = width <= 8 ? 1 : width <= 16 ? 2 : 4;
-
-    ((I2s_rx_channel *)this->periph->channel0)->push_data((uint8_t *)&result, bytes);
+    this->push_sample(result, width);
   }
 }
+
+
+
+void I2s_rx_channel::push_sample(uint32_t sample, int width)
+{
+  sample = sample & ((1<<width)-1);
+  int bytes = width <= 8 ? 1 : width <= 16 ? 2 : 4;
+
+  ((I2s_rx_channel *)this->periph->channel0)->push_data((uint8_t *)&sample, bytes);
+}
@@ -25,6 +25,8 @@
 #include <vp/vp.hpp>
 #include "../udma_impl.hpp"
 #include "../archi/udma_i2s_v2.h"
+#include "../udma_file_source.hpp"
+#include "i2s_cic_filter.hpp"
 
 
 /*
@@ -35,30 +37,6 @@
 
 class I2s_periph;
 
-class I2s_cic_filter {
-public:
-  I2s_cic_filter();
-
-  bool handle_bit(int din, int pdm_decimation, int pdm_shift, uint32_t *dout);
-  void reset();
-
-  int     pdm_pending_bits;
-  int64_t pdm_y1_old;
-  int64_t pdm_y2_old;
-  int64_t pdm_y3_old;
-  int64_t pdm_y4_old;
-  int64_t pdm_y5_old;
-  int64_t pdm_z1_old;
-  int64_t pdm_z2_old;
-  int64_t pdm_z3_old;
-  int64_t pdm_z4_old;
-  int64_t pdm_z5_old;
-  int64_t pdm_zin1_old;
-  int64_t pdm_zin2_old;
-  int64_t pdm_zin3_old;
-  int64_t pdm_zin4_old;
-  int64_t pdm_zin5_old;
-};
 
 class I2s_rx_channel : public Udma_rx_channel
 {
@@ -68,12 +46,19 @@ public:
 
 private:
   void reset(bool active);
+  void push_sample(uint32_t sample, int width);
+  static void stream_handler(vp::Block *__this, vp::ClockEvent *event);
   I2s_periph *periph;
 
   I2s_cic_filter *filters[2];
   int id;
   uint32_t pending_samples[2];
   int pending_bits[2];
+
+  // Optional file source replacing the pin-level microphone model
+  Udma_file_source *stream;
+  vp::ClockEvent *stream_event;
+  bool stream_started;
 };
 
 class I2s_periph : public Udma_periph
@@ -48,6 +48,8 @@ Spim_periph_v3::Spim_periph_v3(udma *top, int id, int itf_id) : Udma_periph(top,
 
 
   pending_spi_word_event = top->event_new((vp::Block *)this, Spim_periph_v3::handle_spi_pending_word);
+
+  this->word_mode = this->top->get_js_config()->get_child_bool("spim/word_mode");
 }
 
 void Spim_periph_v3::reset(bool active)
@@ -215,153 +217,200 @@ void Spim_v3_cmd_channel::check_state()
 void Spim_periph_v3::handle_spi_pending_word(vp::Block *__this, vp::ClockEvent *event)
 {
   Spim_periph_v3 *_this = (Spim_periph_v3 *)__this;
+
+  _this->handle_spi_step();
+
+  if (_this->word_mode)
+  {
+    // Chain the following bits of the word in the same event. The last step of the phase is
+    // kept for the next event, at the cycle it would have been reached in bit-level mode,
+    // since it is the one unblocking the command channel.
+    int64_t cycles = _this->top->clock.get_engine()->get_cycles();
+    int nb_steps = 1;
+    while (_this->get_spi_pending_steps() > 1)
+    {
+      _this->handle_spi_step();
+      nb_steps++;
+    }
+    _this->next_bit_cycle = cycles + nb_steps * (_this->clkdiv > 0 ? _this->clkdiv : 1);
+  }
+
+  _this->check_state();
+}
+
+
+/* Number of steps (1 bit or 4 in QPI) remaining before the current TX or RX phase is over */
+int Spim_periph_v3::get_spi_pending_steps()
+{
+  bool tx = this->spi_tx_pending_bits > 0;
+  bool rx = this->spi_rx_pending_bits > 0 && (!tx || this->is_full_duplex);
+  int steps = 0;
+
+  if (tx)
+  {
+    int nb_bits = this->spi_qpi ? 4 : 1;
+    steps = (this->spi_tx_pending_bits + nb_bits - 1) / nb_bits;
+  }
+
+  if (rx)
+  {
+    int nb_bits = this->qpi ? 4 : 1;
+    int rx_steps = (this->spi_rx_pending_bits + nb_bits - 1) / nb_bits;
+    if (!tx || rx_steps < steps)
+      steps = rx_steps;
+  }
+
+  return steps;
+}
+
+void Spim_periph_v3::handle_spi_step()
+{
   bool raised_edge = false;
 
-  if (_this->spi_rx_pending_bits > 0 && (_this->spi_tx_pending_bits == 0 || _this->is_full_duplex))
+  if (this->spi_rx_pending_bits > 0 && (this->spi_tx_pending_bits == 0 || this->is_full_duplex))
   {
-    int nb_bits = _this->qpi ? 4 : 1;
-    unsigned int received_bits =  _this->qpi ? _this->rx_received_bits & ((1<<nb_bits)-1) : (_this->rx_received_bits >> 1) & 1;
-    _this->next_bit_cycle = _this->top->clock.get_engine()->get_cycles() + _this->clkdiv;
+    int nb_bits = this->qpi ? 4 : 1;
+    unsigned int received_bits =  this->qpi ? this->rx_received_bits & ((1<<nb_bits)-1) : (this->rx_received_bits >> 1) & 1;
+    this->next_bit_cycle = this->top->clock.get_engine()->get_cycles() + this->clkdiv;
 
-    _this->nb_received_bits += nb_bits;
-    _this->spi_rx_pending_bits -= nb_bits;
-    if (!_this->is_full_duplex)
-      _this->cmd_pending_bits -= nb_bits;
+    this->nb_received_bits += nb_bits;
+    this->spi_rx_pending_bits -= nb_bits;
+    if (!this->is_full_duplex)
+      this->cmd_pending_bits -= nb_bits;
 
     int bit_index;
     int shift;
 
-    if (_this->spi_lsb_first)
-      bit_index = _this->rx_bit_offset + _this->rx_counter_bits;
+    if (this->spi_lsb_first)
+      bit_index = this->rx_bit_offset + this->rx_counter_bits;
     else
-      bit_index = _this->rx_bit_offset + _this->spi_bitsword - _this->rx_counter_bits;
+      bit_index = this->rx_bit_offset + this->spi_bitsword - this->rx_counter_bits;
 
 
-    if (_this->spi_qpi)
+    if (this->spi_qpi)
     {
-      shift = _this->spi_lsb_first ? bit_index : bit_index - 3;
+      shift = this->spi_lsb_first ? bit_index : bit_index - 3;
 
-      _this->rx_pending_word &= ~(0xf << shift);
-      _this->rx_pending_word |= (received_bits & 0xf) << shift;
+      this->rx_pending_word &= ~(0xf << shift);
+      this->rx_pending_word |= (received_bits & 0xf) << shift;
 
-      _this->rx_counter_bits += 4;
+      this->rx_counter_bits += 4;
     }
     else
     {
       shift = bit_index;
 
-      _this->rx_pending_word &= ~(0x1 << bit_index);
-      _this->rx_pending_word |= (received_bits & 0x1) << bit_index;
+      this->rx_pending_word &= ~(0x1 << bit_index);
+      this->rx_pending_word |= (received_bits & 0x1) << bit_index;
 
-      _this->rx_counter_bits += 1;
+      this->rx_counter_bits += 1;
     }
 
 
-    _this->top->get_trace()->msg("Sampled bits (nb_bits: %d, shift: %d, value: 0x%x, pending_word: 0x%x, pending_word_bits: %d)\n", nb_bits, shift, received_bits, _this->rx_pending_word, _this->nb_received_bits);
+    this->top->get_trace()->msg("Sampled bits (nb_bits: %d, shift: %d, value: 0x%x, pending_word: 0x%x, pending_word_bits: %d)\n", nb_bits, shift, received_bits, this->rx_pending_word, this->nb_received_bits);
 
-    if (!_this->qspim_itf.is_bound())
+    if (!this->qspim_itf.is_bound())
     {
-      _this->trace.force_warning("Trying to receive from SPIM interface while it is not connected\n");
+      this->trace.force_warning("Trying to receive from SPIM interface while it is not connected\n");
     }
     else
     {
-      if (!_this->is_full_duplex) {
-        _this->qspim_itf.sync(1, 0, 0, 0, 0, 0);
+      if (!this->is_full_duplex) {
+        this->qspim_itf.sync(1, 0, 0, 0, 0, 0);
       }
     }
 
 
-    if (_this->rx_counter_bits == _this->spi_bitsword + 1)
+    if (this->rx_counter_bits == this->spi_bitsword + 1)
     {
-      _this->rx_counter_bits = 0;
-      _this->rx_bit_offset += _this->spi_wordtrans == 0 ? 0 : _this->spi_wordtrans == 1 ? 16 : 8;
-      _this->rx_counter_transf++;
-      if (_this->rx_counter_transf == 1<<_this->spi_wordtrans)
+      this->rx_counter_bits = 0;
+      this->rx_bit_offset += this->spi_wordtrans == 0 ? 0 : this->spi_wordtrans == 1 ? 16 : 8;
+      this->rx_counter_transf++;
+      if (this->rx_counter_transf == 1<<this->spi_wordtrans)
       {
-        _this->top->get_trace()->msg("End of word transfer, pushing word (value: 0x%x)\n", _this->rx_pending_word);
+        this->top->get_trace()->msg("End of word transfer, pushing word (value: 0x%x)\n", this->rx_pending_word);
 
-        (static_cast<Spim_v3_rx_channel *>(_this->channel0))->push_data((uint8_t *)&_this->rx_pending_word, 4);
+        (static_cast<Spim_v3_rx_channel *>(this->channel0))->push_data((uint8_t *)&this->rx_pending_word, 4);
         
-        _this->rx_counter_transf = 0;
-        _this->rx_bit_offset = 0;
-        _this->nb_received_bits = 0;
-        _this->rx_pending_word = 0x57575757;
+        this->rx_counter_transf = 0;
+        this->rx_bit_offset = 0;
+        this->nb_received_bits = 0;
+        this->rx_pending_word = 0x57575757;
       }
     }
 
-    if (_this->spi_rx_pending_bits <= 0)
+    if (this->spi_rx_pending_bits <= 0)
     {
-      _this->is_full_duplex = false;
-      _this->waiting_rx = false;
-      _this->channel1->handle_ready_reqs();
-      _this->channel2->handle_ready_reqs();
+      this->is_full_duplex = false;
+      this->waiting_rx = false;
+      this->channel1->handle_ready_reqs();
+      this->channel2->handle_ready_reqs();
     }
   }
 
-  if (_this->spi_tx_pending_bits > 0)
+  if (this->spi_tx_pending_bits > 0)
   {
-    _this->next_bit_cycle = _this->top->clock.get_engine()->get_cycles() + _this->clkdiv;
+    this->next_bit_cycle = this->top->clock.get_engine()->get_cycles() + this->clkdiv;
 
 
     int bit_index;
     int shift;
-    int nb_bits = _this->spi_qpi ? 4 : 1;
+    int nb_bits = this->spi_qpi ? 4 : 1;
 
-    if (_this->spi_lsb_first)
-      bit_index = _this->tx_bit_offset + _this->tx_counter_bits;
+    if (this->spi_lsb_first)
+      bit_index = this->tx_bit_offset + this->tx_counter_bits;
     else
-      bit_index = _this->tx_bit_offset + _this->spi_bitsword - _this->tx_counter_bits;
+      bit_index = this->tx_bit_offset + this->spi_bitsword - this->tx_counter_bits;
 
-    if (_this->spi_qpi)
+    if (this->spi_qpi)
     {
-      shift = _this->spi_lsb_first ? bit_index : bit_index - 3;
-      _this->tx_counter_bits += 4;
+      shift = this->spi_lsb_first ? bit_index : bit_index - 3;
+      this->tx_counter_bits += 4;
     }
     else
     {
       shift = bit_index;
-      _this->tx_counter_bits += 1;
+      this->tx_counter_bits += 1;
     }
 
-    unsigned int bits = ARCHI_REG_FIELD_GET(_this->spi_tx_pending_word, shift, nb_bits);
-    _this->top->get_trace()->msg("Sending bits (nb_bits: %d, shift: %d, value: 0x%x)\n", nb_bits, shift, bits);
+    unsigned int bits = ARCHI_REG_FIELD_GET(this->spi_tx_pending_word, shift, nb_bits);
+    this->top->get_trace()->msg("Sending bits (nb_bits: %d, shift: %d, value: 0x%x)\n", nb_bits, shift, bits);
 
     raised_edge = true;
 
-    if (!_this->qspim_itf.is_bound())
+    if (!this->qspim_itf.is_bound())
     {
-      _this->trace.force_warning("Trying to send to SPIM interface while it is not connected\n");
+      this->trace.force_warning("Trying to send to SPIM interface while it is not connected\n");
     }
     else
     {
-      _this->qspim_itf.sync(
+      this->qspim_itf.sync(
         1, (bits >> 0) & 1, (bits >> 1) & 1, (bits >> 2) & 1, (bits >> 3) & 1, (1<<nb_bits)-1
       );
     }
 
-    if (_this->tx_counter_bits == _this->spi_bitsword + 1)
+    if (this->tx_counter_bits == this->spi_bitsword + 1)
     {
-      _this->tx_counter_bits = 0;
-      _this->tx_bit_offset += _this->spi_wordtrans == 0 ? 0 : _this->spi_wordtrans == 1 ? 16 : 8;
-      _this->tx_counter_transf++;
+      this->tx_counter_bits = 0;
+      this->tx_bit_offset += this->spi_wordtrans == 0 ? 0 : this->spi_wordtrans == 1 ? 16 : 8;
+      this->tx_counter_transf++;
 
-      if (_this->tx_counter_transf == 1<<_this->spi_wordtrans)
+      if (this->tx_counter_transf == 1<<this->spi_wordtrans)
       {
-        _this->tx_counter_transf = 0;
-        _this->tx_bit_offset = 0;
+        this->tx_counter_transf = 0;
+        this->tx_bit_offset = 0;
       }
     }
 
 
-    _this->spi_tx_pending_bits -= nb_bits;
+    this->spi_tx_pending_bits -= nb_bits;
 
-    if (_this->waiting_tx_flush && _this->spi_tx_pending_bits <= 0)
+    if (this->waiting_tx_flush && this->spi_tx_pending_bits <= 0)
     {
-      _this->waiting_tx_flush = false;
+      this->waiting_tx_flush = false;
     }
   }
 
-  _this->check_state();
 }
 
 void Spim_v3_cmd_channel::handle_pending_word(vp::Block *__this, vp::ClockEvent *event)
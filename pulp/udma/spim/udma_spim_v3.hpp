@@ -129,6 +129,8 @@ public:
   void reset(bool active);
   vp::IoReqStatus custom_req(vp::IoReq *req, uint64_t offset);
   static void handle_spi_pending_word(vp::Block *__this, vp::ClockEvent *event);
+  void handle_spi_step();
+  int get_spi_pending_steps();
   void check_state();
   bool push_tx_to_spi(uint32_t value, int nb_bits, int qpi, int lsb_first, int bitsword, int wordtrans);
   bool push_rx_to_spi(int nb_bits, int qpi, int lsb_first, int bitsword, int wordtrans);
@@ -169,6 +171,10 @@ protected:
 
   int64_t next_bit_cycle;
 
+  // Word-level mode, the bits of a word are exchanged with the slave within a single event, for
+  // slaves answering synchronously on the clock edges
+  bool word_mode;
+
 
   uint32_t rx_received_bits;
   int      rx_bit_offset;
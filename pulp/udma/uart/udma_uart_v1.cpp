@@ -24,6 +24,16 @@
 #include "../archi/udma_uart_v1.h"
 #include "../archi/utils.h"
 #include "vp/itf/uart.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <termios.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
 
 
 Uart_periph_v1::Uart_periph_v1(udma *top, int id, int itf_id) : Udma_periph(top, id)
@@ -38,6 +48,31 @@ Uart_periph_v1::Uart_periph_v1(udma *top, int id, int itf_id) : Udma_periph(top,
   top->new_master_port(itf_name, &uart_itf, (vp::Block *)this);
 
   uart_itf.set_sync_meth(&Uart_periph_v1::rx_sync);
+
+  this->host = NULL;
+  js::Config *host_config = top->get_js_config()->get("uart/backends/" + itf_name);
+  if (host_config)
+  {
+    this->host = new Uart_host_backend(&this->trace, host_config, top->get_path() + "/" + itf_name);
+  }
+}
+
+
+
+void Uart_periph_v1::stop()
+{
+  if (this->host)
+  {
+    this->host->flush();
+  }
+}
+
+
+
+int64_t Uart_periph_v1::get_frame_cycles()
+{
+  int nb_bits = 1 + this->bit_length + (this->parity ? 1 : 0) + this->stop_bits;
+  return nb_bits * (this->clkdiv + 2);
 }
  
 
@@ -154,6 +189,13 @@ void Uart_tx_channel::handle_pending_word(vp::Block *__this, vp::ClockEvent *eve
 {
   Uart_tx_channel *_this = (Uart_tx_channel *)__this;
 
+  if (_this->periph->host)
+  {
+    _this->send_byte();
+    _this->check_state();
+    return;
+  }
+
   int bit = -1;
   bool end = false;
 
@@ -232,6 +274,33 @@ void Uart_tx_channel::handle_pending_word(vp::Block *__this, vp::ClockEvent *eve
 
 
 
+/* Byte mode, the whole frame is accounted at once and the byte is given to the host at the end
+   of the frame */
+void Uart_tx_channel::send_byte()
+{
+  uint8_t byte = this->pending_word & ((1 << this->periph->bit_length) - 1);
+  this->pending_word >>= 8;
+  this->pending_bits -= 8;
+
+  if (this->periph->tx)
+  {
+    this->top->get_trace()->msg("Sending byte (value: 0x%x)\n", byte);
+    this->periph->host->write(byte);
+  }
+
+  // Cycle at which the next byte, if any, will be fully sent
+  this->next_bit_cycle = this->periph->top->get_periph_clock()->clock.get_cycles() + this->periph->get_frame_cycles();
+
+  if (this->pending_bits <= 0)
+  {
+    this->pending_bits = 0;
+    this->handle_ready_req_end(this->pending_req);
+    this->handle_ready_reqs();
+  }
+}
+
+
+
 void Uart_tx_channel::check_state()
 {
   if ((this->pending_bits != 0 || this->stop_bits) && !pending_word_event->is_enqueued())
@@ -240,6 +309,8 @@ void Uart_tx_channel::check_state()
     int64_t cycles = this->top->get_periph_clock()->clock.get_cycles();
     if (next_bit_cycle > cycles)
       latency = next_bit_cycle - cycles;
+    else if (this->periph->host)
+      latency = this->periph->get_frame_cycles();
 
     top->get_periph_clock()->enqueue(pending_word_event, latency);
   }
@@ -285,6 +356,7 @@ bool Uart_tx_channel::is_busy()
 
 Uart_rx_channel::Uart_rx_channel(udma *top, Uart_periph_v1 *periph, int id, string name) : Udma_rx_channel(top, id, name), periph(periph)
 {
+  this->host_event = top->event_new((vp::Block *)this, Uart_rx_channel::handle_host_byte);
 }
 
 void Uart_rx_channel::reset(bool active)
@@ -295,6 +367,42 @@ void Uart_rx_channel::reset(bool active)
   {
     this->state = UART_RX_STATE_WAIT_START;
     this->nb_received_bits = 0;
+
+    if (this->host_event->is_enqueued())
+      this->top->get_periph_clock()->cancel(this->host_event);
+  }
+}
+
+void Uart_rx_channel::handle_ready()
+{
+  // In byte mode, the host is only polled while a transfer is waiting for data, once per frame
+  if (this->periph->host && !this->host_event->is_enqueued())
+  {
+    this->top->get_periph_clock()->enqueue(this->host_event, this->periph->get_frame_cycles());
+  }
+}
+
+void Uart_rx_channel::handle_host_byte(vp::Block *__this, vp::ClockEvent *event)
+{
+  Uart_rx_channel *_this = (Uart_rx_channel *)__this;
+
+  if (!_this->has_cmd())
+    return;
+
+  if (_this->periph->rx)
+  {
+    int byte = _this->periph->host->read();
+    if (byte != -1)
+    {
+      uint8_t value = byte & ((1 << _this->periph->bit_length) - 1);
+      _this->trace.msg("Received byte from host (value: 0x%x)\n", value);
+      _this->push_data(&value, 1);
+    }
+  }
+
+  if (_this->has_cmd() && !_this->host_event->is_enqueued())
+  {
+    _this->top->get_periph_clock()->enqueue(_this->host_event, _this->periph->get_frame_cycles());
   }
 }
 
@@ -352,3 +460,181 @@ bool Uart_rx_channel::is_busy()
 {
   return false;
 }
+
+
+
+Uart_host_backend::Uart_host_backend(vp::Trace *trace, js::Config *config, std::string name)
+: trace(trace), in_fd(-1), out_fd(-1), listen_fd(-1)
+{
+  std::string type = config->get_child_str("type");
+  this->line_buffer = config->get_child_bool("line_buffer");
+
+  if (type == "stdout")
+  {
+    this->type = UART_HOST_STDOUT;
+    this->in_fd = 0;
+    this->out_fd = 1;
+  }
+  else if (type == "file")
+  {
+    this->type = UART_HOST_FILE;
+    std::string path = config->get_child_str("path");
+    this->out_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (this->out_fd == -1)
+    {
+      this->trace->fatal("Unable to open UART output file (path: %s, error: %s)\n", path.c_str(), strerror(errno));
+      return;
+    }
+  }
+  else if (type == "pty")
+  {
+    this->type = UART_HOST_PTY;
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd == -1 || grantpt(fd) != 0 || unlockpt(fd) != 0)
+    {
+      this->trace->fatal("Unable to open UART pty (error: %s)\n", strerror(errno));
+      return;
+    }
+
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0)
+    {
+      cfmakeraw(&tio);
+      tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    this->in_fd = fd;
+    this->out_fd = fd;
+    printf("[%s] UART connected to %s\n", name.c_str(), ptsname(fd));
+  }
+  else if (type == "tcp")
+  {
+    this->type = UART_HOST_TCP;
+    int port = config->get_child_int("port");
+
+    this->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(this->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+
+    if (this->listen_fd == -1 || bind(this->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+      listen(this->listen_fd, 1) != 0)
+    {
+      this->trace->fatal("Unable to listen on UART port (port: %d, error: %s)\n", port, strerror(errno));
+      return;
+    }
+
+    fcntl(this->listen_fd, F_SETFL, fcntl(this->listen_fd, F_GETFL) | O_NONBLOCK);
+    printf("[%s] UART listening on port %d\n", name.c_str(), port);
+  }
+  else
+  {
+    throw logic_error("Unknown UART backend: " + type);
+  }
+}
+
+
+
+/* Only the tcp backend can be disconnected, a client is accepted as soon as one connects.
+   Output sent while no client is connected is dropped */
+bool Uart_host_backend::check_connection()
+{
+  if (this->type == UART_HOST_TCP && this->out_fd == -1)
+  {
+    int fd = accept(this->listen_fd, NULL, NULL);
+    if (fd != -1)
+    {
+      this->trace->msg("UART client connected\n");
+      this->in_fd = fd;
+      this->out_fd = fd;
+    }
+  }
+
+  return this->out_fd != -1;
+}
+
+
+
+void Uart_host_backend::write(uint8_t byte)
+{
+  this->buffer.push_back(byte);
+
+  if (!this->line_buffer || byte == '\n')
+  {
+    this->flush();
+  }
+}
+
+
+
+void Uart_host_backend::flush()
+{
+  if (this->buffer.size() == 0 || !this->check_connection())
+  {
+    this->buffer.clear();
+    return;
+  }
+
+  const char *data = this->buffer.c_str();
+  int size = this->buffer.size();
+
+  while (size > 0)
+  {
+    int ret;
+    if (this->type == UART_HOST_TCP)
+      ret = send(this->out_fd, data, size, MSG_NOSIGNAL);
+    else
+      ret = ::write(this->out_fd, data, size);
+
+    if (ret <= 0)
+    {
+      if (this->type == UART_HOST_TCP)
+      {
+        this->trace->msg("UART client disconnected\n");
+        close(this->out_fd);
+        this->in_fd = -1;
+        this->out_fd = -1;
+      }
+      break;
+    }
+
+    data += ret;
+    size -= ret;
+  }
+
+  this->buffer.clear();
+}
+
+
+
+int Uart_host_backend::read()
+{
+  if (!this->check_connection() && this->type == UART_HOST_TCP)
+    return -1;
+
+  if (this->in_fd == -1)
+    return -1;
+
+  struct pollfd fds = { .fd=this->in_fd, .events=POLLIN, .revents=0 };
+  if (poll(&fds, 1, 0) <= 0)
+    return -1;
+
+  uint8_t byte;
+  if (::read(this->in_fd, &byte, 1) == 1)
+    return byte;
+
+  if (this->type == UART_HOST_TCP)
+  {
+    this->trace->msg("UART client disconnected\n");
+    close(this->in_fd);
+    this->in_fd = -1;
+    this->out_fd = -1;
+  }
+
+  return -1;
+}
@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vp/vp.hpp>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "udma_file_source.hpp"
+
+
+Udma_file_source::Udma_file_source(vp::Trace *trace, js::Config *config) : trace(trace)
+{
+  this->path = config->get_child_str("path");
+  this->loop = config->get_child_bool("loop");
+  this->period = config->get("period") ? config->get_child_int("period") : 1;
+  this->sample_bytes = config->get("sample_bytes") ? config->get_child_int("sample_bytes") : 2;
+  this->over = false;
+  this->map = NULL;
+
+  std::string format = config->get("format") ? config->get_child_str("format") : "raw";
+  if (format == "raw")
+    this->format = UDMA_FILE_SOURCE_RAW;
+  else if (format == "wav")
+    this->format = UDMA_FILE_SOURCE_WAV;
+  else if (format == "pdm")
+    this->format = UDMA_FILE_SOURCE_PDM;
+  else
+    throw logic_error("Unknown stream format: " + format);
+
+  if (this->period < 1)
+  {
+    throw logic_error("Invalid stream period: " + std::to_string(this->period));
+  }
+
+  this->fd = open(this->path.c_str(), O_RDONLY);
+  if (this->fd == -1)
+  {
+    this->trace->fatal("Unable to open stream (path: %s, error: %s)\n", this->path.c_str(), strerror(errno));
+    return;
+  }
+
+  struct stat file_stat;
+  if (fstat(this->fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode) && file_stat.st_size > 0)
+  {
+    void *map = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, this->fd, 0);
+    if (map != MAP_FAILED)
+    {
+      this->map = (uint8_t *)map;
+      this->map_size = file_stat.st_size;
+      this->current = this->map;
+      this->data_start = this->map;
+      this->data_end = this->map + this->map_size;
+    }
+  }
+
+  if (this->map == NULL && this->loop)
+  {
+    this->trace->force_warning("Stream can not be replayed as it is not a regular file (path: %s)\n", this->path.c_str());
+    this->loop = false;
+  }
+
+  if (this->format == UDMA_FILE_SOURCE_WAV)
+  {
+    this->parse_wav_header();
+  }
+
+  // Samples are read into 32-bit words
+  if (this->sample_bytes < 1 || this->sample_bytes > 4)
+  {
+    this->trace->fatal("Invalid stream sample size (path: %s, sample_bytes: %d)\n", this->path.c_str(), this->sample_bytes);
+    return;
+  }
+
+  this->trace->msg("Opened stream (path: %s, format: %s, period: %ld, loop: %d, mapped: %d)\n",
+    this->path.c_str(), format.c_str(), this->period, this->loop, this->map != NULL);
+}
+
+
+Udma_file_source::~Udma_file_source()
+{
+  if (this->map)
+    munmap(this->map, this->map_size);
+  if (this->fd != -1)
+    close(this->fd);
+}
+
+
+int Udma_file_source::read_raw(uint8_t *data, int size)
+{
+  if (this->map)
+  {
+    int64_t remaining = this->data_end - this->current;
+    if (size > remaining)
+      size = remaining;
+    memcpy(data, this->current, size);
+    this->current += size;
+    return size;
+  }
+  else
+  {
+    int done = 0;
+    while (done < size)
+    {
+      int ret = ::read(this->fd, data + done, size - done);
+      if (ret <= 0)
+        break;
+      done += ret;
+    }
+    return done;
+  }
+}
+
+
+/* Skips the WAV header so that the stream starts on the first sample of the data chunk, the
+   sample size is taken from the format chunk */
+void Udma_file_source::parse_wav_header()
+{
+  uint8_t header[12];
+  if (this->read_raw(header, 12) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(&header[8], "WAVE", 4) != 0)
+  {
+    this->trace->fatal("Invalid WAV stream (path: %s)\n", this->path.c_str());
+    return;
+  }
+
+  while (1)
+  {
+    uint8_t chunk[8];
+    if (this->read_raw(chunk, 8) != 8)
+    {
+      this->trace->fatal("No data chunk found in WAV stream (path: %s)\n", this->path.c_str());
+      return;
+    }
+
+    uint32_t chunk_size = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | (chunk[7] << 24);
+
+    if (memcmp(chunk, "data", 4) == 0)
+    {
+      if (this->map)
+      {
+        this->data_start = this->current;
+        if (chunk_size < (uint64_t)(this->data_end - this->current))
+          this->data_end = this->current + chunk_size;
+      }
+      return;
+    }
+
+    uint8_t buffer[64];
+    uint32_t read_size = 0;
+    while (read_size < chunk_size)
+    {
+      int size = chunk_size - read_size > sizeof(buffer) ? sizeof(buffer) : chunk_size - read_size;
+      int ret = this->read_raw(buffer, size);
+      if (ret <= 0)
+        break;
+
+      // Bits per sample are at offset 14 of the format chunk
+      if (memcmp(chunk, "fmt ", 4) == 0 && read_size == 0 && ret >= 16)
+        this->sample_bytes = (buffer[14] | (buffer[15] << 8)) / 8;
+
+      read_size += ret;
+    }
+  }
+}
+
+
+/* Copies up to size bytes from the stream and returns the number of bytes copied, which is less
+   than size only once the end of a non-looping stream is reached */
+int Udma_file_source::read(uint8_t *data, int size)
+{
+  int done = 0;
+
+  while (done < size && !this->over)
+  {
+    int ret = this->read_raw(data + done, size - done);
+    done += ret;
+
+    if (done < size)
+    {
+      if (this->loop && this->data_end > this->data_start)
+      {
+        this->trace->msg("Reached end of stream, restarting (path: %s)\n", this->path.c_str());
+        this->current = this->data_start;
+      }
+      else
+      {
+        this->trace->msg("Reached end of stream (path: %s)\n", this->path.c_str());
+        this->over = true;
+      }
+    }
+  }
+
+  return done;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PULP_UDMA_UDMA_FILE_SOURCE_HPP__
+#define __PULP_UDMA_UDMA_FILE_SOURCE_HPP__
+
+#include <vp/vp.hpp>
+#include <stdint.h>
+#include <string>
+
+
+typedef enum
+{
+  UDMA_FILE_SOURCE_RAW,
+  UDMA_FILE_SOURCE_WAV,
+  UDMA_FILE_SOURCE_PDM
+} udma_file_source_format_e;
+
+
+/*
+ * Data source reading a file or a pipe, used to feed an interface with real data (frames, audio
+ * samples) instead of a pin-level model.
+ * Regular files are memory-mapped and can be replayed in a loop, pipes are read sequentially.
+ *
+ * Config:
+ *   path:   file or pipe to read from
+ *   format: "raw", "wav" (header is skipped) or "pdm" (packed PDM bits, LSB first)
+ *   period: number of cycles per transferred unit (pixel clock, PDM bit or sample), default 1
+ *   loop:   restart from the beginning of the data when the end is reached
+ */
+class Udma_file_source
+{
+public:
+  Udma_file_source(vp::Trace *trace, js::Config *config);
+  ~Udma_file_source();
+
+  int read(uint8_t *data, int size);
+  bool is_over() { return this->over; }
+
+  udma_file_source_format_e get_format() { return this->format; }
+  int64_t get_period() { return this->period; }
+  // Size in bytes of one sample in the file, only relevant for audio streams
+  int get_sample_bytes() { return this->sample_bytes; }
+
+private:
+  int read_raw(uint8_t *data, int size);
+  void parse_wav_header();
+
+  vp::Trace *trace;
+  std::string path;
+  udma_file_source_format_e format;
+  int64_t period;
+  bool loop;
+  int sample_bytes;
+  bool over;
+
+  int fd;
+  // Set when the file is memory-mapped
+  uint8_t *map;
+  size_t map_size;
+  uint8_t *data_start;
+  uint8_t *data_end;
+  uint8_t *current;
+};
+
+#endif
@@ -23,6 +23,7 @@
 #include <vp/itf/io.hpp>
 #include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
 #include <vector>
 #include "archi/utils.h"
 #include "archi/udma_v3.h"
@@ -43,6 +44,72 @@
 
 
 
+Udma_rx_channel::Udma_rx_channel(udma *top, int id, string name) : Udma_channel(top, id, name)
+{
+  this->l2_write_pending_req = NULL;
+  this->l2_write_free_reqs = new Udma_queue<vp::IoReq>(-1);
+  for (int i=0; i<top->l2_write_fifo_size; i++)
+  {
+    vp::IoReq *req = new vp::IoReq();
+    req->set_data(new uint8_t[top->l2_port_width]);
+    req->set_is_write(true);
+    req->arg_alloc(); // Used to store channel;
+    req->arg_alloc(); // Used to store enqueue cycle
+    this->l2_write_free_reqs->push(req);
+  }
+
+  this->l2_write_flush_event = top->event_new((vp::Block *)this, Udma_rx_channel::handle_l2_write_flush);
+}
+
+
+
+vp::IoReq *Udma_rx_channel::alloc_l2_write_req()
+{
+  vp::IoReq *req = this->l2_write_free_reqs->pop();
+  if (req == NULL)
+  {
+    // The pool is only exhausted if the peripheral is faster than the L2,
+    // just grow it, the new request will be recycled like the others
+    req = new vp::IoReq();
+    req->set_data(new uint8_t[this->top->l2_port_width]);
+    req->set_is_write(true);
+    req->arg_alloc(); // Used to store channel;
+    req->arg_alloc(); // Used to store enqueue cycle
+    this->top->nb_l2_write_allocs++;
+  }
+  return req;
+}
+
+
+
+void Udma_rx_channel::free_l2_write_req(vp::IoReq *req)
+{
+  this->l2_write_free_reqs->push(req);
+}
+
+
+
+void Udma_rx_channel::handle_l2_write_flush(vp::Block *__this, vp::ClockEvent *event)
+{
+  Udma_rx_channel *_this = (Udma_rx_channel *)__this;
+  _this->flush_l2_write_req();
+}
+
+
+
+void Udma_rx_channel::flush_l2_write_req()
+{
+  vp::IoReq *req = this->l2_write_pending_req;
+  if (req)
+  {
+    this->l2_write_pending_req = NULL;
+    trace.msg("Writing to memory (addr: 0x%x, size: 0x%x)\n", req->get_addr(), req->get_size());
+    this->top->push_l2_write_req(req);
+  }
+}
+
+
+
 void Udma_rx_channel::push_data(uint8_t *data, int size)
 {
   if (current_cmd == NULL)
@@ -64,11 +131,38 @@ void Udma_rx_channel::push_data(uint8_t *data, int size)
   if (this->pending_byte_index >= 4 || this->pending_byte_index >= current_cmd->remaining_size)
   {
     this->pending_byte_index = 0;
-    vp::IoReq *req = this->top->l2_itf.req_new(0, new uint8_t[4], 4, true);
-    *(uint32_t *)req->get_data() = this->pending_word;
-    bool end = current_cmd->prepare_req(req);
-    trace.msg("Writing 4 bytes to memory (value: 0x%x, addr: 0x%x)\n", this->pending_word, req->get_addr());
-    this->top->push_l2_write_req(req);
+
+    // Contiguous words pushed during the same cycle are accumulated into the same request so
+    // that the L2 sees bursts as wide as its port. Requests only grow from an aligned address
+    // and never beyond the width of their buffer.
+    bool end;
+    vp::IoReq *req = this->l2_write_pending_req;
+    if (req == NULL)
+    {
+      req = this->alloc_l2_write_req();
+      this->l2_write_pending_req = req;
+      end = current_cmd->prepare_req(req);
+    }
+    else
+    {
+      end = current_cmd->append_req(req);
+    }
+    *(uint32_t *)&req->get_data()[req->get_size() - 4] = this->pending_word;
+    trace.msg("Pushing word to L2 write request (value: 0x%x, addr: 0x%x)\n", this->pending_word,
+      req->get_addr() + req->get_size() - 4);
+
+    if (end || (int)req->get_size() == this->top->l2_port_width ||
+      (req->get_addr() & (this->top->l2_port_width - 1)) != 0)
+    {
+      this->flush_l2_write_req();
+    }
+    else if (!this->l2_write_flush_event->is_enqueued())
+    {
+      // Don't keep partial requests after the current cycle, the peripheral may not send
+      // anything else before a long time
+      this->top->event_enqueue(this->l2_write_flush_event, 1);
+    }
+
     if (end)
     {
       handle_transfer_end();
@@ -83,6 +177,11 @@ void Udma_rx_channel::reset(bool active)
   if (active)
   {
     pending_byte_index = 0;
+    if (this->l2_write_pending_req)
+    {
+      this->free_l2_write_req(this->l2_write_pending_req);
+      this->l2_write_pending_req = NULL;
+    }
   }
 }
 
@@ -305,6 +404,67 @@ Udma_channel::Udma_channel(udma *top, int id, string name) : top(top), id(id), n
   event = top->event_new((vp::Block *)this, udma::channel_handler);
 
   top->traces.new_trace_event(name + "/state", &this->state_event, 8);
+
+  this->arb_priority = 0;
+  this->arb_weight = 1;
+  js::Config *config = top->get_js_config()->get("properties/channels/" + name);
+  if (config)
+  {
+    this->arb_priority = config->get_child_int("priority");
+    if (config->get("weight"))
+      this->arb_weight = config->get_child_int("weight");
+    top->arbitration = true;
+  }
+
+  if (this->arb_weight < 1)
+  {
+    top->trace.fatal("Invalid channel weight, must be at least 1 (channel: %s, weight: %d)\n",
+      name.c_str(), this->arb_weight);
+  }
+
+  this->arb_credits = this->arb_weight;
+
+  this->nb_l2_reqs = 0;
+  this->nb_l2_bytes = 0;
+  this->l2_first_cycle = -1;
+  this->l2_last_cycle = -1;
+  this->l2_delay_total = 0;
+  this->l2_delay_max = 0;
+
+  top->channels.push_back(this);
+}
+
+
+
+void Udma_channel::account_l2_req(int size, int64_t delay)
+{
+  int64_t cycles = this->top->clock.get_cycles();
+
+  if (this->l2_first_cycle == -1)
+    this->l2_first_cycle = cycles;
+  this->l2_last_cycle = cycles;
+
+  this->nb_l2_reqs++;
+  this->nb_l2_bytes += size;
+  this->l2_delay_total += delay;
+  if (delay > this->l2_delay_max)
+    this->l2_delay_max = delay;
+}
+
+
+
+void Udma_channel::dump_stats()
+{
+  if (this->nb_l2_reqs == 0)
+    return;
+
+  int64_t duration = this->l2_last_cycle - this->l2_first_cycle + 1;
+
+  this->top->stats_trace.msg(vp::Trace::LEVEL_INFO, "Channel %s: L2 requests: %" PRId64 ", bytes: %" PRId64
+    ", bandwidth: %.2f bytes/cycle, queueing delay: avg %.2f max %" PRId64 " cycles\n",
+    this->name.c_str(), this->nb_l2_reqs, this->nb_l2_bytes,
+    (double)this->nb_l2_bytes / duration, (double)this->l2_delay_total / this->nb_l2_reqs,
+    this->l2_delay_max);
 }
 
 
@@ -320,6 +480,7 @@ void Udma_channel::reset(bool active)
 {
   if (active)
   {
+    this->arb_credits = this->arb_weight;
     current_cmd = NULL;
     continuous_mode = 0;
     transfer_size = 0;
@@ -444,6 +605,19 @@ bool Udma_transfer::prepare_req(vp::IoReq *req)
   return remaining_size <= 0;
 }
 
+/* Extends a write request prepared with prepare_req with the next word of the transfer, so that
+   contiguous words are sent to L2 as a single burst */
+bool Udma_transfer::append_req(vp::IoReq *req)
+{
+  req->set_size(req->get_size() + 4);
+  req->set_actual_size(req->get_actual_size() + (remaining_size > 4 ? 4 : remaining_size));
+
+  current_addr += 4;
+  remaining_size -= 4;
+
+  return remaining_size <= 0;
+}
+
 void udma::trigger_event(int event)
 {
   trace.msg("Triggering event (event: %d)\n", event);
@@ -455,6 +629,7 @@ udma::udma(vp::ComponentConf &config)
 : vp::Component(config)
 {
   traces.new_trace("trace", &trace, vp::DEBUG);
+  traces.new_trace("stats", &stats_trace, vp::DEBUG);
 
   in.set_req_meth(&udma::req);
   new_slave_port("input", &in);
@@ -466,6 +641,25 @@ udma::udma(vp::ComponentConf &config)
   periphs.reserve(nb_periphs);
 
   l2_read_fifo_size = get_js_config()->get_child_int("properties/l2_read_fifo_size");
+  l2_write_fifo_size = get_js_config()->get_child_int("properties/l2_write_fifo_size");
+  l2_port_width = get_js_config()->get_child_int("properties/l2_port_width");
+  arbitration = false;
+
+  if (l2_port_width <= 0)
+    l2_port_width = 4;
+
+  // The port width also gives the size up to which RX words are coalesced into a single write
+  if (l2_port_width < 4 || (l2_port_width & (l2_port_width - 1)) != 0)
+  {
+    this->trace.fatal("Invalid L2 port width, must be a power of 2 greater or equal to 4 (width: %d)\n",
+      l2_port_width);
+  }
+
+  nb_l2_writes = 0;
+  nb_l2_write_bytes = 0;
+  nb_l2_write_allocs = 0;
+  l2_read_ready_cycle = 0;
+  l2_write_ready_cycle = 0;
 
   l2_itf.set_resp_meth(&udma::l2_response);
   l2_itf.set_grant_meth(&udma::l2_grant);
@@ -664,6 +858,7 @@ udma::udma(vp::ComponentConf &config)
 
 void udma::push_l2_write_req(vp::IoReq *req)
 {
+  *(int64_t *)req->arg_get(1) = this->clock.get_cycles();
   this->l2_write_reqs->push(req);
   this->check_state();
 }
@@ -680,24 +875,87 @@ void udma::channel_handler(vp::Block *__this, vp::ClockEvent *event)
 void udma::enqueue_ready(Udma_channel *channel)
 {
   if (channel->is_tx())
+  {
+    channel->ready_cycle = clock.get_cycles();
     ready_tx_channels->push(channel);
+  }
   else
     channel->handle_ready();
 
   check_state();
 }
 
+static Udma_channel *get_channel(Udma_channel *channel)
+{
+  return channel;
+}
+
+
+static Udma_channel *get_req_channel(vp::IoReq *req)
+{
+  return *(Udma_channel **)req->arg_get(0);
+}
+
+
+bool udma::arbiter_is_before(Udma_channel *a, Udma_channel *b)
+{
+  if (a->arb_priority != b->arb_priority)
+    return a->arb_priority > b->arb_priority;
+
+  return a->arb_credits > 0 && b->arb_credits == 0;
+}
+
+
+/* Removes and returns the element of the queue whose channel wins the arbitration. Ties are
+   resolved by order in the queue, which gives the round-robin among equal channels. */
+template<class T>
+T *udma::arbitrate(Udma_queue<T> *queue, Udma_channel *(*get_channel)(T *))
+{
+  T *winner = NULL;
+  for (T *elem = queue->get_first(); elem != NULL; elem = elem->get_next())
+  {
+    if (winner == NULL || this->arbiter_is_before(get_channel(elem), get_channel(winner)))
+      winner = elem;
+  }
+
+  Udma_channel *channel = get_channel(winner);
+  if (channel->arb_credits == 0)
+  {
+    // All the competing channels of this priority have used their share, start a new round
+    for (T *elem = queue->get_first(); elem != NULL; elem = elem->get_next())
+    {
+      Udma_channel *candidate = get_channel(elem);
+      if (candidate->arb_priority == channel->arb_priority)
+        candidate->arb_credits = candidate->arb_weight;
+    }
+  }
+  channel->arb_credits--;
+
+  queue->remove(winner);
+
+  return winner;
+}
+
+
 void udma::event_handler(vp::Block *__this, vp::ClockEvent *event)
 {
   udma *_this = (udma *)__this;
+  int64_t cycles = _this->clock.get_cycles();
 
-  if (!_this->l2_write_reqs->is_empty())
+  if (!_this->l2_write_reqs->is_empty() && _this->l2_write_ready_cycle <= cycles)
   {
-    vp::IoReq *req = _this->l2_write_reqs->pop();
+    vp::IoReq *req = _this->arbitration ?
+      _this->arbitrate(_this->l2_write_reqs, get_req_channel) : _this->l2_write_reqs->pop();
+    Udma_rx_channel *channel = (Udma_rx_channel *)get_req_channel(req);
     _this->trace.msg("Sending write request to L2 (value: 0x%x, addr: 0x%x, size: 0x%x)\n", *(uint32_t *)req->get_data(), req->get_addr(), req->get_size());
+    _this->nb_l2_writes++;
+    _this->nb_l2_write_bytes += req->get_size();
+    channel->account_l2_req(req->get_size(), cycles - *(int64_t *)req->arg_get(1));
+    _this->l2_write_ready_cycle = cycles + (req->get_size() + _this->l2_port_width - 1) / _this->l2_port_width;
     int err = _this->l2_itf.req(req);
     if (err == vp::IO_REQ_OK)
     {
+      channel->free_l2_write_req(req);
     }
     else
     {
@@ -706,15 +964,20 @@ void udma::event_handler(vp::Block *__this, vp::ClockEvent *event)
 
   }
 
-  if (!_this->ready_tx_channels->is_empty() && !_this->l2_read_reqs->is_empty())
+  if (!_this->ready_tx_channels->is_empty() && !_this->l2_read_reqs->is_empty() && _this->l2_read_ready_cycle <= cycles)
   {
     vp::IoReq *req = _this->l2_read_reqs->pop();
-    Udma_channel *channel = _this->ready_tx_channels->pop();
+    Udma_channel *channel = _this->arbitration ?
+      _this->arbitrate(_this->ready_tx_channels, get_channel) : _this->ready_tx_channels->pop();
     if (!channel->prepare_req(req))
     {
       _this->ready_tx_channels->push(channel);
     }
 
+    channel->account_l2_req(req->get_size(), cycles - channel->ready_cycle);
+    channel->ready_cycle = cycles;
+    _this->l2_read_ready_cycle = cycles + (req->get_size() + _this->l2_port_width - 1) / _this->l2_port_width;
+
     _this->trace.msg("Sending read request to L2 (addr: 0x%x, size: 0x%x)\n", req->get_addr(), req->get_size());
     int err = _this->l2_itf.req(req);
     if (err == vp::IO_REQ_OK)
@@ -753,16 +1016,33 @@ void udma::free_read_req(vp::IoReq *req)
 
 void udma::check_state()
 {
-  if ((!ready_tx_channels->is_empty() && !l2_read_reqs->is_empty()) || !l2_write_reqs->is_empty())
+  int64_t cycles = clock.get_cycles();
+  // The read, write and response paths share the same event, which must be enqueued for the
+  // earliest of their deadlines
+  int64_t latency = -1;
+
+  if (!ready_tx_channels->is_empty() && !l2_read_reqs->is_empty())
   {
-    //printf("Enqueue 1 cycles\n");
-    event_reenqueue_ext(event, 1);
+    latency = l2_read_ready_cycle > cycles ? l2_read_ready_cycle - cycles : 1;
+  }
+
+  if (!l2_write_reqs->is_empty())
+  {
+    int64_t write_latency = l2_write_ready_cycle > cycles ? l2_write_ready_cycle - cycles : 1;
+    if (latency == -1 || write_latency < latency)
+      latency = write_latency;
   }
 
   if (!l2_read_waiting_reqs->is_empty())
   {
-    //printf("Enqueue %ld cycles\n", l2_read_waiting_reqs->get_first()->get_latency() - clock.get_cycles());
-    event_reenqueue_ext(event, l2_read_waiting_reqs->get_first()->get_latency() - clock.get_cycles());
+    int64_t response_latency = l2_read_waiting_reqs->get_first()->get_latency() - cycles;
+    if (latency == -1 || response_latency < latency)
+      latency = response_latency;
+  }
+
+  if (latency != -1)
+  {
+    event_reenqueue_ext(event, latency);
   }
 }
 
@@ -868,11 +1148,35 @@ void udma::clk_reg(Component *__this, Component *clock)
   _this->periph_clock = (vp::ClockEngine *)clock;
 }
 
+void udma::stop()
+{
+  for (int i=0; i<nb_periphs; i++)
+  {
+    if (periphs[i] != NULL && periphs[i]->id == i)
+      periphs[i]->stop();
+  }
+
+  if (this->stats_trace.get_active())
+  {
+    this->stats_trace.msg(vp::Trace::LEVEL_INFO, "L2 writes: %" PRId64 ", bytes: %" PRId64 ", bytes per write: %.2f, pool allocations: %" PRId64 "\n",
+      this->nb_l2_writes, this->nb_l2_write_bytes,
+      this->nb_l2_writes ? (double)this->nb_l2_write_bytes / this->nb_l2_writes : 0.0,
+      this->nb_l2_write_allocs);
+
+    for (Udma_channel *channel: this->channels)
+    {
+      channel->dump_stats();
+    }
+  }
+}
+
 void udma::reset(bool active)
 {
   if (active)
   {
     clock_gating = 0;
+    l2_read_ready_cycle = 0;
+    l2_write_ready_cycle = 0;
   }
 
   for (int i=0; i<nb_periphs; i++)
@@ -887,6 +1191,32 @@ void udma::reset(bool active)
 
 
 
+template<class T>
+void Udma_queue<T>::remove(T *cmd)
+{
+  T *current = first, *prev = NULL;
+  while (current && current != cmd)
+  {
+    prev = current;
+    current = current->get_next();
+  }
+
+  if (current == NULL)
+    return;
+
+  if (prev)
+    prev->set_next(cmd->get_next());
+  else
+    first = cmd->get_next();
+
+  if (last == cmd)
+    last = prev;
+
+  nb_cmd--;
+}
+
+
+
 template<class T>
 void Udma_queue<T>::push_from_latency(T *cmd)
 {
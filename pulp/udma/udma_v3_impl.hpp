@@ -35,7 +35,9 @@
 #include <stdio.h>
 #include <string.h>
 #include <vector>
+#include <map>
 #include "archi/udma_v3.h"
+#include "udma_file_source.hpp"
 
 #ifdef HAS_HYPER
 #if HYPER_VERSION == 2
@@ -63,6 +65,7 @@ public:
   Udma_channel *channel;
 
   bool prepare_req(vp::IoReq *req);
+  bool append_req(vp::IoReq *req);
   void set_next(Udma_transfer *next) { this->next = next; }
   Udma_transfer *get_next() { return next; }
   Udma_transfer *next;
@@ -82,6 +85,7 @@ public:
   bool is_full() { return nb_cmd >= size; }
   bool is_empty() { return nb_cmd == 0; }
   T *get_first() { return first; }
+  void remove(T *cmd);
 
 private:
   T *first;    // First command of the queue, commands are popped from here
@@ -109,9 +113,20 @@ public:
   virtual void handle_ready_reqs();
   virtual void handle_transfer_end();
   void check_state();
+  std::string get_name() { return name; }
+  void account_l2_req(int size, int64_t delay);
+  void dump_stats();
 
   Udma_transfer *current_cmd;
 
+  // L2 arbitration. Channels with higher priority are always served first, channels with the
+  // same priority are served in weighted round-robin, up to weight requests per round.
+  int arb_priority;
+  int arb_weight;
+  int arb_credits;
+  // Cycle at which the channel became ready for its next L2 read
+  int64_t ready_cycle;
+
   void build_reqs_and_enqueue(Udma_transfer *current_req);
 
 protected:
@@ -142,6 +157,13 @@ private:
   Udma_queue<Udma_transfer> *pending_reqs;
 
   vp::Trace     state_event;
+
+  int64_t nb_l2_reqs;
+  int64_t nb_l2_bytes;
+  int64_t l2_first_cycle;
+  int64_t l2_last_cycle;
+  int64_t l2_delay_total;
+  int64_t l2_delay_max;
 };
 
 
@@ -149,15 +171,28 @@ private:
 class Udma_rx_channel : public Udma_channel
 {
 public:
-  Udma_rx_channel(udma *top, int id, string name) : Udma_channel(top, id, name) {}
+  Udma_rx_channel(udma *top, int id, string name);
   bool is_tx() { return false; }
   void reset(bool active);
   void push_data(uint8_t *data, int size);
   bool has_cmd() { return this->current_cmd != NULL; }
+  void free_l2_write_req(vp::IoReq *req);
 
 private:
+  vp::IoReq *alloc_l2_write_req();
+  void flush_l2_write_req();
+  static void handle_l2_write_flush(vp::Block *__this, vp::ClockEvent *event);
+
   int pending_byte_index;
   uint32_t pending_word;
+  // Pool of L2 write requests owned by this channel. They are given back once
+  // the L2 has accepted them so that no allocation is done while streaming.
+  Udma_queue<vp::IoReq> *l2_write_free_reqs;
+  // Request currently being filled with contiguous words, until it reaches
+  // the L2 port width or the end of the transfer
+  vp::IoReq *l2_write_pending_req;
+  // Flushes the pending request at the end of the cycle where it was started
+  vp::ClockEvent *l2_write_flush_event;
 };
 
 
@@ -214,6 +249,7 @@ public:
   Udma_periph(udma *top, int id);
   virtual vp::IoReqStatus req(vp::IoReq *req, uint64_t offset);
   virtual void reset(bool active);
+  virtual void stop() {}
   void clock_gate(bool is_on);
 
   int id;
@@ -295,6 +331,9 @@ private:
   void reset(bool active);
   void check_state();
   static void handle_pending_word(vp::Block *__this, vp::ClockEvent *event);
+  void handle_step(int64_t cycles);
+  bool has_pending_step();
+  bool step_ends_req();
 
   I2c_periph_v2 *periph;
 
@@ -324,6 +363,16 @@ typedef enum
 } i2c_periph_state_e;
 
 
+class I2c_slave_stats
+{
+public:
+  int64_t nb_transactions = 0;
+  int64_t nb_written_bytes = 0;
+  int64_t nb_read_bytes = 0;
+  int64_t cycles = 0;
+};
+
+
 class I2c_periph_v2 : public Udma_periph
 {
   friend class I2c_tx_channel;
@@ -333,6 +382,7 @@ public:
   I2c_periph_v2(udma *top, int id, int itf_id);
   vp::IoReqStatus custom_req(vp::IoReq *req, uint64_t offset);
   void reset(bool active);
+  void stop();
 
 protected:
   vp::I2cMaster i2c_itf;
@@ -348,13 +398,27 @@ protected:
   int pending_rx_bit;
   int prev_sda;
   int prev_scl;
+  // In transaction mode, a whole transaction is sent to the slave in one event
+  bool transaction_mode;
+
+  // Transaction currently on the bus, slave_addr is -1 when idle and -2 while waiting for the
+  // address byte
+  int slave_addr;
+  bool slave_is_read;
+  int slave_bytes;
+  int64_t slave_start_cycle;
+  std::map<int, I2c_slave_stats> slave_stats;
 
 private:
+  void transaction_start(int64_t cycles);
+  void transaction_byte(uint32_t value);
+  void transaction_end(int64_t cycles);
   vp::IoReqStatus status_req(vp::IoReq *req);
   vp::IoReqStatus setup_req(vp::IoReq *req);
   static void rx_sync(vp::Block *, int scl, int data);
 
   vp::Trace     trace;
+  vp::Trace     stats_trace;  // Per-slave totals, dumped by stop() when active
 };
 
 
@@ -367,6 +431,45 @@ private:
 
 class Uart_periph_v1;
 
+typedef enum
+{
+  UART_HOST_STDOUT,
+  UART_HOST_FILE,
+  UART_HOST_PTY,
+  UART_HOST_TCP
+} uart_host_type_e;
+
+/*
+ * Host endpoint used in byte mode, where the UART exchanges whole bytes with the host instead of
+ * driving the pins.
+ *
+ * Config (uart/backends/<itf>):
+ *   type:        "stdout" (reads from stdin), "file" (output only), "pty" or "tcp"
+ *   path:        output file for the file backend
+ *   port:        local port the tcp backend listens on
+ *   line_buffer: only write output once a full line is received
+ */
+class Uart_host_backend
+{
+public:
+  Uart_host_backend(vp::Trace *trace, js::Config *config, std::string name);
+  void write(uint8_t byte);
+  // Returns the next byte received from the host or -1 if there is none
+  int read();
+  void flush();
+
+private:
+  bool check_connection();
+
+  vp::Trace *trace;
+  uart_host_type_e type;
+  bool line_buffer;
+  std::string buffer;
+  int in_fd;
+  int out_fd;
+  int listen_fd;
+};
+
 typedef enum
 {
   UART_RX_STATE_WAIT_START,
@@ -381,10 +484,13 @@ public:
   Uart_rx_channel(udma *top, Uart_periph_v1 *periph, int id, string name);
   bool is_busy();
   void handle_rx_bit(int bit);
+  void handle_ready();
 
 private:
   void reset(bool active);
+  static void handle_host_byte(vp::Block *__this, vp::ClockEvent *event);
   Uart_periph_v1 *periph;
+  vp::ClockEvent *host_event;
   uart_rx_state_e state;
   int parity;
   int stop_bits;
@@ -412,6 +518,7 @@ private:
   void reset(bool active);
   void check_state();
   static void handle_pending_word(vp::Block *__this, vp::ClockEvent *event);
+  void send_byte();
 
   Uart_periph_v1 *periph;
 
@@ -437,6 +544,9 @@ public:
   Uart_periph_v1(udma *top, int id, int itf_id);
   vp::IoReqStatus custom_req(vp::IoReq *req, uint64_t offset);
   void reset(bool active);
+  void stop();
+  // Number of cycles taken by a full frame (start, data, parity and stop bits)
+  int64_t get_frame_cycles();
 
   int parity;
   int bit_length;
@@ -445,6 +555,8 @@ public:
   int rx;
   int clkdiv;
   int rx_pe;
+  // Set in byte mode, where bytes are exchanged with the host instead of the pins
+  Uart_host_backend *host;
 
 protected:
   vp::UartMaster uart_itf;
@@ -493,6 +605,7 @@ protected:
 private:
   static void sync(vp::Block *__this, int pclk, int href, int vsync, int data);
   static void sync_cycle(vp::Block *__this, int href, int vsync, int data);
+  static void stream_handler(vp::Block *__this, vp::ClockEvent *event);
   vp::IoReqStatus handle_global_access(bool is_write, uint32_t *data);
   vp::IoReqStatus handle_l1_access(bool is_write, uint32_t *data);
   vp::IoReqStatus handle_ur_access(bool is_write, uint32_t *data);
@@ -502,6 +615,15 @@ private:
 
   vp::Trace     trace;
 
+  // Optional file source replacing the pin-level camera model. Frames are pushed one line per
+  // event, at a rate of one byte every stream period.
+  Udma_file_source *stream;
+  vp::ClockEvent *stream_event;
+  int stream_width;
+  int stream_height;
+  int stream_line;
+  uint8_t *stream_line_buffer;
+
   int pending_byte;
   bool has_pending_byte;
   bool cmd_ready;
@@ -832,6 +954,10 @@ public:
   static void rx_sync(vp::Block *__this, int data);
   void reset(bool active);
   static void handle_pending_word(vp::Block *__this, vp::ClockEvent *event);
+  void handle_step();
+  void handle_burst();
+  int64_t get_burst_cycles(int size, int latency);
+  void load_pending_bytes();
   void check_state();
   void handle_ready_reqs();
 
@@ -906,6 +1032,10 @@ private:
   Hyper_transfer *current_command;
   int channel_id;
   int mem_sel;
+  // Transaction-level mode, each burst is handled in one go instead of one event per byte
+  bool burst_mode;
+  // Number of bytes transferred per HyperBus clock cycle in transaction-level mode
+  int ddr_width;
 
 };
 
@@ -944,6 +1074,7 @@ T *Udma_queue<T>::pop()
 class udma : public vp::Component
 {
   friend class Udma_periph;
+  friend class Udma_channel;
   friend class Udma_rx_channel;
 
 public:
@@ -958,6 +1089,7 @@ public:
   void free_read_req(vp::IoReq *req);
 
   void trigger_event(int event);
+  void stop();
 
   vp::Trace *get_trace() { return &this->trace; }
   vp::ClockEngine *get_periph_clock() { return this->periph_clock; }
@@ -969,6 +1101,8 @@ protected:
 private:
 
   void check_state();
+  bool arbiter_is_before(Udma_channel *a, Udma_channel *b);
+  template<class T> T *arbitrate(Udma_queue<T> *queue, Udma_channel *(*get_channel)(T *));
 
   vp::IoReqStatus conf_req(vp::IoReq *req, uint64_t offset);
   vp::IoReqStatus periph_req(vp::IoReq *req, uint64_t offset);
@@ -979,12 +1113,19 @@ private:
   static void clk_reg(Component *_this, Component *clock);
 
   vp::Trace     trace;
+  vp::Trace     stats_trace;  // End-of-simulation L2 counters, dumped by stop() when active
   vp::IoSlave in;
   vp::ClkSlave    periph_clock_itf;
   vp::ClockEngine *periph_clock;
   
   int nb_periphs;
   int l2_read_fifo_size;
+  int l2_write_fifo_size;
+  int l2_port_width;
+  // True as soon as one channel has a specific priority or weight, otherwise the requests are
+  // served in order of arrival
+  bool arbitration;
+  std::vector<Udma_channel *> channels;
   std::vector<Udma_periph *>periphs;
   Udma_queue<Udma_channel> *ready_rx_channels;
   Udma_queue<Udma_channel> *ready_tx_channels;
@@ -993,6 +1134,12 @@ private:
   Udma_queue<vp::IoReq> *l2_read_reqs;
   Udma_queue<vp::IoReq> *l2_write_reqs;
   Udma_queue<vp::IoReq> *l2_read_waiting_reqs;
+  int64_t l2_read_ready_cycle;
+  int64_t l2_write_ready_cycle;
+
+  int64_t nb_l2_writes;
+  int64_t nb_l2_write_bytes;
+  int64_t nb_l2_write_allocs;
   
   vp::WireMaster<int>    event_itf;
 };